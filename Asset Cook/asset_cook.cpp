@@ -0,0 +1,338 @@
+// asset_cook.cpp
+// Asset Cook: source PNG/JPG/TTF -> runtime formats (cooked_asset.h), incremental by content hash, parallel jobs
+// Usage: "Asset Cook.exe" <source dir> <output dir> [-j threads] [--force]
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+
+#include "../Hill Climb/cooked_asset.h"
+#include "../Hill Climb/mip_chain.h"
+#include "../Hill Climb/image_decode.h"
+#include "../Hill Climb/text_shaping.h"
+
+namespace fs = std::filesystem;
+
+// Bump when cooking code changes so every output is rebuilt
+const uint64_t COOKER_VERSION = 1;
+const char* const MANIFEST_NAME = "manifest.txt";
+// Offline, so use the sharper filter; colour textures are authored in sRGB
+const MipSettings TEXTURE_MIPS = { MIP_FILTER_KAISER, true };
+
+struct SourceFile {
+    std::string path;     // Relative to the source dir, '/' separated
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;
+    bool hashed;          // Hash came from this run rather than the manifest
+};
+
+enum CookKind { COOK_TEXTURE, COOK_FONT };
+
+struct CookJob {
+    CookKind kind;
+    std::vector<SourceFile*> inputs;
+    std::string output;   // Relative to the output dir
+    uint64_t key;         // Cooker version + kind + settings + input content hashes
+    bool ok;
+    double ms;
+};
+
+// ---------------- Hashing ----------------
+static uint64_t fnv1a(const void* data, size_t size, uint64_t h = 14695981039346656037ull) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static uint64_t hash_file(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> buffer(1 << 16);
+    uint64_t h = fnv1a(nullptr, 0);
+    while (in) {
+        in.read(buffer.data(), buffer.size());
+        h = fnv1a(buffer.data(), static_cast<size_t>(in.gcount()), h);
+    }
+    return h;
+}
+
+static uint64_t job_key(const CookJob& job) {
+    uint64_t values[3] = { COOKER_VERSION, COOKED_FORMAT_VERSION, static_cast<uint64_t>(job.kind) };
+    uint64_t h = fnv1a(values, sizeof(values));
+    int settings[3] = { TEXT_PIXEL_SIZE, static_cast<int>(TEXTURE_MIPS.filter), TEXTURE_MIPS.srgb ? 1 : 0 };
+    h = fnv1a(settings, sizeof(settings), h);
+    for (const SourceFile* in : job.inputs) {
+        h = fnv1a(in->path.data(), in->path.size(), h);
+        h = fnv1a(&in->hash, sizeof(in->hash), h);
+    }
+    return h;
+}
+
+// ---------------- Parallel for ----------------
+static void run_parallel(size_t count, int threads, const std::function<void(size_t)>& fn) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) fn(i);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads && static_cast<size_t>(t) < count; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+}
+
+// ---------------- Manifest ----------------
+// source <hash> <size> <mtime> <path>
+// output <key> <path>
+struct Manifest {
+    std::map<std::string, SourceFile> sources;
+    std::map<std::string, uint64_t> outputs;
+};
+
+static Manifest read_manifest(const fs::path& path) {
+    Manifest m;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string kind;
+        ss >> kind;
+        if (kind == "source") {
+            SourceFile s = {};
+            ss >> std::hex >> s.hash >> std::dec >> s.size >> s.mtime;
+            ss.get();
+            std::getline(ss, s.path);
+            m.sources[s.path] = s;
+        }
+        else if (kind == "output") {
+            uint64_t key;
+            std::string out;
+            ss >> std::hex >> key;
+            ss.get();
+            std::getline(ss, out);
+            m.outputs[out] = key;
+        }
+    }
+    return m;
+}
+
+static void write_manifest(const fs::path& path, const std::vector<SourceFile>& sources, const std::vector<CookJob>& jobs) {
+    std::ofstream out(path);
+    for (const SourceFile& s : sources) {
+        out << "source " << std::hex << s.hash << std::dec << " " << s.size << " " << s.mtime << " " << s.path << "\n";
+    }
+    for (const CookJob& job : jobs) {
+        if (job.ok) out << "output " << std::hex << job.key << std::dec << " " << job.output << "\n";
+    }
+}
+
+// ---------------- Cookers ----------------
+static bool cook_texture(const fs::path& sourceDir, const fs::path& outDir, CookJob& job) {
+    SourceFile& src = *job.inputs[0];
+    DecodedImage image;
+    if (!decode_image((sourceDir / src.path).string().c_str(), 4, true, image)) {
+        std::cout << "  " << src.path << ": could not decode" << std::endl;
+        return false;
+    }
+    CookedTexture texture;
+    build_mip_chain(texture, image.pixels.data(), image.width, image.height, TEXTURE_MIPS);
+    release_image(image);
+    return write_cooked_texture((outDir / job.output).string(), texture);
+}
+
+static bool cook_font(const fs::path& sourceDir, const fs::path& outDir, CookJob& job) {
+    // FreeType libraries aren't shared between threads, so each job has its own
+    FT_Library ft;
+    if (FT_Init_FreeType(&ft)) return false;
+    FT_Face face;
+    if (FT_New_Face(ft, (sourceDir / job.inputs[0]->path).string().c_str(), 0, &face)) {
+        FT_Done_FreeType(ft);
+        return false;
+    }
+    FT_Set_Pixel_Sizes(face, 0, TEXT_PIXEL_SIZE);
+
+    const int atlasWidth = 512;
+    CookedFont font;
+    font.pixelSize = TEXT_PIXEL_SIZE;
+    font.atlasWidth = atlasWidth;
+    std::vector<std::vector<unsigned char>> bitmaps;
+    int x = 0, y = 0, shelf = 0;
+    for (int c = 0; c < 128; ++c) {
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) continue;
+        const FT_Bitmap& bm = face->glyph->bitmap;
+        int w = static_cast<int>(bm.width), h = static_cast<int>(bm.rows);
+        if (x + w > atlasWidth) { x = 0; y += shelf + 1; shelf = 0; }
+
+        CookedGlyph g = { c, x, y, w, h, face->glyph->bitmap_left, face->glyph->bitmap_top,
+            static_cast<int32_t>(face->glyph->advance.x) };
+        font.glyphs.push_back(g);
+        std::vector<unsigned char> pixels(static_cast<size_t>(w) * h);
+        for (int row = 0; row < h; ++row) memcpy(&pixels[static_cast<size_t>(row) * w], bm.buffer + row * bm.pitch, w);
+        bitmaps.push_back(pixels);
+        x += w + 1;
+        shelf = std::max(shelf, h);
+    }
+    font.kerning = extract_kerning(face);
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+
+    font.atlasHeight = y + shelf;
+    font.atlas.assign(static_cast<size_t>(atlasWidth) * font.atlasHeight, 0);
+    for (size_t i = 0; i < font.glyphs.size(); ++i) {
+        const CookedGlyph& g = font.glyphs[i];
+        for (int row = 0; row < g.height; ++row) {
+            memcpy(&font.atlas[static_cast<size_t>(g.y + row) * atlasWidth + g.x], &bitmaps[i][static_cast<size_t>(row) * g.width], g.width);
+        }
+    }
+    return write_cooked_font((outDir / job.output).string(), font);
+}
+
+// ---------------- Main ----------------
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "Usage: asset_cook <source dir> <output dir> [-j threads] [--force]" << std::endl;
+        return 1;
+    }
+    fs::path sourceDir = argv[1];
+    fs::path outDir = argv[2];
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    bool force = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (arg == "--force") force = true;
+    }
+    if (threads < 1) threads = 1;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    fs::create_directories(outDir);
+    Manifest manifest = read_manifest(outDir / MANIFEST_NAME);
+
+    // Scan sources; files whose size and mtime match the manifest keep their recorded hash
+    std::vector<SourceFile> sources;
+    for (const fs::directory_entry& e : fs::recursive_directory_iterator(sourceDir)) {
+        if (!e.is_regular_file()) continue;
+        std::string ext = e.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext != ".png" && ext != ".jpg" && ext != ".jpeg" && ext != ".ttf") continue;
+        fs::path rel = fs::relative(e.path(), sourceDir);
+        if (*rel.begin() == outDir.filename()) continue; // Never cook our own output
+
+        SourceFile s = {};
+        s.path = rel.generic_string();
+        s.size = e.file_size();
+        s.mtime = static_cast<int64_t>(e.last_write_time().time_since_epoch().count());
+        auto known = manifest.sources.find(s.path);
+        if (!force && known != manifest.sources.end() && known->second.size == s.size && known->second.mtime == s.mtime) {
+            s.hash = known->second.hash;
+        }
+        else {
+            s.hashed = true;
+        }
+        sources.push_back(s);
+    }
+    run_parallel(sources.size(), threads, [&](size_t i) {
+        if (sources[i].hashed) sources[i].hash = hash_file(sourceDir / sources[i].path);
+    });
+
+    // One job per output
+    // Two jobs on one output would race on its temp file and overwrite each other's manifest entry.
+    // Names keep the source path, so only names differing in case (one file on Windows) can clash.
+    std::vector<CookJob> jobs;
+    std::map<std::string, const SourceFile*> claimed;
+    int duplicates = 0;
+    for (SourceFile& s : sources) {
+        std::string ext = fs::path(s.path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        bool font = ext == ".ttf";
+        CookJob job = { font ? COOK_FONT : COOK_TEXTURE, { &s }, cooked_name(s.path, font ? ".font" : ".tex"), 0, false, 0.0 };
+        std::string folded = job.output;
+        std::transform(folded.begin(), folded.end(), folded.begin(), ::tolower);
+        auto owner = claimed.emplace(folded, &s);
+        if (!owner.second) {
+            std::cout << "  " << s.path << ": skipped, output " << job.output << " clashes with " << owner.first->second->path << std::endl;
+            duplicates++;
+            continue;
+        }
+        jobs.push_back(job);
+    }
+
+    // Dirty = key changed or output missing
+    std::vector<size_t> dirty;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        CookJob& job = jobs[i];
+        job.key = job_key(job);
+        auto known = manifest.outputs.find(job.output);
+        job.ok = !force && known != manifest.outputs.end() && known->second == job.key && fs::exists(outDir / job.output);
+        if (!job.ok) {
+            dirty.push_back(i);
+            continue;
+        }
+        // Same content but a newer source time (touched, checked out again): move the output's time
+        // past it, or the game's cooked_is_current would keep decoding the source instead
+        std::error_code error;
+        fs::file_time_type outputTime = fs::last_write_time(outDir / job.output, error);
+        for (const SourceFile* in : job.inputs) {
+            fs::file_time_type sourceTime = fs::last_write_time(sourceDir / in->path, error);
+            if (!error && sourceTime > outputTime) {
+                fs::last_write_time(outDir / job.output, sourceTime, error);
+                outputTime = sourceTime;
+            }
+        }
+    }
+
+    run_parallel(dirty.size(), threads, [&](size_t d) {
+        CookJob& job = jobs[dirty[d]];
+        auto start = std::chrono::high_resolution_clock::now();
+        fs::create_directories((outDir / job.output).parent_path());
+        switch (job.kind) {
+        case COOK_TEXTURE: job.ok = cook_texture(sourceDir, outDir, job); break;
+        case COOK_FONT: job.ok = cook_font(sourceDir, outDir, job); break;
+        }
+        job.ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    });
+
+    // Outputs from sources that no longer exist
+    std::set<std::string> live;
+    for (const CookJob& job : jobs) live.insert(job.output);
+    int removed = 0;
+    for (const auto& out : manifest.outputs) {
+        if (!live.count(out.first) && fs::remove(outDir / out.first)) removed++;
+    }
+
+    write_manifest(outDir / MANIFEST_NAME, sources, jobs);
+
+    int failed = 0;
+    int hashedCount = 0;
+    for (const SourceFile& s : sources) hashedCount += s.hashed ? 1 : 0;
+    for (size_t i : dirty) {
+        const CookJob& job = jobs[i];
+        std::cout << "  " << (job.ok ? "cooked " : "FAILED ") << job.output << " (" << job.ms << " ms)" << std::endl;
+        failed += job.ok ? 0 : 1;
+    }
+    double total = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t0).count();
+    std::cout << "Asset cook: " << jobs.size() << " outputs, " << dirty.size() - failed << " cooked, "
+        << jobs.size() - dirty.size() << " up to date, " << failed << " failed, " << duplicates << " duplicates, "
+        << removed << " removed; " << hashedCount << "/" << sources.size() << " sources hashed, " << threads << " threads, "
+        << total << " ms" << std::endl;
+    return failed == 0 && duplicates == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// archetypes.h
+// Compile-time entity archetypes: body, shape, render extents and collision filter from one table
+
+#pragma once
+
+#include <box2d/box2d.h>
+#include "entity.h"
+#include "collision_layers.h"
+#include "body_spawner.h"
+
+struct ArchetypeDesc {
+    EntityType type;
+    b2BodyType bodyType;
+    float halfW, halfH;   // Used for the box shape and for rendering
+    float density;
+    float friction;
+    bool contactEvents;
+    bool fixedRotation;
+    bool bullet;          // Continuous collision against dynamic bodies
+};
+
+// Only specialized types can be spawned; anything else fails to compile
+template <EntityType T> struct Archetype;
+
+template <> struct Archetype<ENTITY_PLAYER> {
+    static constexpr ArchetypeDesc desc = { ENTITY_PLAYER, b2_dynamicBody, 1.0f, 1.0f, 1.0f, 0.3f, true, false, false };
+};
+template <> struct Archetype<ENTITY_BOX> {
+    static constexpr ArchetypeDesc desc = { ENTITY_BOX, b2_dynamicBody, 0.5f, 0.5f, 1.0f, 0.3f, true, false, false };
+};
+template <> struct Archetype<ENTITY_GROUND> {
+    static constexpr ArchetypeDesc desc = { ENTITY_GROUND, b2_staticBody, 50.0f, 0.1f, 1.0f, 0.6f, true, false, false };
+};
+template <> struct Archetype<ENTITY_BULLET> {
+    static constexpr ArchetypeDesc desc = { ENTITY_BULLET, b2_dynamicBody, 0.1f, 0.1f, 4.0f, 0.1f, true, false, true };
+};
+template <> struct Archetype<ENTITY_ENEMY> {
+    static constexpr ArchetypeDesc desc = { ENTITY_ENEMY, b2_dynamicBody, 0.5f, 0.5f, 1.0f, 0.3f, true, true, false };
+};
+
+template <EntityType T>
+constexpr b2Filter archetype_filter() {
+    static_assert(g_collisionLayers[T].type == T, "collision layer table is out of EntityType order");
+    return { g_collisionLayers[T].category, g_collisionLayers[T].mask, 0 };
+}
+
+// Prototype for spawn_bodies; userData gets the archetype's type and render extents
+template <EntityType T>
+BodyArchetype make_archetype(const UserData& userData) {
+    constexpr ArchetypeDesc desc = Archetype<T>::desc;
+    BodyArchetype archetype = make_box_archetype(T, desc.bodyType, desc.halfW, desc.halfH, desc.density, desc.friction, userData);
+    archetype.bodyDef.fixedRotation = desc.fixedRotation;
+    archetype.bodyDef.isBullet = desc.bullet;
+    archetype.shapes[0].def.enableContactEvents = desc.contactEvents;
+    archetype.shapes[0].def.filter = archetype_filter<T>();
+    archetype.userData.halfW = desc.halfW;
+    archetype.userData.halfH = desc.halfH;
+    return archetype;
+}
+
+// Single body with caller-owned user data (filled in like make_archetype does)
+template <EntityType T>
+b2BodyId spawn_archetype(b2WorldId world, b2Vec2 position, UserData* userData) {
+    BodyArchetype archetype = make_archetype<T>(*userData);
+    *userData = archetype.userData;
+
+    b2BodyDef bodyDef = archetype.bodyDef;
+    bodyDef.position = position;
+    bodyDef.userData = userData;
+    b2BodyId body = b2CreateBody(world, &bodyDef);
+    b2CreatePolygonShape(body, &archetype.shapes[0].def, &archetype.shapes[0].polygon);
+    return body;
+}
+
+// ---------------- Render Instances ----------------
+// Per-instance vertex data of an archetype batch (see draw_archetype_batch). The extents are the
+// same for every instance, so they go in a uniform; fixed-rotation archetypes drop the angle.
+template <bool FixedRotation> struct ArchetypeInstanceLayout { float x, y, angle; };
+template <> struct ArchetypeInstanceLayout<true> { float x, y; };
+
+template <EntityType T>
+using ArchetypeInstance = ArchetypeInstanceLayout<Archetype<T>::desc.fixedRotation>;
+
+// Size of the instance vertex attribute; a missing angle reads as 0 in the shader
+template <EntityType T>
+constexpr int archetype_instance_components() {
+    return static_cast<int>(sizeof(ArchetypeInstance<T>) / sizeof(float));
+}
+
+template <EntityType T>
+ArchetypeInstance<T> make_archetype_instance(b2BodyId body) {
+    b2Vec2 pos = b2Body_GetPosition(body);
+    if constexpr (Archetype<T>::desc.fixedRotation) return { pos.x, pos.y };
+    else return { pos.x, pos.y, b2Rot_GetAngle(b2Body_GetRotation(body)) };
+}
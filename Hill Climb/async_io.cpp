@@ -0,0 +1,526 @@
+// async_io.cpp
+// Batched asynchronous file reads (io_uring on Linux, I/O threads elsewhere) into pooled aligned buffers, handed to decode jobs
+
+#include "async_io.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+#include "profiler.h"
+#include "cooked_asset.h"
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// ---------------- Buffers ----------------
+const int IO_BUFFER_CLASSES = 40;           // Powers of two from IO_BUFFER_ALIGNMENT
+const size_t IO_BUFFERS_KEPT_PER_CLASS = 8;
+
+static std::mutex g_bufferMutex;
+static std::vector<unsigned char*> g_freeBuffers[IO_BUFFER_CLASSES];
+
+static int buffer_class(size_t size, size_t& capacity) {
+    capacity = IO_BUFFER_ALIGNMENT;
+    int sizeClass = 0;
+    while (capacity < size) {
+        capacity <<= 1;
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+IoBuffer io_buffer_acquire(size_t size) {
+    IoBuffer buffer;
+    int sizeClass = buffer_class(size, buffer.capacity);
+    {
+        std::lock_guard<std::mutex> lock(g_bufferMutex);
+        if (sizeClass < IO_BUFFER_CLASSES && !g_freeBuffers[sizeClass].empty()) {
+            buffer.data = g_freeBuffers[sizeClass].back();
+            g_freeBuffers[sizeClass].pop_back();
+        }
+    }
+    if (!buffer.data) {
+#ifdef _WIN32
+        buffer.data = static_cast<unsigned char*>(_aligned_malloc(buffer.capacity, IO_BUFFER_ALIGNMENT));
+#else
+        buffer.data = static_cast<unsigned char*>(std::aligned_alloc(IO_BUFFER_ALIGNMENT, buffer.capacity));
+#endif
+    }
+    buffer.size = 0;
+    return buffer;
+}
+
+static void free_buffer_memory(unsigned char* data) {
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    std::free(data);
+#endif
+}
+
+void io_buffer_release(IoBuffer& buffer) {
+    if (!buffer.data) return;
+    size_t capacity;
+    int sizeClass = buffer_class(buffer.capacity, capacity);
+    bool kept = false;
+    {
+        std::lock_guard<std::mutex> lock(g_bufferMutex);
+        if (sizeClass < IO_BUFFER_CLASSES && g_freeBuffers[sizeClass].size() < IO_BUFFERS_KEPT_PER_CLASS) {
+            g_freeBuffers[sizeClass].push_back(buffer.data);
+            kept = true;
+        }
+    }
+    if (!kept) free_buffer_memory(buffer.data);
+    buffer = IoBuffer();
+}
+
+// ---------------- Queue ----------------
+struct PendingRead {
+    IoBatch* batch;
+    IoRequest* request;
+};
+
+static AsyncIoBackend g_ioBackend = ASYNC_IO_THREADS;
+static bool g_ioRunning = false;
+static std::mutex g_ioMutex;
+static std::condition_variable g_ioAvailable;
+static std::deque<PendingRead> g_ioPending;
+static bool g_ioQuit = false;
+static std::vector<std::thread> g_ioThreads;
+static void (*g_ioThreadStart)() = nullptr;
+
+static AsyncIoStats g_ioStats;
+static int g_ioInFlight = 0;
+static double g_ioLastChangeUs = 0.0;
+
+// Integrates the queue depth up to now, then applies delta; called with g_ioMutex held
+static void track_in_flight(int delta) {
+    double now = profiler_now_us();
+    if (g_ioInFlight > 0) {
+        g_ioStats.depthTimeUs += g_ioInFlight * (now - g_ioLastChangeUs);
+        g_ioStats.busyUs += now - g_ioLastChangeUs;
+    }
+    g_ioLastChangeUs = now;
+    g_ioInFlight += delta;
+    g_ioStats.maxQueueDepth = std::max(g_ioStats.maxQueueDepth, g_ioInFlight);
+}
+
+static void complete_read(const PendingRead& read, bool ok, bool missing = false) {
+    IoRequest& request = *read.request;
+    request.ok = ok;
+    request.missing = !ok && missing;
+    request.completeUs = profiler_now_us();
+    if (!ok) io_buffer_release(request.buffer);
+    {
+        std::lock_guard<std::mutex> lock(g_ioMutex);
+        track_in_flight(-1);
+        g_ioStats.requests++;
+        if (ok) g_ioStats.bytes += static_cast<long long>(request.buffer.size);
+        else if (request.missing) g_ioStats.missing++;
+        else g_ioStats.failures++;
+    }
+    // The decode job is counted before the read is released, so async_io_wait can't miss it
+    IoBatch* batch = read.batch;
+    if (batch->onRead) job_run(batch->jobs, [batch, &request] { batch->onRead(request); });
+    batch->reads.pending.fetch_sub(1, std::memory_order_release);
+}
+
+// ---------------- Thread Backend ----------------
+static bool read_file_blocking(const char* path, IoBuffer& buffer, bool& missing) {
+    FILE* f = fopen(path, "rb");
+    missing = !f && errno == ENOENT;
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool ok = size > 0;
+    if (ok) {
+        buffer = io_buffer_acquire(static_cast<size_t>(size));
+        buffer.size = fread(buffer.data, 1, static_cast<size_t>(size), f);
+        ok = buffer.size == static_cast<size_t>(size);
+    }
+    fclose(f);
+    return ok;
+}
+
+static void io_thread_main() {
+    if (g_ioThreadStart) g_ioThreadStart();
+    for (;;) {
+        PendingRead read;
+        {
+            std::unique_lock<std::mutex> lock(g_ioMutex);
+            g_ioAvailable.wait(lock, [] { return g_ioQuit || !g_ioPending.empty(); });
+            if (g_ioPending.empty()) return;
+            read = g_ioPending.front();
+            g_ioPending.pop_front();
+            track_in_flight(1);
+        }
+        bool missing = false;
+        bool ok = read_file_blocking(read.request->path.c_str(), read.request->buffer, missing);
+        complete_read(read, ok, missing);
+    }
+}
+
+// ---------------- io_uring Backend ----------------
+#ifdef __linux__
+// The raw ring (no liburing): submission and completion rings shared with the kernel
+struct Uring {
+    int fd = -1;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned* sqArray;
+    io_uring_sqe* sqes;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    io_uring_cqe* cqes;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+};
+
+// A read in the ring; short reads are resubmitted from offset
+struct UringSlot {
+    PendingRead read;
+    int fd;
+    size_t offset;
+    size_t size;
+    iovec iov;
+    bool used;
+};
+
+static Uring g_uring;
+
+static bool uring_setup(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) return false;
+
+    Uring& r = g_uring;
+    r.fd = fd;
+    r.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    r.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) r.sqRingSize = r.cqRingSize = std::max(r.sqRingSize, r.cqRingSize);
+
+    r.sqRing = mmap(nullptr, r.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    r.cqRing = singleMmap ? r.sqRing : mmap(nullptr, r.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    r.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, r.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (r.sqRing == MAP_FAILED || r.cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+        close(fd);
+        r.fd = -1;
+        return false;
+    }
+
+    char* sq = static_cast<char*>(r.sqRing);
+    char* cq = static_cast<char*>(r.cqRing);
+    r.sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    r.sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    r.sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    r.sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    r.sqes = static_cast<io_uring_sqe*>(sqes);
+    r.cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    r.cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    r.cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    r.cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+static void uring_teardown() {
+    Uring& r = g_uring;
+    if (r.fd < 0) return;
+    munmap(r.sqes, r.sqesSize);
+    if (r.cqRing != r.sqRing) munmap(r.cqRing, r.cqRingSize);
+    munmap(r.sqRing, r.sqRingSize);
+    close(r.fd);
+    r = Uring();
+}
+
+// Only the I/O thread touches the rings, so the tail is ours; the kernel reads it after the release store
+static void uring_queue_read(UringSlot& slot) {
+    Uring& r = g_uring;
+    unsigned tail = *r.sqTail;
+    unsigned index = tail & r.sqMask;
+    io_uring_sqe& sqe = r.sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    slot.iov.iov_base = slot.read.request->buffer.data + slot.offset;
+    slot.iov.iov_len = slot.size - slot.offset;
+    sqe.opcode = IORING_OP_READV;
+    sqe.fd = slot.fd;
+    sqe.addr = reinterpret_cast<uint64_t>(&slot.iov);
+    sqe.len = 1;
+    sqe.off = slot.offset;
+    sqe.user_data = reinterpret_cast<uint64_t>(&slot);
+    r.sqArray[index] = index;
+    __atomic_store_n(r.sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static void uring_finish(UringSlot& slot, bool ok) {
+    close(slot.fd);
+    slot.used = false;
+    complete_read(slot.read, ok);
+}
+
+static void uring_thread_main() {
+    if (g_ioThreadStart) g_ioThreadStart();
+    std::vector<UringSlot> slots(ASYNC_IO_QUEUE_DEPTH);
+    for (UringSlot& slot : slots) slot.used = false;
+    int inFlight = 0;
+    unsigned toSubmit = 0;
+    std::vector<PendingRead> taken;
+
+    for (;;) {
+        // Wait for work only when the ring is idle; otherwise new reads join after the next completion
+        taken.clear();
+        {
+            std::unique_lock<std::mutex> lock(g_ioMutex);
+            if (inFlight == 0) g_ioAvailable.wait(lock, [] { return g_ioQuit || !g_ioPending.empty(); });
+            if (inFlight == 0 && g_ioPending.empty()) return;
+            while (!g_ioPending.empty() && inFlight + static_cast<int>(taken.size()) < ASYNC_IO_QUEUE_DEPTH) {
+                taken.push_back(g_ioPending.front());
+                g_ioPending.pop_front();
+                track_in_flight(1);
+            }
+        }
+
+        for (const PendingRead& read : taken) {
+            IoRequest& request = *read.request;
+            int fd = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+            bool missing = fd < 0 && errno == ENOENT;
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0) {
+                if (fd >= 0) close(fd);
+                complete_read(read, false, missing);
+                continue;
+            }
+            UringSlot* slot = &*std::find_if(slots.begin(), slots.end(), [](const UringSlot& s) { return !s.used; });
+            request.buffer = io_buffer_acquire(static_cast<size_t>(st.st_size));
+            request.buffer.size = static_cast<size_t>(st.st_size);
+            *slot = { read, fd, 0, static_cast<size_t>(st.st_size), {}, true };
+            uring_queue_read(*slot);
+            toSubmit++;
+            inFlight++;
+        }
+        if (inFlight == 0) continue;
+
+        int submitted = static_cast<int>(syscall(__NR_io_uring_enter, g_uring.fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+            // The ring is unusable: fail what's in it rather than hang the waiters
+            std::cout << "io_uring_enter failed (" << strerror(errno) << ")" << std::endl;
+            for (UringSlot& slot : slots) {
+                if (slot.used) uring_finish(slot, false);
+            }
+            inFlight = 0;
+            toSubmit = 0;
+            continue;
+        }
+        toSubmit -= std::min(toSubmit, static_cast<unsigned>(submitted));
+
+        unsigned head = *g_uring.cqHead;
+        unsigned tail = __atomic_load_n(g_uring.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = g_uring.cqes[head & g_uring.cqMask];
+            UringSlot& slot = *reinterpret_cast<UringSlot*>(cqe.user_data);
+            if (cqe.res > 0) slot.offset += static_cast<size_t>(cqe.res);
+            if (cqe.res > 0 && slot.offset < slot.size) {
+                uring_queue_read(slot); // Short read: the rest goes in with the next submit
+                toSubmit++;
+                continue;
+            }
+            uring_finish(slot, cqe.res >= 0 && slot.offset == slot.size);
+            inFlight--;
+        }
+        __atomic_store_n(g_uring.cqHead, head, __ATOMIC_RELEASE);
+    }
+}
+#endif
+
+// ---------------- API ----------------
+void async_io_init(AsyncIoBackend preferred) {
+    if (g_ioRunning) return;
+    g_ioQuit = false;
+    g_ioBackend = ASYNC_IO_THREADS;
+#ifdef __linux__
+    if (preferred == ASYNC_IO_URING && uring_setup(ASYNC_IO_QUEUE_DEPTH)) {
+        g_ioBackend = ASYNC_IO_URING;
+        g_ioThreads.emplace_back(uring_thread_main);
+    }
+#else
+    (void)preferred;
+#endif
+    if (g_ioBackend == ASYNC_IO_THREADS) {
+        for (int i = 0; i < ASYNC_IO_THREAD_COUNT; ++i) g_ioThreads.emplace_back(io_thread_main);
+    }
+    g_ioRunning = true;
+}
+
+void async_io_set_thread_start(void (*onStart)()) {
+    g_ioThreadStart = onStart;
+}
+
+void async_io_shutdown() {
+    if (!g_ioRunning) return;
+    {
+        std::lock_guard<std::mutex> lock(g_ioMutex);
+        g_ioQuit = true;
+    }
+    g_ioAvailable.notify_all();
+    for (std::thread& t : g_ioThreads) t.join();
+    g_ioThreads.clear();
+#ifdef __linux__
+    uring_teardown();
+#endif
+    g_ioRunning = false;
+}
+
+AsyncIoBackend async_io_backend() {
+    return g_ioBackend;
+}
+
+const char* async_io_backend_name() {
+    return g_ioBackend == ASYNC_IO_URING ? "io_uring" : "threads";
+}
+
+void async_io_add(IoBatch& batch, const std::string& path) {
+    IoRequest request;
+    request.path = path;
+    batch.requests.push_back(request);
+}
+
+void async_io_submit(IoBatch& batch) {
+    if (!g_ioRunning) async_io_init();
+    double now = profiler_now_us();
+    {
+        std::lock_guard<std::mutex> lock(g_ioMutex);
+        for (IoRequest& request : batch.requests) {
+            request.submitUs = now;
+            batch.reads.pending.fetch_add(1, std::memory_order_relaxed);
+            g_ioPending.push_back({ &batch, &request });
+        }
+    }
+    g_ioAvailable.notify_all();
+}
+
+void async_io_wait(IoBatch& batch) {
+    job_wait(batch.reads);
+    job_wait(batch.jobs);
+}
+
+bool async_io_read_file(const char* path, IoBuffer& buffer) {
+    IoBatch batch;
+    async_io_add(batch, path);
+    async_io_submit(batch);
+    async_io_wait(batch);
+    buffer = batch.requests[0].buffer;
+    return batch.requests[0].ok;
+}
+
+const AsyncIoStats& async_io_stats() {
+    return g_ioStats;
+}
+
+void print_async_io_stats() {
+    AsyncIoStats s;
+    {
+        std::lock_guard<std::mutex> lock(g_ioMutex);
+        s = g_ioStats;
+    }
+    double busyS = s.busyUs / 1e6;
+    std::cout << "Async I/O (" << async_io_backend_name() << "): " << s.requests << " reads, " << s.failures << " failed, " << s.missing << " not found, "
+        << s.bytes / 1024 << " KB, " << (busyS > 0.0 ? s.bytes / 1e6 / busyS : 0.0) << " MB/s while busy, queue depth "
+        << (s.busyUs > 0.0 ? s.depthTimeUs / s.busyUs : 0.0) << " avg / " << s.maxQueueDepth << " peak" << std::endl;
+}
+
+// ---------------- Benchmark ----------------
+void bench_async_io(int rounds) {
+    // The sources and what Asset Cook makes of them
+    const char* sources[] = { "box.png", "enemy2.png", "explosion.png", "player.jpg", "arial.ttf", "PressStart2P.ttf" };
+    std::vector<std::string> assets(std::begin(sources), std::end(sources));
+    for (const char* source : sources) {
+        bool font = strstr(source, ".ttf") != nullptr;
+        assets.push_back(cooked_path(source, font ? ".font" : ".tex"));
+    }
+    std::vector<std::string> files;
+    for (const std::string& path : assets) {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) continue;
+        fclose(f);
+        files.push_back(path);
+    }
+    if (files.empty()) {
+        std::cout << "Async I/O: no asset files found (run from the asset directory)" << std::endl;
+        return;
+    }
+
+    auto report = [&](const char* name, double us, long long bytes) {
+        std::cout << "  " << name << ": " << us / rounds / 1000.0 << " ms per " << files.size() << " files, "
+            << bytes / 1e6 / (us / 1e6) << " MB/s" << std::endl;
+    };
+    std::cout << "Async I/O: " << files.size() << " asset files x " << rounds << " rounds" << std::endl;
+
+    // Baseline: what the loaders did before, one blocking read after another
+    long long bytes = 0;
+    double t0 = profiler_now_us();
+    for (int r = 0; r < rounds; ++r) {
+        for (const std::string& path : files) {
+            IoBuffer buffer;
+            bool missing = false;
+            if (read_file_blocking(path.c_str(), buffer, missing)) bytes += static_cast<long long>(buffer.size);
+            io_buffer_release(buffer);
+        }
+    }
+    report("sequential fread ", profiler_now_us() - t0, bytes);
+
+    bool ownedRunning = g_ioRunning;
+    AsyncIoBackend owned = g_ioBackend;
+    for (AsyncIoBackend backend : { ASYNC_IO_URING, ASYNC_IO_THREADS }) {
+        async_io_shutdown();
+        g_ioStats = AsyncIoStats();
+        async_io_init(backend);
+        if (g_ioBackend != backend) {
+            std::cout << "  io_uring unavailable here" << std::endl;
+            continue;
+        }
+        std::atomic<long long> batchBytes{ 0 };
+        t0 = profiler_now_us();
+        for (int r = 0; r < rounds; ++r) {
+            IoBatch batch;
+            for (const std::string& path : files) async_io_add(batch, path);
+            batch.onRead = [&batchBytes](IoRequest& request) {
+                if (request.ok) batchBytes += static_cast<long long>(request.buffer.size);
+                io_buffer_release(request.buffer);
+            };
+            async_io_submit(batch);
+            async_io_wait(batch);
+        }
+        report(backend == ASYNC_IO_URING ? "io_uring batch   " : "I/O thread batch ", profiler_now_us() - t0, batchBytes.load());
+        std::cout << "    ";
+        print_async_io_stats();
+    }
+    async_io_shutdown();
+    if (ownedRunning) async_io_init(owned);
+}
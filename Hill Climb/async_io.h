@@ -0,0 +1,81 @@
+// async_io.h
+// Batched asynchronous file reads (io_uring on Linux, I/O threads elsewhere) into pooled aligned buffers, handed to decode jobs
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "job_system.h"
+
+enum AsyncIoBackend {
+    ASYNC_IO_URING,     // One ring, reads submitted in batches up to the queue depth
+    ASYNC_IO_THREADS    // Blocking reads on dedicated I/O threads (Windows, or where io_uring is refused)
+};
+
+const size_t IO_BUFFER_ALIGNMENT = 4096;   // Page/sector aligned, so the buffers also suit O_DIRECT reads
+const int ASYNC_IO_QUEUE_DEPTH = 32;
+const int ASYNC_IO_THREAD_COUNT = 4;
+
+// Capacity is a power of two of at least IO_BUFFER_ALIGNMENT; size is the bytes read
+struct IoBuffer {
+    unsigned char* data = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+};
+
+struct IoRequest {
+    std::string path;
+    IoBuffer buffer;
+    bool ok = false;            // Whole file read
+    bool missing = false;       // Not ok because the file doesn't exist (e.g. an asset that isn't cooked)
+    double submitUs = 0.0;      // Profiler clock
+    double completeUs = 0.0;
+};
+
+// Reads of one batch, completed in any order. onRead runs on a job worker for each request
+// (that's where decoding goes); the buffer is the callback's to keep or release.
+struct IoBatch {
+    std::vector<IoRequest> requests;
+    std::function<void(IoRequest& request)> onRead;
+    JobCounter reads;           // Outstanding reads
+    JobCounter jobs;            // Outstanding onRead jobs
+};
+
+struct AsyncIoStats {
+    long long requests = 0;
+    long long failures = 0;     // Files that exist but couldn't be read
+    long long missing = 0;      // Files that don't exist; expected for optional reads like cooked copies
+    long long bytes = 0;
+    int maxQueueDepth = 0;
+    double depthTimeUs = 0.0;   // In-flight reads integrated over time, for the average depth
+    double busyUs = 0.0;        // Time with at least one read in flight
+};
+
+// Falls back to the threads if the ring can't be set up (old kernel, seccomp, not Linux)
+void async_io_init(AsyncIoBackend preferred = ASYNC_IO_URING);
+void async_io_shutdown();
+// Runs at the start of every I/O thread (affinity, priority); set before async_io_init
+void async_io_set_thread_start(void (*onStart)());
+AsyncIoBackend async_io_backend();
+const char* async_io_backend_name();
+
+void async_io_add(IoBatch& batch, const std::string& path);
+// Queues every read of the batch; returns immediately
+void async_io_submit(IoBatch& batch);
+// Until every read has completed and every onRead job has returned; runs jobs meanwhile
+void async_io_wait(IoBatch& batch);
+// Whole file, blocking: a batch of one
+bool async_io_read_file(const char* path, IoBuffer& buffer);
+
+IoBuffer io_buffer_acquire(size_t size);
+void io_buffer_release(IoBuffer& buffer);
+
+const AsyncIoStats& async_io_stats();
+// Requests, throughput while busy and queue depth (average and peak) since init
+void print_async_io_stats();
+
+// The game's asset files read one at a time with fread vs batched through each backend (headless)
+void bench_async_io(int rounds);
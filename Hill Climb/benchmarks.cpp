@@ -0,0 +1,68 @@
+// benchmarks.cpp
+// Headless benchmarks, run with: "Hill Climb.exe" --bench <name> [count]
+
+#include "benchmarks.h"
+
+#include <iostream>
+#include <cstring>
+
+#include "character_controller.h"
+#include "body_spawner.h"
+#include "terrain.h"
+#include "enemy_ai.h"
+#include "nav_graph.h"
+#include "spatial_grid.h"
+#include "coins.h"
+#include "page_memory.h"
+#include "mip_chain.h"
+#include "image_decode.h"
+#include "text_shaping.h"
+#include "profiler.h"
+#include "quality.h"
+#include "thread_config.h"
+#include "system_scheduler.h"
+#include "async_io.h"
+#include "ui_layer.h"
+
+struct Benchmark {
+    const char* name;
+    int defaultCount;
+    void (*run)(int count);
+};
+
+static const Benchmark g_benchmarks[] = {
+    { "controllers", 500, [](int count) { bench_character_controllers(count, 600); } },
+    { "spawn", 100000, [](int count) { bench_spawn_bodies(count); } },
+    { "terrain", 1000000, [](int count) { bench_terrain(count); } },
+    { "ai", 100, [](int count) { bench_enemy_ai(count); } },
+    { "nav", 10000, [](int count) { bench_nav_graph(count); } },
+    { "grid", 100000, [](int count) { bench_spatial_grid(count); } },
+    { "coins", 5000, [](int count) { bench_coins(count); } },
+    { "memory", 256, [](int count) { bench_page_memory(count); } },
+    { "mips", 2048, [](int count) { bench_mip_chain(count); } },
+    { "decode", 20, [](int count) { bench_image_decode(count); } },
+    { "shaping", 10000, [](int count) { bench_text_shaping(count); } },
+    { "profiler", 10000, [](int count) { bench_profiler(count); } },
+    { "counters", 4000000, [](int count) { bench_hw_counters(count); } },
+    { "calibrate", 3, [](int count) { bench_quality_calibration(count); } },
+    { "jitter", 240, [](int count) { bench_frame_jitter(count); } },
+    { "systems", 600, [](int count) { bench_system_scheduler(count); } },
+    { "io", 200, [](int count) { bench_async_io(count); } },
+    { "ui", 3600, [](int count) { bench_ui_layer(count); } },
+};
+
+int run_benchmark(const char* name, int count) {
+    for (const Benchmark& b : g_benchmarks) {
+        if (strcmp(b.name, name) == 0 || strcmp(name, "all") == 0) {
+            b.run(count > 0 ? count : b.defaultCount);
+            if (strcmp(name, "all") != 0) return 0;
+        }
+    }
+    if (strcmp(name, "all") == 0) return 0;
+
+    std::cout << "Unknown benchmark: " << name << std::endl;
+    std::cout << "Available:";
+    for (const Benchmark& b : g_benchmarks) std::cout << " " << b.name;
+    std::cout << " all" << std::endl;
+    return 1;
+}
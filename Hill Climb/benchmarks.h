@@ -0,0 +1,7 @@
+// benchmarks.h
+// Headless benchmarks, run with: "Hill Climb.exe" --bench <name> [count]
+
+#pragma once
+
+// Returns the process exit code; prints the list of benchmarks for an unknown name.
+int run_benchmark(const char* name, int count);
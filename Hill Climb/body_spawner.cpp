@@ -0,0 +1,126 @@
+// body_spawner.cpp
+// Archetype-based bulk body creation: one prototype, a packed transform array, N bodies in one call
+
+#include "body_spawner.h"
+
+#include <iostream>
+#include <chrono>
+#include "collision_layers.h"
+
+BodyArchetype make_box_archetype(EntityType type, b2BodyType bodyType, float halfW, float halfH,
+    float density, float friction, const UserData& userData) {
+    BodyArchetype archetype = {};
+    archetype.bodyDef = b2DefaultBodyDef();
+    archetype.bodyDef.type = bodyType;
+
+    ShapePrototype& shape = archetype.shapes[0];
+    shape.polygon = b2MakeBox(halfW, halfH);
+    shape.def = b2DefaultShapeDef();
+    shape.def.density = density;
+    shape.def.material.friction = friction;
+    shape.def.filter = make_collision_filter(type);
+    archetype.shapeCount = 1;
+
+    archetype.userData = userData;
+    archetype.userData.type = type;
+    return archetype;
+}
+
+int spawn_bodies(b2WorldId world, const BodyArchetype& archetype, const b2Transform* transforms,
+    int count, SpawnBatch& batch) {
+    // User data for the whole batch is set up in one block before any body exists
+    size_t first = batch.bodies.size();
+    const UserData* oldData = batch.userData.data();
+    batch.bodies.reserve(first + count);
+    batch.userData.resize(first + count, archetype.userData);
+
+    // Growing an existing batch may move its user data; re-point the earlier bodies
+    if (first != 0 && batch.userData.data() != oldData) {
+        for (size_t i = 0; i < first; ++i) b2Body_SetUserData(batch.bodies[i], &batch.userData[i]);
+    }
+
+    // Mass is computed once per body after all its shapes are attached
+    ShapePrototype shapes[MAX_ARCHETYPE_SHAPES];
+    for (int s = 0; s < archetype.shapeCount; ++s) {
+        shapes[s] = archetype.shapes[s];
+        shapes[s].def.updateBodyMass = false;
+    }
+    bool needsMass = archetype.bodyDef.type != b2_staticBody;
+
+    b2BodyDef def = archetype.bodyDef;
+    for (int i = 0; i < count; ++i) {
+        def.position = transforms[i].p;
+        def.rotation = transforms[i].q;
+        def.userData = &batch.userData[first + i];
+
+        b2BodyId body = b2CreateBody(world, &def);
+        for (int s = 0; s < archetype.shapeCount; ++s) {
+            b2CreatePolygonShape(body, &shapes[s].def, &shapes[s].polygon);
+        }
+        if (needsMass) b2Body_ApplyMassFromShapes(body);
+        batch.bodies.push_back(body);
+    }
+    return count;
+}
+
+void destroy_spawn_batch(SpawnBatch& batch) {
+    for (b2BodyId body : batch.bodies) {
+        if (b2Body_IsValid(body)) b2DestroyBody(body);
+    }
+    batch.bodies.clear();
+    batch.userData.clear();
+}
+
+// ---------------- Benchmark ----------------
+void bench_spawn_bodies(int count) {
+    std::vector<b2Transform> transforms(count);
+    int columns = 1000;
+    for (int i = 0; i < count; ++i) {
+        transforms[i].p = { (i % columns) * 1.5f, (i / columns) * 1.5f };
+        transforms[i].q = b2MakeRot(0.0f);
+    }
+
+    // Level geometry spawns asleep so the first step doesn't solve every body
+    UserData boxUD = { ENTITY_BOX, nullptr, 0, false, 0.0f, false, 1.0f };
+    BodyArchetype archetype = make_box_archetype(ENTITY_BOX, b2_dynamicBody, 0.5f, 0.5f, 1.0f, 0.3f, boxUD);
+    archetype.bodyDef.isAwake = false;
+
+    b2WorldDef worldDef = b2DefaultWorldDef();
+    worldDef.gravity = { 0.0f,-10.0f };
+
+    // One call with the prototype
+    b2WorldId world = b2CreateWorld(&worldDef);
+    SpawnBatch batch;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    spawn_bodies(world, archetype, transforms.data(), count, batch);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    destroy_spawn_batch(batch);
+    b2DestroyWorld(world);
+
+    // Same bodies created the way main() used to, one at a time
+    world = b2CreateWorld(&worldDef);
+    std::vector<UserData*> userData;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < count; ++i) {
+        b2BodyDef boxDef = b2DefaultBodyDef();
+        boxDef.type = b2_dynamicBody;
+        boxDef.position = transforms[i].p;
+        boxDef.isAwake = false;
+        b2BodyId box = b2CreateBody(world, &boxDef);
+        UserData* ud = new UserData(boxUD);
+        userData.push_back(ud);
+        b2Body_SetUserData(box, ud);
+        b2Polygon boxShape = b2MakeBox(0.5f, 0.5f);
+        b2ShapeDef boxSD = b2DefaultShapeDef(); boxSD.density = 1.0f; boxSD.material.friction = 0.3f;
+        b2CreatePolygonShape(box, &boxSD, &boxShape);
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+    for (UserData* ud : userData) delete ud;
+    b2DestroyWorld(world);
+
+    double bulkMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double naiveMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+    std::cout << "Spawn bodies: " << count << std::endl;
+    std::cout << "  spawn_bodies:  " << bulkMs << " ms (" << bulkMs * 1e6 / count << " ns/body)" << std::endl;
+    std::cout << "  one at a time: " << naiveMs << " ms (" << naiveMs * 1e6 / count << " ns/body)" << std::endl;
+}
@@ -0,0 +1,40 @@
+// body_spawner.h
+// Archetype-based bulk body creation: one prototype, a packed transform array, N bodies in one call
+
+#pragma once
+
+#include <vector>
+#include <box2d/box2d.h>
+#include "entity.h"
+#include "page_memory.h"
+
+const int MAX_ARCHETYPE_SHAPES = 4;
+
+struct ShapePrototype {
+    b2Polygon polygon;   // Built once (b2MakeBox etc.), reused for every body
+    b2ShapeDef def;
+};
+
+struct BodyArchetype {
+    b2BodyDef bodyDef;
+    ShapePrototype shapes[MAX_ARCHETYPE_SHAPES];
+    int shapeCount;
+    UserData userData;   // Copied per body; pointer members (color) are shared
+};
+
+// Bodies plus their user data, stored contiguously. The batch owns the UserData (carved from entity_memory()).
+struct SpawnBatch {
+    std::vector<b2BodyId> bodies;
+    std::vector<UserData, ReservationAllocator<UserData, entity_memory>> userData;
+};
+
+BodyArchetype make_box_archetype(EntityType type, b2BodyType bodyType, float halfW, float halfH,
+    float density, float friction, const UserData& userData);
+
+// Creates count bodies at transforms[i]. Returns the number created.
+int spawn_bodies(b2WorldId world, const BodyArchetype& archetype, const b2Transform* transforms,
+    int count, SpawnBatch& batch);
+void destroy_spawn_batch(SpawnBatch& batch);
+
+// Compares spawn_bodies with one-at-a-time creation (headless)
+void bench_spawn_bodies(int count);
@@ -0,0 +1,325 @@
+// character_controller.cpp
+// Grounded tracking from Box2D contact events + shape-cast step-up / slope handling
+
+#include "character_controller.h"
+
+#include <iostream>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <unordered_map>
+
+std::vector<CharacterController> g_controllers;
+
+// Shape -> controller index, so contact events can be routed without touching shape user data
+static std::unordered_map<uint64_t, int> g_controllerByShape;
+
+const float COYOTE_TIME = 0.1f;    // Jump still allowed this long after leaving the ground
+const float JUMP_COOLDOWN = 0.25f; // Stops repeat jumps before the end-touch event arrives
+const float SKIN = 0.02f;          // Cast proxies are shrunk by this to avoid starting in contact
+const float GROUND_PROBE = 0.1f;
+
+static uint64_t shape_key(b2ShapeId id) {
+    return (static_cast<uint64_t>(id.world0) << 32) | static_cast<uint32_t>(id.index1);
+}
+
+static int find_controller(b2ShapeId id) {
+    auto it = g_controllerByShape.find(shape_key(id));
+    return it != g_controllerByShape.end() ? it->second : -1;
+}
+
+// ---------------- Creation ----------------
+int create_character_controller(b2BodyId body, b2ShapeId shape, float halfW, float halfH,
+    float moveForce, float jumpImpulse) {
+    CharacterController c = {};
+    c.body = body;
+    c.shape = shape;
+    b2Filter filter = b2Shape_GetFilter(shape);
+    c.queryFilter = { filter.categoryBits, filter.maskBits };
+    c.halfWidth = halfW;
+    c.halfHeight = halfH;
+    c.moveForce = moveForce;
+    c.jumpImpulse = jumpImpulse;
+    c.maxSlopeCos = 0.7f;          // ~45 degrees
+    c.stepHeight = halfH * 0.5f;
+    c.groundNormal = { 0.0f, 1.0f };
+    c.timeSinceGrounded = COYOTE_TIME;
+
+    int index = static_cast<int>(g_controllers.size());
+    g_controllers.push_back(c);
+    g_controllerByShape[shape_key(shape)] = index;
+    return index;
+}
+
+void destroy_character_controller(int index) {
+    g_controllerByShape.erase(shape_key(g_controllers[index].shape));
+
+    // Swap-remove and re-point the moved controller's shape
+    int last = static_cast<int>(g_controllers.size()) - 1;
+    if (index != last) {
+        g_controllers[index] = g_controllers[last];
+        g_controllerByShape[shape_key(g_controllers[index].shape)] = index;
+    }
+    g_controllers.pop_back();
+}
+
+void clear_character_controllers() {
+    g_controllers.clear();
+    g_controllerByShape.clear();
+}
+
+// ---------------- Ground Contacts ----------------
+static void refresh_ground_state(CharacterController& c) {
+    c.grounded = c.groundContactCount > 0;
+    if (!c.grounded) {
+        c.groundNormal = { 0.0f, 1.0f };
+        return;
+    }
+
+    b2Vec2 sum = { 0.0f, 0.0f };
+    for (int i = 0; i < c.groundContactCount; ++i) {
+        sum.x += c.groundNormals[i].x;
+        sum.y += c.groundNormals[i].y;
+    }
+    float len = sqrtf(sum.x * sum.x + sum.y * sum.y);
+    c.groundNormal = len > 0.0f ? b2Vec2{ sum.x / len, sum.y / len } : b2Vec2{ 0.0f, 1.0f };
+}
+
+// normal points out of the other shape towards the controller
+static void add_ground_contact(CharacterController& c, b2ShapeId other, b2Vec2 normal) {
+    if (normal.y < c.maxSlopeCos) return; // Wall or ceiling
+    if (c.groundContactCount == MAX_GROUND_CONTACTS) return;
+
+    c.groundShapes[c.groundContactCount] = other;
+    c.groundNormals[c.groundContactCount] = normal;
+    c.groundContactCount++;
+    refresh_ground_state(c);
+}
+
+static void remove_ground_contact(CharacterController& c, b2ShapeId other) {
+    for (int i = 0; i < c.groundContactCount; ++i) {
+        if (B2_ID_EQUALS(c.groundShapes[i], other)) {
+            c.groundContactCount--;
+            c.groundShapes[i] = c.groundShapes[c.groundContactCount];
+            c.groundNormals[i] = c.groundNormals[c.groundContactCount];
+            refresh_ground_state(c);
+            return;
+        }
+    }
+}
+
+void process_character_contact_events(b2WorldId world) {
+    b2ContactEvents events = b2World_GetContactEvents(world);
+
+    for (int i = 0; i < events.beginCount; ++i) {
+        const b2ContactBeginTouchEvent& e = events.beginEvents[i];
+        // Manifold normal points from A to B
+        int a = find_controller(e.shapeIdA);
+        if (a >= 0) add_ground_contact(g_controllers[a], e.shapeIdB, { -e.manifold.normal.x, -e.manifold.normal.y });
+        int b = find_controller(e.shapeIdB);
+        if (b >= 0) add_ground_contact(g_controllers[b], e.shapeIdA, e.manifold.normal);
+    }
+
+    for (int i = 0; i < events.endCount; ++i) {
+        const b2ContactEndTouchEvent& e = events.endEvents[i];
+        int a = find_controller(e.shapeIdA);
+        if (a >= 0) remove_ground_contact(g_controllers[a], e.shapeIdB);
+        int b = find_controller(e.shapeIdB);
+        if (b >= 0) remove_ground_contact(g_controllers[b], e.shapeIdA);
+    }
+}
+
+// ---------------- Shape Casts ----------------
+struct CastResult {
+    b2BodyId self;
+    bool hit;
+    float fraction;
+    b2Vec2 normal;
+};
+
+static float cast_closest_fcn(b2ShapeId shapeId, b2Vec2 point, b2Vec2 normal, float fraction, void* context) {
+    (void)point;
+    CastResult* result = static_cast<CastResult*>(context);
+    if (b2Shape_IsSensor(shapeId)) return -1.0f;
+    if (B2_ID_EQUALS(b2Shape_GetBody(shapeId), result->self)) return -1.0f;
+
+    result->hit = true;
+    result->fraction = fraction;
+    result->normal = normal;
+    return fraction; // Clip to the closest hit
+}
+
+// Controller box in world space, shrunk by SKIN and shifted by offset
+static b2ShapeProxy make_box_proxy(const b2Transform& xf, float halfW, float halfH, b2Vec2 offset) {
+    float hw = halfW - SKIN;
+    float hh = halfH - SKIN;
+    b2Vec2 local[4] = { { -hw, -hh }, { hw, -hh }, { hw, hh }, { -hw, hh } };
+    b2Vec2 points[4];
+    for (int i = 0; i < 4; ++i) {
+        points[i].x = xf.q.c * local[i].x - xf.q.s * local[i].y + xf.p.x + offset.x;
+        points[i].y = xf.q.s * local[i].x + xf.q.c * local[i].y + xf.p.y + offset.y;
+    }
+    return b2MakeProxy(points, 4, 0.0f);
+}
+
+static CastResult cast_box(b2WorldId world, const CharacterController& c, const b2Transform& xf,
+    b2Vec2 offset, b2Vec2 translation) {
+    CastResult result = { c.body, false, 1.0f, { 0.0f, 0.0f } };
+    b2ShapeProxy proxy = make_box_proxy(xf, c.halfWidth, c.halfHeight, offset);
+    b2World_CastShape(world, &proxy, translation, c.queryFilter, cast_closest_fcn, &result);
+    return result;
+}
+
+// ---------------- Update ----------------
+// Scratch lists reused every frame so the batched passes don't allocate
+static std::vector<int> s_movers;
+static std::vector<b2Transform> s_transforms;
+static std::vector<int> s_blocked;
+
+void update_character_controllers(b2WorldId world, float deltaTime) {
+    s_movers.clear();
+    s_transforms.clear();
+
+    // Timers and jumps; collect grounded controllers that want to move
+    for (int i = 0; i < static_cast<int>(g_controllers.size()); ++i) {
+        CharacterController& c = g_controllers[i];
+        c.jumpCooldown = fmaxf(0.0f, c.jumpCooldown - deltaTime);
+        c.timeSinceGrounded = c.grounded ? 0.0f : c.timeSinceGrounded + deltaTime;
+
+        if (c.jumpRequested && c.timeSinceGrounded < COYOTE_TIME && c.jumpCooldown <= 0.0f) {
+            b2Body_ApplyLinearImpulseToCenter(c.body, { 0.0f, c.jumpImpulse }, true);
+            c.jumpCooldown = JUMP_COOLDOWN;
+            c.timeSinceGrounded = COYOTE_TIME;
+        }
+        c.jumpRequested = false;
+
+        if (c.moveInput == 0.0f) continue;
+        if (!c.grounded) {
+            // Air control: plain horizontal force
+            b2Body_ApplyForceToCenter(c.body, { c.moveForce * c.moveInput, 0.0f }, true);
+            continue;
+        }
+        s_movers.push_back(i);
+        s_transforms.push_back(b2Body_GetTransform(c.body));
+    }
+
+    // Pass 1: short downward cast for the slope under the controller
+    for (size_t m = 0; m < s_movers.size(); ++m) {
+        CharacterController& c = g_controllers[s_movers[m]];
+        CastResult down = cast_box(world, c, s_transforms[m], { 0.0f, 0.0f }, { 0.0f, -(SKIN + GROUND_PROBE) });
+        if (down.hit && down.normal.y >= c.maxSlopeCos) c.groundNormal = down.normal;
+    }
+
+    // Pass 2: forward probe; anything steeper than maxSlope blocks us
+    s_blocked.clear();
+    for (size_t m = 0; m < s_movers.size(); ++m) {
+        CharacterController& c = g_controllers[s_movers[m]];
+        float dir = c.moveInput > 0.0f ? 1.0f : -1.0f;
+        float speed = fabsf(b2Body_GetLinearVelocity(c.body).x);
+        float probe = SKIN * 2.0f + 0.05f + speed * deltaTime;
+        CastResult fwd = cast_box(world, c, s_transforms[m], { 0.0f, SKIN }, { dir * probe, 0.0f });
+        if (fwd.hit && fabsf(fwd.normal.y) < c.maxSlopeCos) s_blocked.push_back(static_cast<int>(m));
+    }
+
+    // Pass 3: step-up for blocked controllers - raise, move forward, drop back down
+    for (int m : s_blocked) {
+        CharacterController& c = g_controllers[s_movers[m]];
+        const b2Transform& xf = s_transforms[m];
+        float dir = c.moveInput > 0.0f ? 1.0f : -1.0f;
+        float forward = SKIN * 2.0f + 0.05f;
+
+        CastResult up = cast_box(world, c, xf, { 0.0f, 0.0f }, { 0.0f, c.stepHeight });
+        if (up.hit) continue; // Ceiling in the way
+        CastResult over = cast_box(world, c, xf, { 0.0f, c.stepHeight }, { dir * forward, 0.0f });
+        if (over.hit) continue; // Ledge taller than stepHeight
+        CastResult drop = cast_box(world, c, xf, { dir * forward, c.stepHeight }, { 0.0f, -c.stepHeight });
+        if (!drop.hit || drop.normal.y < c.maxSlopeCos) continue;
+
+        float lift = c.stepHeight * (1.0f - drop.fraction) + SKIN;
+        b2Body_SetTransform(c.body, { xf.p.x, xf.p.y + lift }, xf.q);
+    }
+
+    // Move along the slope tangent instead of pushing into it
+    for (int index : s_movers) {
+        CharacterController& c = g_controllers[index];
+        b2Vec2 tangent = { c.groundNormal.y, -c.groundNormal.x };
+        float f = c.moveForce * c.moveInput;
+        b2Body_ApplyForceToCenter(c.body, { tangent.x * f, tangent.y * f }, true);
+    }
+}
+
+// ---------------- Benchmark ----------------
+void bench_character_controllers(int count, int frames) {
+    b2WorldDef worldDef = b2DefaultWorldDef();
+    worldDef.gravity = { 0.0f,-10.0f };
+    b2WorldId world = b2CreateWorld(&worldDef);
+
+    float spacing = 3.0f;
+    float halfLength = count * spacing * 0.5f + 10.0f;
+
+    b2BodyDef groundDef = b2DefaultBodyDef();
+    groundDef.type = b2_staticBody;
+    groundDef.position = { 0.0f,-5.0f };
+    b2BodyId ground = b2CreateBody(world, &groundDef);
+    b2Polygon groundShape = b2MakeBox(halfLength, 0.1f);
+    b2ShapeDef groundSD = b2DefaultShapeDef();
+    b2CreatePolygonShape(ground, &groundSD, &groundShape);
+
+    // Small steps every few meters so pass 3 gets exercised
+    for (float x = -halfLength + 4.0f; x < halfLength; x += 7.0f) {
+        b2BodyDef stepDef = b2DefaultBodyDef();
+        stepDef.position = { x,-4.75f };
+        b2BodyId step = b2CreateBody(world, &stepDef);
+        b2Polygon stepShape = b2MakeBox(1.0f, 0.15f);
+        b2CreatePolygonShape(step, &groundSD, &stepShape);
+    }
+
+    clear_character_controllers();
+    for (int i = 0; i < count; ++i) {
+        b2BodyDef bodyDef = b2DefaultBodyDef();
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position = { -count * spacing * 0.5f + i * spacing, -4.0f };
+        bodyDef.fixedRotation = true;
+        b2BodyId body = b2CreateBody(world, &bodyDef);
+        b2Polygon shape = b2MakeBox(0.5f, 0.5f);
+        b2ShapeDef sd = b2DefaultShapeDef(); sd.density = 1.0f; sd.material.friction = 0.3f;
+        sd.enableContactEvents = true;
+        b2ShapeId shapeId = b2CreatePolygonShape(body, &sd, &shape);
+        create_character_controller(body, shapeId, 0.5f, 0.5f, 20.0f, 6.0f);
+    }
+
+    float timeStep = 1.0f / 60.0f;
+    double controllerSeconds = 0.0;
+    double stepSeconds = 0.0;
+    int groundedFrames = 0;
+
+    for (int frame = 0; frame < frames; ++frame) {
+        for (auto& c : g_controllers) {
+            c.moveInput = ((frame / 120) % 2 == 0) ? 1.0f : -1.0f;
+            c.jumpRequested = (rand() % 90) == 0;
+        }
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        update_character_controllers(world, timeStep);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        b2World_Step(world, timeStep, 8);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        process_character_contact_events(world);
+        auto t3 = std::chrono::high_resolution_clock::now();
+
+        controllerSeconds += std::chrono::duration<double>((t1 - t0) + (t3 - t2)).count();
+        stepSeconds += std::chrono::duration<double>(t2 - t1).count();
+        for (const auto& c : g_controllers) groundedFrames += c.grounded ? 1 : 0;
+    }
+
+    double perController = controllerSeconds / frames / count * 1e9;
+    std::cout << "Character controllers: " << count << " x " << frames << " frames" << std::endl;
+    std::cout << "  controller cost: " << perController << " ns/controller/frame ("
+        << controllerSeconds / frames * 1e6 << " us/frame)" << std::endl;
+    std::cout << "  b2World_Step:    " << stepSeconds / frames * 1e6 << " us/frame" << std::endl;
+    std::cout << "  grounded ratio:  " << static_cast<double>(groundedFrames) / (frames * count) << std::endl;
+
+    clear_character_controllers();
+    b2DestroyWorld(world);
+}
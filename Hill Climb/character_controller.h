@@ -0,0 +1,53 @@
+// character_controller.h
+// Grounded tracking from Box2D contact events + shape-cast step-up / slope handling
+
+#pragma once
+
+#include <vector>
+#include <box2d/box2d.h>
+
+const int MAX_GROUND_CONTACTS = 8;
+
+struct CharacterController {
+    b2BodyId body;
+    b2ShapeId shape;
+    b2QueryFilter queryFilter; // Built from the shape's collision filter so casts skip ignored layers
+    float halfWidth;
+    float halfHeight;
+
+    // Tuning
+    float moveForce;
+    float jumpImpulse;
+    float maxSlopeCos;    // Contacts with normal.y below this are walls, not ground
+    float stepHeight;     // Tallest ledge we climb without jumping (meters)
+
+    // Ground contacts, maintained from begin/end touch events
+    int groundContactCount;
+    b2ShapeId groundShapes[MAX_GROUND_CONTACTS];
+    b2Vec2 groundNormals[MAX_GROUND_CONTACTS];
+    b2Vec2 groundNormal;  // Averaged normal of the current ground contacts
+    bool grounded;
+    float timeSinceGrounded;
+    float jumpCooldown;
+
+    // Per-frame input (set by player input or AI)
+    float moveInput;      // -1 .. 1
+    bool jumpRequested;
+};
+
+extern std::vector<CharacterController> g_controllers;
+
+// Creates a controller for an existing body/shape and returns its index.
+int create_character_controller(b2BodyId body, b2ShapeId shape, float halfW, float halfH,
+    float moveForce, float jumpImpulse);
+void destroy_character_controller(int index);
+void clear_character_controllers();
+
+// Applies input with slope projection and step-up. Call before b2World_Step.
+void update_character_controllers(b2WorldId world, float deltaTime);
+
+// Consumes begin/end touch events to maintain grounded state. Call after b2World_Step.
+void process_character_contact_events(b2WorldId world);
+
+// Per-controller cost benchmark (headless)
+void bench_character_controllers(int count, int frames);
@@ -0,0 +1,182 @@
+// coins.cpp
+// Collectible coins placed along the streamed terrain: pooled, grid-queried, drawn as one instanced batch
+
+#include "coins.h"
+
+#include <iostream>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <unordered_set>
+
+#include "spatial_grid.h"
+
+const int COINS_PER_ROW = 6;
+const float COIN_SPACING = 0.8f;
+const float COIN_ROW_SPACING = 8.0f;
+const float COIN_HOVER = 1.2f;    // Height above the ground
+
+static std::vector<Coin> g_coinPool;
+static std::vector<int> g_freeCoins;
+static std::vector<CoinInstance> g_coinInstances;
+static std::vector<int> g_instanceOwner;  // Instance -> pool index
+static std::vector<int> g_gridOwner;      // Grid id -> pool index
+static std::unordered_set<int> g_collectedKeys;
+static SpatialGrid g_coinGrid;
+static std::vector<int> g_coinHits;
+static uint32_t g_coinRevision = 0;
+
+void init_coins() {
+    g_coinPool.clear();
+    g_freeCoins.clear();
+    g_coinInstances.clear();
+    g_instanceOwner.clear();
+    g_gridOwner.clear();
+    g_collectedKeys.clear();
+    grid_init(g_coinGrid, 4.0f, 1024);
+    g_coinRevision++;
+}
+
+void shutdown_coins() {
+    init_coins();
+}
+
+// ---------------- Pool ----------------
+static int spawn_coin(b2Vec2 pos, int key) {
+    int index;
+    if (!g_freeCoins.empty()) {
+        index = g_freeCoins.back();
+        g_freeCoins.pop_back();
+    }
+    else {
+        index = static_cast<int>(g_coinPool.size());
+        g_coinPool.push_back({});
+    }
+
+    Coin& c = g_coinPool[index];
+    c.pos = pos;
+    c.key = key;
+    c.alive = true;
+    c.gridId = grid_insert(g_coinGrid, pos, COIN_RADIUS, COIN_RADIUS);
+    if (c.gridId >= static_cast<int>(g_gridOwner.size())) g_gridOwner.resize(c.gridId + 1);
+    g_gridOwner[c.gridId] = index;
+
+    c.instance = static_cast<int>(g_coinInstances.size());
+    g_coinInstances.push_back({ pos.x, pos.y, static_cast<float>(index % 16) * 0.4f });
+    g_instanceOwner.push_back(index);
+    g_coinRevision++;
+    return index;
+}
+
+static void release_coin(int index) {
+    Coin& c = g_coinPool[index];
+    if (!c.alive) return;
+    grid_remove(g_coinGrid, c.gridId);
+
+    // Swap-remove the instance so the upload stays dense
+    int last = static_cast<int>(g_coinInstances.size()) - 1;
+    g_coinInstances[c.instance] = g_coinInstances[last];
+    g_instanceOwner[c.instance] = g_instanceOwner[last];
+    g_coinPool[g_instanceOwner[c.instance]].instance = c.instance;
+    g_coinInstances.pop_back();
+    g_instanceOwner.pop_back();
+
+    c.alive = false;
+    g_freeCoins.push_back(index);
+    g_coinRevision++;
+}
+
+// ---------------- Terrain placement ----------------
+void coins_on_terrain_chunk(const TerrainChunk& chunk, bool loaded) {
+    int firstKey = chunk.index * COINS_PER_CHUNK;
+    if (!loaded) {
+        for (size_t i = 0; i < g_coinPool.size(); ++i) {
+            const Coin& c = g_coinPool[i];
+            if (c.alive && c.key >= firstKey && c.key < firstKey + COINS_PER_CHUNK) release_coin(static_cast<int>(i));
+        }
+        return;
+    }
+
+    // Rows of coins floating over the hills, one row every COIN_ROW_SPACING meters
+    float chunkX = terrain_start_x() + chunk.index * TERRAIN_CHUNK_WIDTH;
+    for (int slot = 0; slot < COINS_PER_CHUNK; ++slot) {
+        int key = firstKey + slot;
+        if (g_collectedKeys.count(key)) continue;
+
+        float local = 2.0f + (slot / COINS_PER_ROW) * COIN_ROW_SPACING + (slot % COINS_PER_ROW) * COIN_SPACING;
+        float t = local / TERRAIN_SAMPLE_SPACING;
+        int k = static_cast<int>(t);
+        float h = chunk.heights[k] + (chunk.heights[k + 1] - chunk.heights[k]) * (t - k);
+        spawn_coin({ chunkX + local, h + COIN_HOVER }, key);
+    }
+}
+
+// ---------------- Pickup ----------------
+CoinPickup collect_coins(b2Vec2 center, float halfW, float halfH) {
+    CoinPickup pickup = {};
+    b2AABB box = { { center.x - halfW, center.y - halfH }, { center.x + halfW, center.y + halfH } };
+    if (grid_query_aabb(g_coinGrid, box, g_coinHits) == 0) return pickup;
+
+    for (int gridId : g_coinHits) {
+        int index = g_gridOwner[gridId];
+        Coin& c = g_coinPool[index];
+        pickup.coins++;
+        pickup.points += COIN_VALUE;
+        pickup.position.x += c.pos.x;
+        pickup.position.y += c.pos.y;
+        if (c.key >= 0) g_collectedKeys.insert(c.key);
+        release_coin(index);
+    }
+    pickup.position.x /= pickup.coins;
+    pickup.position.y /= pickup.coins;
+    return pickup;
+}
+
+const std::vector<CoinInstance>& coin_instances() {
+    return g_coinInstances;
+}
+
+uint32_t coin_revision() {
+    return g_coinRevision;
+}
+
+// ---------------- Benchmark ----------------
+void bench_coins(int count) {
+    const float fieldWidth = 2000.0f;
+    const int frames = 600;
+    init_coins();
+    for (int i = 0; i < count; ++i) {
+        float x = static_cast<float>(rand()) / RAND_MAX * fieldWidth;
+        float y = static_cast<float>(rand()) / RAND_MAX * 4.0f;
+        spawn_coin({ x, y }, -1);
+    }
+    std::vector<b2Vec2> positions;
+    for (const Coin& c : g_coinPool) positions.push_back(c.pos);
+
+    // Player sweeps the field; brute force only tests, the grid pass also collects
+    long long bruteHits = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        b2Vec2 p = { fieldWidth * frame / frames, 2.0f };
+        for (const b2Vec2& c : positions) {
+            if (fabsf(c.x - p.x) <= 1.0f + COIN_RADIUS && fabsf(c.y - p.y) <= 1.0f + COIN_RADIUS) bruteHits++;
+        }
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    long long collected = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        b2Vec2 p = { fieldWidth * frame / frames, 2.0f };
+        collected += collect_coins(p, 1.0f, 1.0f).coins;
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    auto us = [frames](std::chrono::high_resolution_clock::duration d) {
+        return std::chrono::duration<double, std::micro>(d).count() / frames;
+    };
+    std::cout << "Coins: " << count << " live, " << frames << " frames" << std::endl;
+    std::cout << "  grid pickup:  " << us(t2 - t1) << " us/frame (" << collected << " collected)" << std::endl;
+    std::cout << "  brute force:  " << us(t1 - t0) << " us/frame (" << bruteHits << " touches)" << std::endl;
+    std::cout << "  instances:    " << g_coinInstances.size() << " left, "
+        << g_coinInstances.size() * sizeof(CoinInstance) << " bytes per upload" << std::endl;
+    shutdown_coins();
+}
@@ -0,0 +1,50 @@
+// coins.h
+// Collectible coins placed along the streamed terrain: pooled, grid-queried, drawn as one instanced batch
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <box2d/box2d.h>
+#include "terrain.h"
+
+const int COINS_PER_CHUNK = 24;
+const int COIN_VALUE = 5;
+const float COIN_RADIUS = 0.3f;
+
+struct Coin {
+    b2Vec2 pos;
+    int key;              // chunk * COINS_PER_CHUNK + slot, -1 for coins not tied to terrain
+    int gridId;
+    int instance;         // Index into coin_instances()
+    bool alive;
+};
+
+// Per-instance vertex data
+struct CoinInstance {
+    float x, y;
+    float phase;          // Spin offset, so neighbouring coins don't turn in lockstep
+};
+
+// Everything collected in one call, so one popup covers a whole row of coins
+struct CoinPickup {
+    int coins;
+    int points;
+    b2Vec2 position;      // Average position of the collected coins
+};
+
+void init_coins();
+void shutdown_coins();
+
+// Terrain chunk listener: places the chunk's coins on load (skipping ones already collected), frees them on unload
+void coins_on_terrain_chunk(const TerrainChunk& chunk, bool loaded);
+
+// Collects every live coin touching the box around center
+CoinPickup collect_coins(b2Vec2 center, float halfW, float halfH);
+
+// Live coins, densely packed for upload. The revision changes whenever coins are added or removed.
+const std::vector<CoinInstance>& coin_instances();
+uint32_t coin_revision();
+
+// Pickup cost per frame with count coins, grid vs brute force (headless)
+void bench_coins(int count);
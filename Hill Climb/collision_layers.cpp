@@ -0,0 +1,110 @@
+// collision_layers.cpp
+// EntityType -> b2Filter category/mask bits from a single table, plus per layer pair contact stats
+
+#include "collision_layers.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <map>
+#include <utility>
+
+// Live touching contacts and total begin events per layer pair (upper triangle used)
+static int g_layerPairTouching[ENTITY_TYPE_COUNT][ENTITY_TYPE_COUNT];
+static long long g_layerPairBegins[ENTITY_TYPE_COUNT][ENTITY_TYPE_COUNT];
+// Layer pair of every touching contact, classified at begin: an end event may name shapes
+// destroyed this step, which can't be asked for their filter any more
+static std::map<std::pair<uint64_t, uint64_t>, std::pair<int, int>> g_touchingContacts;
+
+const CollisionLayer& get_collision_layer(EntityType type) {
+    return g_collisionLayers[type];
+}
+
+b2Filter make_collision_filter(EntityType type) {
+    b2Filter filter = b2DefaultFilter();
+    filter.categoryBits = g_collisionLayers[type].category;
+    filter.maskBits = g_collisionLayers[type].mask;
+    return filter;
+}
+
+b2QueryFilter make_query_filter(EntityType type) {
+    b2QueryFilter filter = b2DefaultQueryFilter();
+    filter.categoryBits = g_collisionLayers[type].category;
+    filter.maskBits = g_collisionLayers[type].mask;
+    return filter;
+}
+
+void validate_collision_layers() {
+    for (int a = 0; a < ENTITY_TYPE_COUNT; ++a) {
+        for (int b = a; b < ENTITY_TYPE_COUNT; ++b) {
+            const CollisionLayer& la = g_collisionLayers[a];
+            const CollisionLayer& lb = g_collisionLayers[b];
+            bool aAcceptsB = (la.mask & lb.category) != 0;
+            bool bAcceptsA = (lb.mask & la.category) != 0;
+            if (aAcceptsB != bAcceptsA) {
+                std::cout << "Collision layers: " << la.name << " and " << lb.name
+                    << " disagree, pair will never collide" << std::endl;
+            }
+        }
+    }
+}
+
+// ---------------- Stats ----------------
+static int layer_index(b2ShapeId shape) {
+    uint64_t category = b2Shape_GetFilter(shape).categoryBits;
+    for (int i = 0; i < ENTITY_TYPE_COUNT; ++i) {
+        if (category & (1ull << i)) return i;
+    }
+    return ENTITY_NONE;
+}
+
+// Generation included, so a slot reused by a new shape never matches an old contact
+static uint64_t shape_key(b2ShapeId id) {
+    return (static_cast<uint64_t>(id.world0) << 48) | (static_cast<uint64_t>(id.generation) << 32) | static_cast<uint32_t>(id.index1);
+}
+
+static std::pair<uint64_t, uint64_t> contact_key(b2ShapeId a, b2ShapeId b) {
+    uint64_t ka = shape_key(a), kb = shape_key(b);
+    return ka < kb ? std::make_pair(ka, kb) : std::make_pair(kb, ka);
+}
+
+void record_collision_layer_events(b2WorldId world) {
+    b2ContactEvents events = b2World_GetContactEvents(world);
+
+    for (int i = 0; i < events.beginCount; ++i) {
+        int a = layer_index(events.beginEvents[i].shapeIdA);
+        int b = layer_index(events.beginEvents[i].shapeIdB);
+        if (a > b) { int t = a; a = b; b = t; }
+        g_touchingContacts[contact_key(events.beginEvents[i].shapeIdA, events.beginEvents[i].shapeIdB)] = { a, b };
+        g_layerPairTouching[a][b]++;
+        g_layerPairBegins[a][b]++;
+    }
+
+    for (int i = 0; i < events.endCount; ++i) {
+        auto it = g_touchingContacts.find(contact_key(events.endEvents[i].shapeIdA, events.endEvents[i].shapeIdB));
+        if (it == g_touchingContacts.end()) continue; // Began before the stats were recording
+        g_layerPairTouching[it->second.first][it->second.second]--;
+        g_touchingContacts.erase(it);
+    }
+}
+
+void print_collision_layer_stats(b2WorldId world) {
+    // Box2D v3 creates a contact for every broadphase pair whose AABBs overlap, so contactCount
+    // is the pair count the filter table is meant to keep down. Only its total is exposed: the
+    // public API reports contacts per layer pair only once they touch (begin/end events).
+    b2Counters counters = b2World_GetCounters(world);
+    std::cout << "---- Collision layers ----" << std::endl;
+    std::cout << "bodies " << counters.bodyCount << "  shapes " << counters.shapeCount
+        << "  broadphase pairs (all layers) " << counters.contactCount << "  islands " << counters.islandCount << std::endl;
+
+    std::cout << std::left << std::setw(18) << "pair" << std::setw(10) << "touching" << "begins" << std::endl;
+    for (int a = 0; a < ENTITY_TYPE_COUNT; ++a) {
+        for (int b = a; b < ENTITY_TYPE_COUNT; ++b) {
+            if (g_layerPairBegins[a][b] == 0) continue;
+            std::string pair = std::string(g_collisionLayers[a].name) + "-" + g_collisionLayers[b].name;
+            std::cout << std::setw(18) << pair << std::setw(10) << g_layerPairTouching[a][b]
+                << g_layerPairBegins[a][b] << std::endl;
+        }
+    }
+    std::cout << std::right;
+}
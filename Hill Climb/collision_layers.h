@@ -0,0 +1,55 @@
+// collision_layers.h
+// EntityType -> b2Filter category/mask bits from a single table, plus per layer pair contact stats
+
+#pragma once
+
+#include <box2d/box2d.h>
+#include "entity.h"
+
+// One category bit per entity type
+enum CollisionCategory : uint64_t {
+    CATEGORY_DEFAULT = 1ull << ENTITY_NONE,
+    CATEGORY_PLAYER = 1ull << ENTITY_PLAYER,
+    CATEGORY_BOX = 1ull << ENTITY_BOX,
+    CATEGORY_GROUND = 1ull << ENTITY_GROUND,
+    CATEGORY_BULLET = 1ull << ENTITY_BULLET,
+    CATEGORY_DEBRIS = 1ull << ENTITY_DEBRIS,
+    CATEGORY_SENSOR = 1ull << ENTITY_SENSOR,
+    CATEGORY_ENEMY = 1ull << ENTITY_ENEMY,
+};
+
+struct CollisionLayer {
+    EntityType type;
+    const char* name;
+    uint64_t category;
+    uint64_t mask;
+};
+
+const uint64_t MASK_ALL = ~0ull;
+
+// The only place collision rules live. Keep masks symmetric (see validate_collision_layers).
+// constexpr so archetype filters can be built at compile time (see archetypes.h).
+inline constexpr CollisionLayer g_collisionLayers[ENTITY_TYPE_COUNT] = {
+    { ENTITY_NONE,   "none",   CATEGORY_DEFAULT, MASK_ALL & ~CATEGORY_DEBRIS & ~CATEGORY_SENSOR },
+    { ENTITY_PLAYER, "player", CATEGORY_PLAYER,  CATEGORY_DEFAULT | CATEGORY_BOX | CATEGORY_GROUND | CATEGORY_SENSOR | CATEGORY_ENEMY },
+    { ENTITY_BOX,    "box",    CATEGORY_BOX,     CATEGORY_DEFAULT | CATEGORY_PLAYER | CATEGORY_BOX | CATEGORY_GROUND | CATEGORY_BULLET | CATEGORY_ENEMY },
+    { ENTITY_GROUND, "ground", CATEGORY_GROUND,  CATEGORY_DEFAULT | CATEGORY_PLAYER | CATEGORY_BOX | CATEGORY_BULLET | CATEGORY_DEBRIS | CATEGORY_ENEMY },
+    { ENTITY_BULLET, "bullet", CATEGORY_BULLET,  CATEGORY_DEFAULT | CATEGORY_BOX | CATEGORY_GROUND | CATEGORY_ENEMY },
+    { ENTITY_DEBRIS, "debris", CATEGORY_DEBRIS,  CATEGORY_GROUND },
+    { ENTITY_SENSOR, "sensor", CATEGORY_SENSOR,  CATEGORY_PLAYER },
+    { ENTITY_ENEMY,  "enemy",  CATEGORY_ENEMY,   CATEGORY_DEFAULT | CATEGORY_PLAYER | CATEGORY_BOX | CATEGORY_GROUND | CATEGORY_BULLET },
+};
+
+const CollisionLayer& get_collision_layer(EntityType type);
+
+b2Filter make_collision_filter(EntityType type);
+b2QueryFilter make_query_filter(EntityType type);
+
+// Warns about table rows whose masks disagree (Box2D needs both sides to accept a pair)
+void validate_collision_layers();
+
+// Tracks touching contacts per layer pair from begin/end events. Call after b2World_Step.
+void record_collision_layer_events(b2WorldId world);
+
+// Prints b2World_GetCounters totals and the per layer pair contact table
+void print_collision_layer_stats(b2WorldId world);
@@ -0,0 +1,176 @@
+// cooked_asset.cpp
+// Runtime asset formats written by Asset Cook: pre-decoded textures with mips and glyph caches
+
+#include "cooked_asset.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+struct CookedFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;       // Mips or glyphs
+    uint32_t reserved;
+};
+
+std::string cooked_name(const std::string& source, const char* extension) {
+    // The whole relative path, extension included, so a/x.png, b/x.png and x.jpg stay apart
+    std::string name = source;
+    std::replace(name.begin(), name.end(), '\\', '/');
+    while (name.compare(0, 2, "./") == 0) name.erase(0, 2);
+    return name + extension;
+}
+
+std::string cooked_path(const std::string& source, const char* extension) {
+    return std::string(COOKED_DIR) + "/" + cooked_name(source, extension);
+}
+
+bool cooked_is_current(const std::string& source, const std::string& cooked) {
+    std::error_code error;
+    auto cookedTime = std::filesystem::last_write_time(cooked, error);
+    if (error) return false;
+    auto sourceTime = std::filesystem::last_write_time(source, error);
+    return error || sourceTime <= cookedTime;
+}
+
+// ---------------- Files ----------------
+static bool write_file(const std::string& path, const CookedFileHeader& header, const void* table, size_t tableBytes,
+    const void* data, size_t dataBytes) {
+    // Write to a temp file and rename, so an interrupted cook never leaves a truncated asset behind
+    std::string temp = path + ".tmp";
+    FILE* f = fopen(temp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+        && (tableBytes == 0 || fwrite(table, tableBytes, 1, f) == 1)
+        && (dataBytes == 0 || fwrite(data, dataBytes, 1, f) == 1);
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        remove(temp.c_str());
+        return false;
+    }
+    remove(path.c_str());
+    return rename(temp.c_str(), path.c_str()) == 0;
+}
+
+static bool read_whole_file(const std::string& path, std::vector<unsigned char>& data) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool ok = size > 0;
+    if (ok) {
+        data.resize(static_cast<size_t>(size));
+        ok = fread(data.data(), 1, data.size(), f) == data.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+// Bounds-checked cursor over a file in memory
+struct CookedReader {
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+
+    bool read(void* out, size_t bytes) {
+        if (bytes > size - offset) return false;
+        if (bytes) memcpy(out, data + offset, bytes);
+        offset += bytes;
+        return true;
+    }
+};
+
+static bool read_header(CookedReader& in, uint32_t magic, CookedFileHeader& header) {
+    return in.read(&header, sizeof(header)) && header.magic == magic && header.version == COOKED_FORMAT_VERSION;
+}
+
+bool write_cooked_texture(const std::string& path, const CookedTexture& texture) {
+    CookedFileHeader header = { COOKED_TEXTURE_MAGIC, COOKED_FORMAT_VERSION, static_cast<uint32_t>(texture.mips.size()), 0 };
+    return write_file(path, header, texture.mips.data(), texture.mips.size() * sizeof(CookedMip),
+        texture.pixels.data(), texture.pixels.size());
+}
+
+bool read_cooked_texture(const std::string& path, CookedTexture& texture) {
+    std::vector<unsigned char> data;
+    return read_whole_file(path, data) && parse_cooked_texture(data.data(), data.size(), texture);
+}
+
+bool parse_cooked_texture(const unsigned char* data, size_t size, CookedTexture& texture) {
+    CookedReader in = { data, size, 0 };
+    CookedFileHeader header;
+    if (!read_header(in, COOKED_TEXTURE_MAGIC, header) || header.count == 0 || header.count > 32) return false;
+
+    texture.mips.resize(header.count);
+    if (!in.read(texture.mips.data(), sizeof(CookedMip) * header.count)) return false;
+    // upload_mip_chain trusts the table, so every level has to lie inside the pixels that follow it
+    uint64_t available = size - in.offset;
+    uint64_t pixelBytes = 0;
+    for (const CookedMip& mip : texture.mips) {
+        if (mip.width <= 0 || mip.height <= 0 || mip.width > 65536 || mip.height > 65536) return false;
+        uint64_t mipBytes = static_cast<uint64_t>(mip.width) * static_cast<uint64_t>(mip.height) * 4;
+        if (mip.offset > available || mipBytes > available - mip.offset) return false;
+        pixelBytes = std::max(pixelBytes, mip.offset + mipBytes);
+    }
+    texture.pixels.resize(static_cast<size_t>(pixelBytes));
+    return in.read(texture.pixels.data(), texture.pixels.size());
+}
+
+bool write_cooked_font(const std::string& path, const CookedFont& font) {
+    CookedFileHeader header = { COOKED_FONT_MAGIC, COOKED_FORMAT_VERSION, static_cast<uint32_t>(font.glyphs.size()), 0 };
+    // Sizes, atlas, then the kerning count and pairs
+    int sizes[3] = { font.pixelSize, font.atlasWidth, font.atlasHeight };
+    int32_t kerningCount = static_cast<int32_t>(font.kerning.size());
+    size_t kerningBytes = font.kerning.size() * sizeof(CookedKerning);
+    std::vector<unsigned char> data(sizeof(sizes) + font.atlas.size() + sizeof(kerningCount) + kerningBytes);
+    unsigned char* out = data.data();
+    memcpy(out, sizes, sizeof(sizes));
+    out += sizeof(sizes);
+    if (!font.atlas.empty()) memcpy(out, font.atlas.data(), font.atlas.size());
+    out += font.atlas.size();
+    memcpy(out, &kerningCount, sizeof(kerningCount));
+    out += sizeof(kerningCount);
+    if (kerningBytes) memcpy(out, font.kerning.data(), kerningBytes);
+    return write_file(path, header, font.glyphs.data(), font.glyphs.size() * sizeof(CookedGlyph), data.data(), data.size());
+}
+
+bool read_cooked_font(const std::string& path, CookedFont& font) {
+    std::vector<unsigned char> data;
+    return read_whole_file(path, data) && parse_cooked_font(data.data(), data.size(), font);
+}
+
+bool parse_cooked_font(const unsigned char* data, size_t size, CookedFont& font) {
+    CookedReader in = { data, size, 0 };
+    CookedFileHeader header;
+    if (!read_header(in, COOKED_FONT_MAGIC, header) || header.count > size / sizeof(CookedGlyph)) return false;
+
+    font.glyphs.resize(header.count);
+    int sizes[3];
+    bool ok = in.read(font.glyphs.data(), sizeof(CookedGlyph) * header.count) && in.read(sizes, sizeof(sizes));
+    if (ok) {
+        font.pixelSize = sizes[0];
+        font.atlasWidth = sizes[1];
+        font.atlasHeight = sizes[2];
+        uint64_t atlasBytes = static_cast<uint64_t>(font.atlasWidth) * static_cast<uint64_t>(font.atlasHeight);
+        ok = font.atlasWidth >= 0 && font.atlasHeight >= 0 && atlasBytes <= size;
+        // Glyph rectangles are uploaded straight out of the atlas, so they have to lie inside it
+        for (const CookedGlyph& g : font.glyphs) {
+            ok = ok && g.x >= 0 && g.y >= 0 && g.width >= 0 && g.height >= 0
+                && g.x <= font.atlasWidth - g.width && g.y <= font.atlasHeight - g.height;
+        }
+        if (ok) {
+            font.atlas.resize(static_cast<size_t>(atlasBytes));
+            ok = in.read(font.atlas.data(), font.atlas.size());
+        }
+    }
+    int32_t kerningCount = 0;
+    ok = ok && in.read(&kerningCount, sizeof(kerningCount)) && kerningCount >= 0
+        && static_cast<size_t>(kerningCount) <= size / sizeof(CookedKerning);
+    if (ok) {
+        font.kerning.resize(kerningCount);
+        ok = in.read(font.kerning.data(), sizeof(CookedKerning) * font.kerning.size());
+    }
+    return ok;
+}
@@ -0,0 +1,64 @@
+// cooked_asset.h
+// Runtime asset formats written by Asset Cook: pre-decoded textures with mips and glyph caches
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+const uint32_t COOKED_TEXTURE_MAGIC = 0x58544348; // "HCTX"
+const uint32_t COOKED_FONT_MAGIC = 0x4e464348;    // "HCFN"
+const uint32_t COOKED_FORMAT_VERSION = 2;
+const char* const COOKED_DIR = "cooked";
+
+struct CookedMip {
+    int32_t width, height;
+    uint64_t offset;      // Into pixels (fixed width so Win32 and x64 builds share files)
+};
+
+// RGBA8, rows bottom-up (already flipped for OpenGL), mip 0 first (built by build_mip_chain in mip_chain.h)
+struct CookedTexture {
+    std::vector<CookedMip> mips;
+    std::vector<unsigned char> pixels;
+};
+
+struct CookedGlyph {
+    int32_t code;
+    int32_t x, y, width, height;  // Rectangle in the atlas
+    int32_t bearingX, bearingY;
+    int32_t advance;              // 1/64 pixels, as FreeType reports it
+};
+
+// Nonzero pair adjustments from the font's kern table, by character code
+struct CookedKerning {
+    int32_t left, right;
+    int32_t amount;               // 1/64 pixels
+};
+
+// Rasterized glyphs packed into one R8 atlas, rows top-down like FreeType bitmaps
+struct CookedFont {
+    int pixelSize;
+    int atlasWidth, atlasHeight;
+    std::vector<CookedGlyph> glyphs;
+    std::vector<unsigned char> atlas;
+    std::vector<CookedKerning> kerning;
+};
+
+// Source path relative to the asset root: "enemy2.png" -> "enemy2.png.tex", "ui/x.png" -> "ui/x.png.tex"
+std::string cooked_name(const std::string& source, const char* extension);
+// The same under COOKED_DIR: "enemy2.png" -> "cooked/enemy2.png.tex"
+std::string cooked_path(const std::string& source, const char* extension);
+
+// False when the source has been modified since the cooked file was written (or there's no cooked
+// file); true when only the cooked file is there, as in a build shipped without sources
+bool cooked_is_current(const std::string& source, const std::string& cooked);
+
+bool write_cooked_texture(const std::string& path, const CookedTexture& texture);
+bool read_cooked_texture(const std::string& path, CookedTexture& texture);
+bool write_cooked_font(const std::string& path, const CookedFont& font);
+bool read_cooked_font(const std::string& path, CookedFont& font);
+
+// Same formats from a file already in memory (read through async_io.h)
+bool parse_cooked_texture(const unsigned char* data, size_t size, CookedTexture& texture);
+bool parse_cooked_font(const unsigned char* data, size_t size, CookedFont& font);
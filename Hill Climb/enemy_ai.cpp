@@ -0,0 +1,226 @@
+// enemy_ai.cpp
+// Enemy AI: cheap steering every step, time-sliced sensing/planning within a per-frame budget
+
+#include "enemy_ai.h"
+
+#include <iostream>
+#include <cmath>
+#include "character_controller.h"
+#include "archetypes.h"
+#include "collision_layers.h"
+#include "terrain.h"
+#include "nav_graph.h"
+#include "profiler.h"
+
+std::vector<Enemy> g_enemies;
+SpawnBatch g_enemyBatch;
+
+static float g_thinkBudgetUs = 500.0f;
+static size_t g_thinkCursor = 0;  // Round-robin position, so every enemy eventually gets a turn
+static EnemyAIStats g_aiStats;
+
+const float ENEMY_MOVE_FORCE = 8.0f;
+const float ENEMY_JUMP_IMPULSE = 4.0f;
+const float SIGHT_RANGE = 12.0f;
+const float PATROL_RADIUS = 4.0f;
+const float STEP_JUMP_HEIGHT = 0.4f;  // Rise ahead that triggers a jump
+
+void init_enemy_ai(float budgetUs) {
+    g_thinkBudgetUs = budgetUs;
+    g_thinkCursor = 0;
+}
+
+// ---------------- Spawning ----------------
+int spawn_enemies(b2WorldId world, const b2Transform* transforms, int count, const UserData& userData) {
+    constexpr ArchetypeDesc desc = Archetype<ENTITY_ENEMY>::desc;
+    BodyArchetype archetype = make_archetype<ENTITY_ENEMY>(userData);
+
+    size_t first = g_enemyBatch.bodies.size();
+    spawn_bodies(world, archetype, transforms, count, g_enemyBatch);
+
+    g_enemies.reserve(g_enemies.size() + count);
+    for (size_t i = first; i < g_enemyBatch.bodies.size(); ++i) {
+        b2BodyId body = g_enemyBatch.bodies[i];
+        b2ShapeId shape;
+        b2Body_GetShapes(body, &shape, 1);
+
+        Enemy e = {};
+        e.body = body;
+        e.controller = create_character_controller(body, shape, desc.halfW, desc.halfH,
+            ENEMY_MOVE_FORCE, ENEMY_JUMP_IMPULSE);
+        e.state = ENEMY_PATROL;
+        e.homeX = transforms[i - first].p.x;
+        e.targetX = e.homeX + PATROL_RADIUS;
+        e.thinkInterval = 0.5f;
+        e.sinceThink = static_cast<float>(i % 30) / 60.0f; // Stagger the first thinks
+        g_enemies.push_back(e);
+    }
+    return count;
+}
+
+void clear_enemies() {
+    // Enemy controllers were created after the player's, so remove from the back down
+    for (auto it = g_enemies.rbegin(); it != g_enemies.rend(); ++it) {
+        destroy_character_controller(it->controller);
+    }
+    g_enemies.clear();
+    destroy_spawn_batch(g_enemyBatch);
+    g_thinkCursor = 0;
+}
+
+// ---------------- Planning (expensive, time-sliced) ----------------
+static float think_interval(float distance) {
+    if (distance < 15.0f) return 0.1f;
+    if (distance < 40.0f) return 0.5f;
+    return 2.0f;
+}
+
+static void think(Enemy& e, b2Vec2 playerPos) {
+    b2Vec2 pos = b2Body_GetPosition(e.body);
+    float distance = fabsf(playerPos.x - pos.x) + fabsf(playerPos.y - pos.y);
+    e.thinkInterval = think_interval(distance);
+
+    // Sensing: result of the sight ray queued at the previous think
+    bool seesPlayer = e.sightQueued && !e.sight.hit && distance < SIGHT_RANGE;
+
+    bool navJump = false;
+    if (seesPlayer) {
+        e.state = ENEMY_CHASE;
+        e.targetX = playerPos.x;
+
+        // Follow the graph to the next waypoint so gaps and ledges are jumped, not walked into
+        static std::vector<NavPathPoint> path;
+        if (nav_find_path(pos, playerPos, path) && path.size() > 1) {
+            size_t next = fabsf(path[0].pos.x - pos.x) < 0.5f ? 1 : 0;
+            e.targetX = path[next].pos.x;
+            navJump = path[next].link == NAV_JUMP;
+        }
+    }
+    else if (e.state == ENEMY_CHASE) {
+        e.state = ENEMY_PATROL;
+        e.targetX = e.homeX;
+    }
+    else if (fabsf(e.targetX - pos.x) < 0.5f) {
+        // Patrol: turn around at either end
+        e.targetX = e.targetX > e.homeX ? e.homeX - PATROL_RADIUS : e.homeX + PATROL_RADIUS;
+    }
+
+    // Look ahead on the heightfield for rises worth jumping
+    float dir = e.targetX > pos.x ? 1.0f : -1.0f;
+    float hereY, aheadY;
+    if (terrain_height_at(pos.x, &hereY, nullptr) && terrain_height_at(pos.x + dir * 1.5f, &aheadY, nullptr)) {
+        e.wantJump = aheadY - hereY > STEP_JUMP_HEIGHT;
+    }
+    if (navJump) e.wantJump = true;
+
+    // Queue the next sight check; walls and boxes block it, other enemies don't
+    e.sightQueued = distance < SIGHT_RANGE;
+    if (e.sightQueued) {
+        b2QueryFilter filter = { CATEGORY_ENEMY, CATEGORY_GROUND | CATEGORY_BOX };
+        query_ray(pos, { playerPos.x - pos.x, playerPos.y - pos.y }, filter, &e.sight);
+    }
+    e.sinceThink = 0.0f;
+}
+
+// ---------------- Update ----------------
+void update_enemy_ai(b2Vec2 playerPos, float deltaTime) {
+    g_aiStats = {};
+    if (g_enemies.empty()) return;
+
+    // Steering every step: cheap, just feeds the character controllers
+    double t0 = profiler_now_us();
+    {
+        PROFILE_SCOPE("ai steer");
+        for (Enemy& e : g_enemies) {
+            CharacterController& c = g_controllers[e.controller];
+            float dx = e.targetX - b2Body_GetPosition(e.body).x;
+            c.moveInput = fmaxf(-1.0f, fminf(1.0f, dx));
+            if (fabsf(dx) < 0.2f) c.moveInput = 0.0f;
+            if (e.wantJump && c.grounded) {
+                c.jumpRequested = true;
+                e.wantJump = false;
+            }
+            e.sinceThink += deltaTime;
+        }
+    }
+    double t1 = profiler_now_us();
+    g_aiStats.steerUs = t1 - t0;
+
+    // Decisions: round-robin from the cursor, only enemies whose interval has elapsed,
+    // until the budget is gone. Near enemies have short intervals so they come up more often.
+    PROFILE_SCOPE("ai think");
+    size_t n = g_enemies.size();
+    double deadline = t1 + g_thinkBudgetUs;
+    size_t nextCursor = g_thinkCursor;
+    for (size_t scanned = 0; scanned < n; ++scanned) {
+        size_t index = (g_thinkCursor + scanned) % n;
+        Enemy& e = g_enemies[index];
+        if (e.sinceThink < e.thinkInterval) continue;
+        g_aiStats.due++;
+        if (profiler_now_us() > deadline) continue; // Keep counting what's due, but don't think
+        think(e, playerPos);
+        g_aiStats.thinks++;
+        nextCursor = (index + 1) % n;
+    }
+    g_thinkCursor = nextCursor;
+    g_aiStats.thinkUs = profiler_now_us() - t1;
+}
+
+const EnemyAIStats& enemy_ai_stats() {
+    return g_aiStats;
+}
+
+// ---------------- Benchmark ----------------
+static void bench_enemy_ai_once(int count, int frames) {
+    b2WorldDef worldDef = b2DefaultWorldDef();
+    worldDef.gravity = { 0.0f,-10.0f };
+    b2WorldId world = b2CreateWorld(&worldDef);
+
+    float halfLength = count * 0.75f + 20.0f;
+    b2BodyDef groundDef = b2DefaultBodyDef();
+    groundDef.position = { 0.0f,-5.0f };
+    b2BodyId ground = b2CreateBody(world, &groundDef);
+    b2Polygon groundShape = b2MakeBox(halfLength, 0.1f);
+    b2ShapeDef groundSD = b2DefaultShapeDef();
+    groundSD.filter = make_collision_filter(ENTITY_GROUND);
+    b2CreatePolygonShape(ground, &groundSD, &groundShape);
+
+    std::vector<b2Transform> transforms(count);
+    for (int i = 0; i < count; ++i) {
+        transforms[i] = { { -halfLength + 10.0f + i * 1.5f, -4.0f }, b2MakeRot(0.0f) };
+    }
+    UserData ud = { ENTITY_ENEMY, nullptr, 0, false, 0.0f, false, 1.0f };
+    clear_character_controllers();
+    spawn_enemies(world, transforms.data(), count, ud);
+
+    double steer = 0.0, thinkTime = 0.0;
+    long long thinks = 0;
+    float timeStep = 1.0f / 60.0f;
+    for (int frame = 0; frame < frames; ++frame) {
+        // Player sweeps across the field so enemies change distance bands
+        b2Vec2 player = { -halfLength + (2.0f * halfLength) * frame / frames, -4.0f };
+        update_enemy_ai(player, timeStep);
+        update_character_controllers(world, timeStep);
+        b2World_Step(world, timeStep, 8);
+        process_character_contact_events(world);
+        execute_queries(world);
+
+        steer += g_aiStats.steerUs;
+        thinkTime += g_aiStats.thinkUs;
+        thinks += g_aiStats.thinks;
+    }
+
+    std::cout << "  " << count << " enemies: steer " << steer / frames << " us/frame, think "
+        << thinkTime / frames << " us/frame, " << static_cast<double>(thinks) / frames << " thinks/frame" << std::endl;
+
+    clear_enemies();
+    clear_character_controllers();
+    b2DestroyWorld(world);
+}
+
+void bench_enemy_ai(int count) {
+    std::cout << "Enemy AI (think budget " << g_thinkBudgetUs << " us):" << std::endl;
+    bench_enemy_ai_once(count, 600);
+    bench_enemy_ai_once(count * 4, 600);
+    bench_enemy_ai_once(count * 16, 600);
+}
@@ -0,0 +1,53 @@
+// enemy_ai.h
+// Enemy AI: cheap steering every step, time-sliced sensing/planning within a per-frame budget
+
+#pragma once
+
+#include <vector>
+#include <box2d/box2d.h>
+#include "entity.h"
+#include "body_spawner.h"
+#include "query_service.h"
+
+enum EnemyState { ENEMY_IDLE, ENEMY_PATROL, ENEMY_CHASE };
+
+struct Enemy {
+    b2BodyId body;
+    int controller;       // Index into g_controllers
+    EnemyState state;
+    float homeX;
+    float targetX;
+    bool wantJump;        // Set by planning when the ground ahead rises, consumed by steering
+
+    // Time slicing
+    float sinceThink;     // Seconds since the last decision update
+    float thinkInterval;  // Shorter the closer the enemy is to the player
+
+    // Line of sight to the player, queued on the query service and read at the next think
+    RayQueryResult sight;
+    bool sightQueued;
+};
+
+struct EnemyAIStats {
+    int thinks;           // Decision updates run this frame
+    int due;              // Enemies that were due (thinks < due means the budget ran out)
+    double steerUs;
+    double thinkUs;
+};
+
+extern std::vector<Enemy> g_enemies;
+extern SpawnBatch g_enemyBatch;
+
+// Decision updates stop once budgetUs is spent; the rest continue next frame
+void init_enemy_ai(float budgetUs);
+
+// Spawns enemies with character controllers. Don't spawn between a think and execute_queries
+// (sight results point into g_enemies).
+int spawn_enemies(b2WorldId world, const b2Transform* transforms, int count, const UserData& userData);
+void clear_enemies();
+
+void update_enemy_ai(b2Vec2 playerPos, float deltaTime);
+const EnemyAIStats& enemy_ai_stats();
+
+// AI cost per frame at count, count*4 and count*16 enemies (headless)
+void bench_enemy_ai(int count);
@@ -0,0 +1,28 @@
+// entity.h
+// Entity types shared by gameplay, physics filtering and rendering
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+enum EntityType {
+    ENTITY_NONE, ENTITY_PLAYER, ENTITY_BOX, ENTITY_GROUND, ENTITY_BULLET,
+    ENTITY_DEBRIS, ENTITY_SENSOR, ENTITY_ENEMY,
+    ENTITY_TYPE_COUNT
+};
+
+struct UserData {
+    EntityType type;
+    glm::vec3* color;
+    GLuint textureID;
+    bool useTexture;
+
+    float animationTime;  // Track animation time for pulsing effect
+    bool isAnimating;     // Track if animation is active
+    float animationScale;
+
+    // Render extents in meters, filled from the entity's archetype so draw calls don't repeat them
+    float halfW = 0.0f;
+    float halfH = 0.0f;
+};
@@ -0,0 +1,34 @@
+// hw_counters.h
+// Per-thread hardware counter groups (cycles, instructions, L1D/LLC/branch misses) via perf_event_open
+
+#pragma once
+
+enum HwCounter {
+    HW_CYCLES,
+    HW_INSTRUCTIONS,
+    HW_L1D_MISSES,
+    HW_LLC_MISSES,
+    HW_BRANCH_MISSES,
+    HW_COUNTER_COUNT
+};
+
+struct HwCounterValues {
+    long long counts[HW_COUNTER_COUNT];  // -1 for counters the CPU/kernel didn't give us
+    long long enabled;                   // Nanoseconds the group has been enabled
+    long long running;                   // Nanoseconds it was actually on the PMU
+};
+
+// Reads the calling thread's counters; the group is opened on the thread's first read and
+// closed when the thread exits. Counts are user-mode only, so they work with perf_event_paranoid 2.
+// Returns false where perf_event_open isn't available (Windows, containers, paranoid 3).
+bool hw_counters_read(HwCounterValues& values);
+
+// Counts between two reads. When the kernel multiplexed the group with other events (the NMI
+// watchdog takes a counter too) they're scaled up by enabled/running; sets scaled in that case.
+// Returns false, with zeroed counts, when the group never got onto the PMU in between.
+bool hw_counters_delta(const HwCounterValues& from, const HwCounterValues& to, long long out[HW_COUNTER_COUNT], bool& scaled);
+
+// Probes the calling thread once and reports which counters opened
+bool hw_counters_available();
+
+const char* hw_counter_name(int counter);
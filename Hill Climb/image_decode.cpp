@@ -0,0 +1,257 @@
+// image_decode.cpp
+// Pluggable PNG/JPEG decode: libspng and libjpeg-turbo when built in, stb_image otherwise, into pooled buffers
+
+#include "image_decode.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+
+#include "stb/stb_image.h"
+
+#ifdef IMAGE_DECODE_SPNG
+#include <spng.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "spng.lib")
+#endif
+#endif
+
+#ifdef IMAGE_DECODE_TURBOJPEG
+#include <turbojpeg.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "turbojpeg.lib")
+#endif
+#endif
+
+// Same as stb's default limit; anything larger is a corrupt header, not a texture
+const int IMAGE_MAX_DIMENSION = 1 << 24;
+const size_t IMAGE_POOL_SIZE = 8;
+
+struct ImageDecoder {
+    const char* name;
+    bool (*accepts)(const unsigned char* data, size_t size, int channels);
+    bool (*decode)(const unsigned char* data, size_t size, int channels, bool flipVertical, DecodedImage& image);
+};
+
+// ---------------- Buffer Pool ----------------
+static std::mutex g_imagePoolLock;
+static std::vector<std::vector<unsigned char>> g_imagePool;
+
+static std::vector<unsigned char> acquire_buffer(size_t bytes) {
+    std::vector<unsigned char> buffer;
+    {
+        std::lock_guard<std::mutex> lock(g_imagePoolLock);
+        // Best fit: the smallest pooled buffer that already has the capacity
+        size_t best = g_imagePool.size();
+        for (size_t i = 0; i < g_imagePool.size(); ++i) {
+            if (g_imagePool[i].capacity() >= bytes && (best == g_imagePool.size() || g_imagePool[i].capacity() < g_imagePool[best].capacity())) best = i;
+        }
+        if (best < g_imagePool.size()) {
+            buffer = std::move(g_imagePool[best]);
+            g_imagePool.erase(g_imagePool.begin() + best);
+        }
+    }
+    buffer.resize(bytes);
+    return buffer;
+}
+
+static void return_buffer(std::vector<unsigned char>& buffer) {
+    if (buffer.capacity() == 0) return;
+    std::lock_guard<std::mutex> lock(g_imagePoolLock);
+    if (g_imagePool.size() < IMAGE_POOL_SIZE) g_imagePool.push_back(std::move(buffer));
+    buffer = std::vector<unsigned char>();
+}
+
+void release_image(DecodedImage& image) {
+    return_buffer(image.pixels);
+    image.width = image.height = image.channels = 0;
+    image.decoder = nullptr;
+}
+
+static void flip_rows(DecodedImage& image) {
+    size_t row = static_cast<size_t>(image.width) * image.channels;
+    std::vector<unsigned char> temp(row);
+    for (int y = 0; y < image.height / 2; ++y) {
+        unsigned char* a = image.pixels.data() + y * row;
+        unsigned char* b = image.pixels.data() + (image.height - 1 - y) * row;
+        memcpy(temp.data(), a, row);
+        memcpy(a, b, row);
+        memcpy(b, temp.data(), row);
+    }
+}
+
+// ---------------- Backends ----------------
+static bool is_png(const unsigned char* data, size_t size, int) {
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    return size >= 8 && memcmp(data, signature, 8) == 0;
+}
+
+static bool is_jpeg(const unsigned char* data, size_t size, int) {
+    return size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff;
+}
+
+#ifdef IMAGE_DECODE_SPNG
+static bool spng_accepts(const unsigned char* data, size_t size, int channels) {
+    // spng only expands to RGB(A); grey output is left to stb
+    return is_png(data, size, channels) && channels >= 3;
+}
+
+static bool decode_spng(const unsigned char* data, size_t size, int channels, bool flipVertical, DecodedImage& image) {
+    spng_ctx* ctx = spng_ctx_new(0);
+    if (!ctx) return false;
+    spng_set_image_limits(ctx, IMAGE_MAX_DIMENSION, IMAGE_MAX_DIMENSION);
+
+    int fmt = channels == 4 ? SPNG_FMT_RGBA8 : SPNG_FMT_RGB8;
+    struct spng_ihdr ihdr;
+    size_t bytes = 0;
+    bool ok = spng_set_png_buffer(ctx, data, size) == 0
+        && spng_get_ihdr(ctx, &ihdr) == 0
+        && spng_decoded_image_size(ctx, fmt, &bytes) == 0;
+    if (ok) {
+        image.width = static_cast<int>(ihdr.width);
+        image.height = static_cast<int>(ihdr.height);
+        image.pixels = acquire_buffer(bytes);
+        ok = spng_decode_image(ctx, image.pixels.data(), bytes, fmt, SPNG_DECODE_TRNS) == 0;
+    }
+    spng_ctx_free(ctx);
+    image.channels = channels;
+    if (ok && flipVertical) flip_rows(image);
+    return ok;
+}
+#endif
+
+#ifdef IMAGE_DECODE_TURBOJPEG
+static bool decode_turbojpeg(const unsigned char* data, size_t size, int channels, bool flipVertical, DecodedImage& image) {
+    tjhandle tj = tjInitDecompress();
+    if (!tj) return false;
+    int subsampling, colorspace;
+    bool ok = tjDecompressHeader3(tj, data, static_cast<unsigned long>(size), &image.width, &image.height, &subsampling, &colorspace) == 0
+        && image.width <= IMAGE_MAX_DIMENSION && image.height <= IMAGE_MAX_DIMENSION;
+    if (ok) {
+        int format = channels == 4 ? TJPF_RGBA : (channels == 3 ? TJPF_RGB : TJPF_GRAY);
+        image.pixels = acquire_buffer(static_cast<size_t>(image.width) * image.height * channels);
+        // Bottom-up output comes for free from the decoder's row pointers
+        ok = tjDecompress2(tj, data, static_cast<unsigned long>(size), image.pixels.data(), image.width, 0, image.height,
+            format, flipVertical ? TJFLAG_BOTTOMUP : 0) == 0;
+    }
+    tjDestroy(tj);
+    image.channels = channels;
+    return ok;
+}
+#endif
+
+static bool stb_accepts(const unsigned char*, size_t, int) {
+    return true;
+}
+
+static bool decode_stb(const unsigned char* data, size_t size, int channels, bool flipVertical, DecodedImage& image) {
+    // Never uses stbi_set_flip_vertically_on_load: it's process-wide state and decodes run on workers.
+    // stb allocates its own output (STBI_MALLOC is set where the implementation is compiled), so this
+    // backend pays one copy into the pooled buffer that the others decode into directly.
+    int fileChannels;
+    unsigned char* pixels = stbi_load_from_memory(data, static_cast<int>(size), &image.width, &image.height, &fileChannels, channels);
+    if (!pixels) return false;
+    size_t bytes = static_cast<size_t>(image.width) * image.height * channels;
+    image.pixels = acquire_buffer(bytes);
+    memcpy(image.pixels.data(), pixels, bytes);
+    stbi_image_free(pixels);
+    image.channels = channels;
+    if (flipVertical) flip_rows(image);
+    return true;
+}
+
+// Tried in order; the first that accepts the file and succeeds wins
+static const ImageDecoder g_imageDecoders[] = {
+#ifdef IMAGE_DECODE_SPNG
+    { "libspng", spng_accepts, decode_spng },
+#endif
+#ifdef IMAGE_DECODE_TURBOJPEG
+    { "libjpeg-turbo", is_jpeg, decode_turbojpeg },
+#endif
+    { "stb_image", stb_accepts, decode_stb },
+};
+
+// ---------------- Decode ----------------
+static bool run_decoder(const ImageDecoder& d, const unsigned char* data, size_t size, int channels, bool flipVertical, DecodedImage& image) {
+    if (!d.decode(data, size, channels, flipVertical, image)) {
+        return_buffer(image.pixels);
+        return false;
+    }
+    image.decoder = d.name;
+    return true;
+}
+
+bool decode_image_memory(const unsigned char* data, size_t size, int channels, bool flipVertical, DecodedImage& image) {
+    release_image(image);
+    if (channels != 1 && channels != 3 && channels != 4) return false;
+    for (const ImageDecoder& d : g_imageDecoders) {
+        if (d.accepts(data, size, channels) && run_decoder(d, data, size, channels, flipVertical, image)) return true;
+    }
+    return false;
+}
+
+static bool read_file(const char* path, std::vector<unsigned char>& data) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool ok = size > 0;
+    if (ok) {
+        data = acquire_buffer(static_cast<size_t>(size));
+        ok = fread(data.data(), 1, data.size(), f) == data.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+bool decode_image(const char* path, int channels, bool flipVertical, DecodedImage& image) {
+    std::vector<unsigned char> file;
+    bool ok = read_file(path, file) && decode_image_memory(file.data(), file.size(), channels, flipVertical, image);
+    return_buffer(file);
+    return ok;
+}
+
+void print_image_decoders() {
+    std::cout << "Image decoders:";
+    for (const ImageDecoder& d : g_imageDecoders) std::cout << " " << d.name;
+    std::cout << std::endl;
+}
+
+// ---------------- Benchmark ----------------
+void bench_image_decode(int iterations) {
+    const char* assets[] = { "box.png", "enemy2.png", "explosion.png", "player.jpg" };
+    print_image_decoders();
+    for (const char* path : assets) {
+        std::vector<unsigned char> file;
+        if (!read_file(path, file)) {
+            std::cout << "  " << path << ": not found (run from the asset directory)" << std::endl;
+            continue;
+        }
+        for (const ImageDecoder& d : g_imageDecoders) {
+            if (!d.accepts(file.data(), file.size(), 4)) continue;
+            DecodedImage image;
+            if (!run_decoder(d, file.data(), file.size(), 4, true, image)) {
+                std::cout << "  " << path << " " << d.name << ": failed" << std::endl;
+                continue;
+            }
+            release_image(image);
+
+            auto t0 = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                run_decoder(d, file.data(), file.size(), 4, true, image);
+                release_image(image);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t0).count() / iterations;
+            // Throughput in decoded megapixels, which is what the upload pays for
+            run_decoder(d, file.data(), file.size(), 4, true, image);
+            double mpix = static_cast<double>(image.width) * image.height / 1e6;
+            std::cout << "  " << path << " (" << image.width << "x" << image.height << ", " << file.size() / 1024 << " KB) "
+                << d.name << ": " << ms << " ms, " << mpix / (ms / 1000.0) << " Mpix/s" << std::endl;
+            release_image(image);
+        }
+        return_buffer(file);
+    }
+}
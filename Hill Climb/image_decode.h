@@ -0,0 +1,41 @@
+// image_decode.h
+// Pluggable PNG/JPEG decode: libspng and libjpeg-turbo when built in, stb_image otherwise, into pooled buffers
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Fast decoders are compiled in when their headers are found; define IMAGE_DECODE_STB_ONLY to opt out.
+// libspng picks up zlib-ng if it was built against it, nothing here depends on which zlib it uses.
+#if !defined(IMAGE_DECODE_STB_ONLY) && defined(__has_include)
+#if __has_include(<spng.h>)
+#define IMAGE_DECODE_SPNG 1
+#endif
+#if __has_include(<turbojpeg.h>)
+#define IMAGE_DECODE_TURBOJPEG 1
+#endif
+#endif
+
+struct DecodedImage {
+    int width = 0, height = 0;
+    int channels = 0;                   // As requested, not as stored in the file
+    const char* decoder = nullptr;      // Backend that produced the pixels
+    std::vector<unsigned char> pixels;  // Tightly packed rows, ready for glTexImage2D with GL_UNPACK_ALIGNMENT 1..4
+};
+
+// channels: 1, 3 or 4. flipVertical puts the bottom row first, as OpenGL expects.
+// Picks the backend from the file's signature, not its extension, and falls back to
+// stb_image if a fast decoder rejects the file. The fast decoders write straight into the
+// pooled buffer; stb_image's output is copied into it. Safe to call from worker threads.
+bool decode_image(const char* path, int channels, bool flipVertical, DecodedImage& image);
+bool decode_image_memory(const unsigned char* data, size_t size, int channels, bool flipVertical, DecodedImage& image);
+
+// Returns the pixel buffer to the pool for the next decode
+void release_image(DecodedImage& image);
+
+// Lists the compiled-in backends, fastest first
+void print_image_decoders();
+
+// Decode throughput per backend over the game's textures (headless)
+void bench_image_decode(int iterations);
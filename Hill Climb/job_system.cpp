@@ -0,0 +1,136 @@
+// job_system.cpp
+// Worker thread pool: fire-and-forget jobs tracked by counters, plus parallel_for
+
+#include "job_system.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+struct QueuedJob {
+    JobCounter* counter;
+    std::function<void()> fn;
+};
+
+static std::vector<std::thread> g_workers;
+static std::deque<QueuedJob> g_jobQueue;
+static std::mutex g_jobMutex;
+static std::condition_variable g_jobAvailable;
+static bool g_jobsQuit = false;
+static void (*g_workerStart)(int workerIndex) = nullptr;
+
+thread_local int t_workerIndex = 0;
+
+static bool try_pop_job(QueuedJob& job) {
+    std::lock_guard<std::mutex> lock(g_jobMutex);
+    if (g_jobQueue.empty()) return false;
+    job = std::move(g_jobQueue.front());
+    g_jobQueue.pop_front();
+    return true;
+}
+
+static void execute_job(QueuedJob& job) {
+    job.fn();
+    job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+static void worker_main(int index) {
+    t_workerIndex = index;
+    if (g_workerStart) g_workerStart(index);
+    for (;;) {
+        QueuedJob job;
+        {
+            std::unique_lock<std::mutex> lock(g_jobMutex);
+            g_jobAvailable.wait(lock, [] { return g_jobsQuit || !g_jobQueue.empty(); });
+            if (g_jobsQuit && g_jobQueue.empty()) return;
+            job = std::move(g_jobQueue.front());
+            g_jobQueue.pop_front();
+        }
+        execute_job(job);
+    }
+}
+
+void job_system_init(int workerCount) {
+    if (!g_workers.empty()) return;
+    if (workerCount <= 0) {
+        int hw = static_cast<int>(std::thread::hardware_concurrency());
+        workerCount = hw > 1 ? hw - 1 : 1;
+    }
+    g_jobsQuit = false;
+    for (int i = 0; i < workerCount; ++i) {
+        g_workers.emplace_back(worker_main, i + 1);
+    }
+}
+
+void job_system_set_thread_start(void (*onStart)(int workerIndex)) {
+    g_workerStart = onStart;
+}
+
+void job_system_shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(g_jobMutex);
+        g_jobsQuit = true;
+    }
+    g_jobAvailable.notify_all();
+    for (auto& t : g_workers) t.join();
+    g_workers.clear();
+}
+
+int job_system_worker_count() {
+    return static_cast<int>(g_workers.size());
+}
+
+int job_worker_index() {
+    return t_workerIndex;
+}
+
+void job_run(JobCounter& counter, std::function<void()> job) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    if (g_workers.empty()) {
+        // No pool (headless tools, init not called): run inline
+        QueuedJob inlineJob = { &counter, std::move(job) };
+        execute_job(inlineJob);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_jobMutex);
+        g_jobQueue.push_back({ &counter, std::move(job) });
+    }
+    g_jobAvailable.notify_one();
+}
+
+void job_wait(JobCounter& counter) {
+    while (counter.pending.load(std::memory_order_acquire) > 0) {
+        QueuedJob job;
+        if (try_pop_job(job)) execute_job(job);
+        else std::this_thread::yield();
+    }
+}
+
+bool job_try_execute() {
+    QueuedJob job;
+    if (!try_pop_job(job)) return false;
+    execute_job(job);
+    return true;
+}
+
+void parallel_for(int count, int minRange, const std::function<void(int begin, int end)>& fn) {
+    if (count <= 0) return;
+    if (minRange < 1) minRange = 1;
+
+    int threads = job_system_worker_count() + 1;
+    int rangeSize = (count + threads - 1) / threads;
+    if (rangeSize < minRange) rangeSize = minRange;
+
+    JobCounter counter;
+    // Last range runs on the calling thread
+    int begin = 0;
+    for (; begin + rangeSize < count; begin += rangeSize) {
+        int end = begin + rangeSize;
+        job_run(counter, [&fn, begin, end] { fn(begin, end); });
+    }
+    fn(begin, count);
+    job_wait(counter);
+}
@@ -0,0 +1,30 @@
+// job_system.h
+// Worker thread pool: fire-and-forget jobs tracked by counters, plus parallel_for
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+struct JobCounter {
+    std::atomic<int> pending{ 0 };
+};
+
+// workerCount <= 0 uses hardware_concurrency - 1 (the calling thread also runs jobs while waiting)
+void job_system_init(int workerCount = 0);
+void job_system_shutdown();
+// Runs at the start of every worker thread (affinity, priority); set before job_system_init
+void job_system_set_thread_start(void (*onStart)(int workerIndex));
+int job_system_worker_count();
+
+// Index of the current worker thread, 0 for the main/other threads
+int job_worker_index();
+
+void job_run(JobCounter& counter, std::function<void()> job);
+// Blocks until counter reaches zero, running queued jobs meanwhile
+void job_wait(JobCounter& counter);
+// Runs one queued job on the calling thread; false if the queue was empty
+bool job_try_execute();
+
+// Splits [0, count) into ranges of at least minRange and runs fn(begin, end) across the workers
+void parallel_for(int count, int minRange, const std::function<void(int begin, int end)>& fn);
@@ -5,8 +5,11 @@
 #include <cmath>
 #include <vector>
 #include <cstdlib> // For rand()
+#include <cstdio>
 #include <map>
 #include <string>
+#include <algorithm>
+#include <chrono>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -22,6 +25,33 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
+#include "entity.h"
+#include "collision_layers.h"
+#include "character_controller.h"
+#include "body_spawner.h"
+#include "archetypes.h"
+#include "profiler.h"
+#include "job_system.h"
+#include "query_service.h"
+#include "terrain.h"
+#include "enemy_ai.h"
+#include "nav_graph.h"
+#include "spatial_grid.h"
+#include "coins.h"
+#include "page_memory.h"
+#include "cooked_asset.h"
+#include "mip_chain.h"
+#include "image_decode.h"
+#include "text_shaping.h"
+#include "tracepoints.h"
+#include "scenario.h"
+#include "quality.h"
+#include "thread_config.h"
+#include "system_scheduler.h"
+#include "async_io.h"
+#include "ui_layer.h"
+#include "benchmarks.h"
+
 // ---------------- Settings ----------------
 const int WINDOW_WIDTH = 800;
 const int WINDOW_HEIGHT = 600;
@@ -36,25 +66,16 @@ GLint g_uColor;
 GLint g_uUseTexture;
 GLint g_uTexture;
 
-enum EntityType { ENTITY_NONE, ENTITY_PLAYER, ENTITY_BOX, ENTITY_GROUND, ENTITY_BULLET };
-
-struct UserData {
-    EntityType type;
-    glm::vec3* color;
-    GLuint textureID;
-    bool useTexture;
-
-    float animationTime;  // Track animation time for pulsing effect
-    bool isAnimating;     // Track if animation is active
-    float animationScale;
-};
-
 // Colors
 glm::vec3 g_playerColor(0.9f, 0.3f, 0.25f);
 glm::vec3 g_boxColor(0.2f, 0.5f, 0.8f);
 glm::vec3 g_yellowColor(1.0f, 1.0f, 0.0f);
 glm::vec3 g_groundColor(0.4f, 0.6f, 0.3f);
 glm::vec3 g_bulletColor(1.0f, 0.8f, 0.2f);
+glm::vec3 g_enemyColor(0.6f, 1.0f, 0.6f);
+
+// ---------------- Enemies ----------------
+const float ENEMY_THINK_BUDGET_US = 500.0f; // Per-frame budget for AI decision updates
 
 
 // ---------------- Particle System ----------------
@@ -67,8 +88,8 @@ struct Particle {
     float rotationSpeed;
 };
 
-const int MAX_PARTICLES = 100;
-std::vector<Particle> particles;
+// Particle budget comes from the quality preset (g_quality.maxParticles)
+std::vector<Particle, ReservationAllocator<Particle, particle_memory>> particles;
 GLuint g_particleTexture;
 float g_particleSize = 0.2f; // Size in meters
 
@@ -78,6 +99,43 @@ void spawn_explosion(const glm::vec2& position);
 void update_particles(float deltaTime);
 void render_particles(const glm::mat4& proj);
 
+// ---------------- Terrain ----------------
+const float TERRAIN_START_X = 50.0f;   // Hills continue from the right end of the flat ground
+const float TERRAIN_STREAM_RANGE = 2.0f * TERRAIN_CHUNK_WIDTH;
+const float TERRAIN_DEPTH = 6.0f;      // How far the terrain fill extends below the surface
+
+GLuint g_terrainVAO = 0;
+GLuint g_terrainVBO = 0;
+uint32_t g_terrainMeshRevision = 0;
+std::vector<int> g_terrainStripFirst; // One triangle strip per resident chunk
+int g_terrainStripLength = 0;
+
+void render_terrain(const glm::mat4& proj, GLuint texture);
+
+// ---------------- Coins ----------------
+GLuint g_coinProg = 0;
+GLuint g_coinVAO = 0;
+GLuint g_coinQuadVBO = 0;
+GLuint g_coinInstanceVBO = 0;
+GLint g_coinUMVP;
+GLint g_coinUTime;
+GLint g_coinURadius;
+GLint g_coinUColor;
+uint32_t g_coinMeshRevision = 0;
+glm::vec3 g_coinColor(1.0f, 0.82f, 0.2f);
+
+void render_coins(const glm::mat4& proj, float time);
+
+// ---------------- Archetype Batches ----------------
+GLuint g_archetypeProg = 0;
+GLuint g_archetypeVAO = 0;          // The square's vertices plus the instance attribute
+GLuint g_archetypeInstanceVBO = 0;
+GLint g_archetypeUMVP;
+GLint g_archetypeUHalfExtents;
+GLint g_archetypeUColor;
+GLint g_archetypeUUseTexture;
+GLint g_archetypeUTexture;
+
 
 
 // ---------------- Score System with Pixel Font ----------------
@@ -96,6 +154,10 @@ std::vector<FloatingText> floatingTexts;
 int currentScore = 0;
 bool wasPlayerNear = false;
 
+// Score triggers live in a spatial grid, so proximity checks don't scan every trigger
+SpatialGrid g_triggerGrid;
+std::vector<int> g_triggerHits;
+
 // Font rendering
 struct Character {
     GLuint textureID;
@@ -105,6 +167,7 @@ struct Character {
 };
 
 std::map<char, Character> characters;
+int g_textFont = -1;  // Shaping font for render_text's cached runs
 GLuint fontVAO, fontVBO;
 GLuint fontProgram;
 GLint font_uMVP, font_uTextColor, font_uTexture;
@@ -118,6 +181,13 @@ void render_text(const std::string& text, float x, float y, float scale,
 void spawn_score_popup(int points, const glm::vec2& position);
 void update_score_popups(float deltaTime);
 void render_score_popups(const glm::mat4& proj);
+std::string stats_overlay_text();
+
+bool g_showStats = false;
+SystemScheduler g_systems;          // Gameplay systems, rebuilt and run every frame
+bool g_printSystemsReport = false;  // Set by input, printed once the frame's systems are done
+bool g_writeChromeTrace = false;    // Same: workers are still recording while input runs
+glm::vec2 g_cameraOffset(0.0f); // Pixels the world is scrolled by; popups are placed in unscrolled pixels
 
 // ---------------- Shaders ----------------
 const char* vertex_shader_src = R"(
@@ -172,6 +242,51 @@ void main() {
 }
 )";
 
+// Coin shaders: one instanced quad per coin, spun and shaded in the shader
+const char* coin_vertex_shader_src = R"(
+#version 330 core
+layout(location = 0) in vec2 aPos;      // Unit quad corner, -1..1
+layout(location = 1) in vec3 aInstance; // xy = centre in meters, z = spin phase
+uniform mat4 uMVP;
+uniform float uTime;
+uniform float uRadius;
+out vec2 Local;
+void main() {
+    float spin = cos(uTime * 3.0 + aInstance.z);
+    Local = aPos;
+    gl_Position = uMVP * vec4(aInstance.xy + aPos * vec2(spin, 1.0) * uRadius, 0.0, 1.0);
+}
+)";
+
+// Archetype batch shader: one instanced square per body, layout from ArchetypeInstance<T> (archetypes.h)
+const char* archetype_vertex_shader_src = R"(
+#version 330 core
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aTexCoord;
+layout(location = 2) in vec3 aInstance; // xy = centre in meters, z = angle (0 for fixed-rotation layouts)
+uniform mat4 uMVP;
+uniform vec2 uHalfExtents;
+out vec2 TexCoord;
+void main() {
+    vec2 local = aPos * uHalfExtents * 2.0;
+    float c = cos(aInstance.z), s = sin(aInstance.z);
+    gl_Position = uMVP * vec4(aInstance.xy + vec2(c * local.x - s * local.y, s * local.x + c * local.y), 0.0, 1.0);
+    TexCoord = aTexCoord;
+}
+)";
+
+const char* coin_fragment_shader_src = R"(
+#version 330 core
+in vec2 Local;
+out vec4 FragColor;
+uniform vec3 uColor;
+void main() {
+    float d = length(Local);
+    if (d > 1.0) discard;
+    FragColor = vec4(mix(uColor, uColor * 0.6, smoothstep(0.7, 0.8, d)), 1.0);
+}
+)";
+
 // ---------------- Helpers ----------------
 GLuint compile_shader(const char* src, GLenum type) {
     GLuint s = glCreateShader(type);
@@ -192,49 +307,84 @@ GLuint link_program(GLuint vs, GLuint fs) {
 }
 
 // ---------------- Texture Loading ----------------
-GLuint load_texture(const char* path, bool flip_vertical = true) {
-    stbi_set_flip_vertically_on_load(flip_vertical);
+// Uploads a CPU-built chain level by level; the driver never generates mips
+void upload_mip_chain(const CookedTexture& texture) {
+    for (size_t level = 0; level < texture.mips.size(); ++level) {
+        const CookedMip& mip = texture.mips[level];
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_RGBA, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+            texture.pixels.data() + mip.offset);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.mips.size()) - 1);
+}
 
-    GLuint textureID;
-    glGenTextures(1, &textureID);
+// Textures read in one batch through async_io, decoded on job workers, uploaded here. Cooked files
+// go first; whatever has none (or one older than its source) is read and decoded from the source image
+// in a second batch.
+void load_textures(const char* const* paths, int count, GLuint* textures, bool flip_vertical = true) {
+    struct TextureLoad {
+        CookedTexture texture;
+        bool loaded = false;
+        bool cooked = false;
+    };
+    std::vector<TextureLoad> loads(count);
+    for (int i = 0; i < count; ++i) TRACE_PROBE1(texture_load_begin, paths[i]);
+
+    for (int pass = flip_vertical ? 0 : 1; pass < 2; ++pass) {
+        IoBatch batch;
+        std::vector<int> owners;
+        for (int i = 0; i < count; ++i) {
+            if (loads[i].loaded) continue;
+            std::string cooked = cooked_path(paths[i], ".tex");
+            if (pass == 0 && !cooked_is_current(paths[i], cooked)) continue;
+            async_io_add(batch, pass == 0 ? cooked : std::string(paths[i]));
+            owners.push_back(i);
+        }
+        if (owners.empty()) continue;
+        batch.onRead = [&](IoRequest& request) {
+            TextureLoad& load = loads[owners[&request - batch.requests.data()]];
+            if (request.ok && pass == 0) {
+                load.loaded = load.cooked = parse_cooked_texture(request.buffer.data, request.buffer.size, load.texture);
+            }
+            else if (request.ok) {
+                DecodedImage image;
+                if (decode_image_memory(request.buffer.data, request.buffer.size, 4, flip_vertical, image)) {
+                    build_mip_chain(load.texture, image.pixels.data(), image.width, image.height);
+                    release_image(image);
+                    load.loaded = true;
+                }
+            }
+            io_buffer_release(request.buffer);
+        };
+        async_io_submit(batch);
+        async_io_wait(batch);
+    }
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+    for (int i = 0; i < count; ++i) {
+        textures[i] = 0;
+        if (!loads[i].loaded) {
+            std::cout << "Texture failed to load at path: " << paths[i] << std::endl;
+            continue;
+        }
+        const CookedTexture& texture = loads[i].texture;
+        glGenTextures(1, &textures[i]);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        upload_mip_chain(texture);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        stbi_image_free(data);
+        TRACE_PROBE4(texture_load_end, paths[i], texture.mips[0].width, texture.mips[0].height, loads[i].cooked ? 1 : 0);
     }
-    else {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-        return 0;
-    }
-
-    return textureID;
 }
 
 // Create a procedural texture for testing if no image files are available
 GLuint create_procedural_texture(int width, int height, const glm::vec3& color1, const glm::vec3& color2) {
-    std::vector<unsigned char> data(width * height * 3);
+    std::vector<unsigned char> data(width * height * 4);
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
-            int idx = (y * width + x) * 3;
+            int idx = (y * width + x) * 4;
             bool pattern = (x / 16 + y / 16) % 2 == 0;
 
             if (pattern) {
@@ -247,14 +397,17 @@ GLuint create_procedural_texture(int width, int height, const glm::vec3& color1,
                 data[idx + 1] = static_cast<unsigned char>(color2.g * 255);
                 data[idx + 2] = static_cast<unsigned char>(color2.b * 255);
             }
+            data[idx + 3] = 255;
         }
     }
 
+    CookedTexture texture;
+    build_mip_chain(texture, data.data(), width, height);
+
     GLuint textureID;
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data.data());
-    glGenerateMipmap(GL_TEXTURE_2D);
+    upload_mip_chain(texture);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -298,6 +451,266 @@ GLuint create_square_vao_ebo() {
     return vao;
 }
 
+// ---------------- Terrain Rendering ----------------
+void rebuild_terrain_mesh() {
+    std::vector<float> vertices;
+    g_terrainStripFirst.clear();
+    g_terrainStripLength = (TERRAIN_CHUNK_SAMPLES + 1) * 2;
+
+    int first, last;
+    terrain_loaded_range(&first, &last);
+    for (int i = first; i <= last; ++i) {
+        const TerrainChunk* chunk = terrain_get_chunk(i);
+        if (!chunk) continue;
+        g_terrainStripFirst.push_back(static_cast<int>(vertices.size() / 4));
+        for (int k = 0; k <= TERRAIN_CHUNK_SAMPLES; ++k) {
+            float x = terrain_start_x() + (i * TERRAIN_CHUNK_SAMPLES + k) * TERRAIN_SAMPLE_SPACING;
+            float h = chunk->heights[k];
+            // Surface vertex then fill vertex; texture repeats every 2 meters
+            vertices.insert(vertices.end(), { x, h, x * 0.5f, h * 0.5f });
+            vertices.insert(vertices.end(), { x, h - TERRAIN_DEPTH, x * 0.5f, (h - TERRAIN_DEPTH) * 0.5f });
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, g_terrainVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    g_terrainMeshRevision = terrain_revision();
+}
+
+void render_terrain(const glm::mat4& proj, GLuint texture) {
+    if (g_terrainVAO == 0) {
+        glGenVertexArrays(1, &g_terrainVAO);
+        glGenBuffers(1, &g_terrainVBO);
+        glBindVertexArray(g_terrainVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, g_terrainVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+        glBindVertexArray(0);
+    }
+    // Only re-upload when chunks streamed in or out
+    if (g_terrainMeshRevision != terrain_revision()) rebuild_terrain_mesh();
+
+    // Vertices are in meters; same mapping to pixels as drawBody
+    glm::mat4 model(1.0f);
+    model = glm::translate(model, { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 0.0f });
+    model = glm::scale(model, { PIXELS_PER_METER, PIXELS_PER_METER, 1.0f });
+    glm::mat4 mvp = proj * model;
+
+    glUseProgram(g_prog);
+    glUniformMatrix4fv(g_uMVP, 1, GL_FALSE, glm::value_ptr(mvp));
+    glUniform3f(g_uColor, g_groundColor.r, g_groundColor.g, g_groundColor.b);
+    glUniform1i(g_uUseTexture, texture != 0);
+    glUniform1i(g_uTexture, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glBindVertexArray(g_terrainVAO);
+    for (int first : g_terrainStripFirst) {
+        glDrawArrays(GL_TRIANGLE_STRIP, first, g_terrainStripLength);
+    }
+    glBindVertexArray(0);
+}
+
+// ---------------- Coin Rendering ----------------
+void render_coins(const glm::mat4& proj, float time) {
+    if (g_coinVAO == 0) {
+        float quad[] = { -1.0f,-1.0f, 1.0f,-1.0f, -1.0f,1.0f, 1.0f,1.0f };
+        glGenVertexArrays(1, &g_coinVAO);
+        glGenBuffers(1, &g_coinQuadVBO);
+        glGenBuffers(1, &g_coinInstanceVBO);
+        glBindVertexArray(g_coinVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, g_coinQuadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, g_coinInstanceVBO);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(CoinInstance), (void*)0);
+        glVertexAttribDivisor(1, 1);
+        glBindVertexArray(0);
+    }
+
+    const std::vector<CoinInstance>& instances = coin_instances();
+    if (instances.empty()) return;
+    // Only re-upload when coins were placed or collected
+    if (g_coinMeshRevision != coin_revision()) {
+        glBindBuffer(GL_ARRAY_BUFFER, g_coinInstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(CoinInstance), instances.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        g_coinMeshRevision = coin_revision();
+    }
+
+    glm::mat4 model(1.0f);
+    model = glm::translate(model, { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 0.0f });
+    model = glm::scale(model, { PIXELS_PER_METER, PIXELS_PER_METER, 1.0f });
+    glm::mat4 mvp = proj * model;
+
+    glUseProgram(g_coinProg);
+    glUniformMatrix4fv(g_coinUMVP, 1, GL_FALSE, glm::value_ptr(mvp));
+    glUniform1f(g_coinUTime, time);
+    glUniform1f(g_coinURadius, COIN_RADIUS);
+    glUniform3f(g_coinUColor, g_coinColor.r, g_coinColor.g, g_coinColor.b);
+    glBindVertexArray(g_coinVAO);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instances.size()));
+    glBindVertexArray(0);
+}
+
+// ---------------- Scene Target ----------------
+// With a render scale below 1 or MSAA on, the world is drawn into an offscreen target and
+// blitted to the window. Multisampled targets are always resolved into a single-sampled RGBA8
+// target first: a scaled blit can't resolve, and a resolving blit into the window fails unless
+// the window's format matches exactly (BGRA, sRGB or no alpha all make it GL_INVALID_OPERATION).
+// The score HUD is drawn after the blit, at window resolution.
+GLuint g_sceneFBO = 0;
+GLuint g_sceneColor = 0;
+GLuint g_resolveFBO = 0;
+GLuint g_resolveColor = 0;
+int g_sceneWidth = WINDOW_WIDTH;
+int g_sceneHeight = WINDOW_HEIGHT;
+
+GLuint create_color_target(int width, int height, int samples, GLuint& color) {
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    if (samples > 0) glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+    else glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        glDeleteRenderbuffers(1, &color);
+        glDeleteFramebuffers(1, &fbo);
+        color = 0;
+        return 0;
+    }
+    return fbo;
+}
+
+void destroy_scene_target() {
+    if (g_resolveFBO) { glDeleteFramebuffers(1, &g_resolveFBO); glDeleteRenderbuffers(1, &g_resolveColor); }
+    if (g_sceneFBO) { glDeleteFramebuffers(1, &g_sceneFBO); glDeleteRenderbuffers(1, &g_sceneColor); }
+    g_sceneFBO = g_resolveFBO = 0;
+}
+
+void init_scene_target(float renderScale, int samples) {
+    destroy_scene_target();
+    g_sceneWidth = std::max(1, static_cast<int>(WINDOW_WIDTH * renderScale));
+    g_sceneHeight = std::max(1, static_cast<int>(WINDOW_HEIGHT * renderScale));
+    bool scaled = g_sceneWidth != WINDOW_WIDTH || g_sceneHeight != WINDOW_HEIGHT;
+    if (!scaled && samples <= 0) return; // Straight to the window
+
+    g_sceneFBO = create_color_target(g_sceneWidth, g_sceneHeight, samples, g_sceneColor);
+    if (g_sceneFBO && samples > 0) {
+        g_resolveFBO = create_color_target(g_sceneWidth, g_sceneHeight, 0, g_resolveColor);
+        if (!g_resolveFBO) destroy_scene_target();
+    }
+    if (!g_sceneFBO) {
+        std::cout << "Scene target unavailable, rendering at window resolution without MSAA" << std::endl;
+        g_sceneWidth = WINDOW_WIDTH;
+        g_sceneHeight = WINDOW_HEIGHT;
+    }
+}
+
+void begin_scene_target() {
+    if (!g_sceneFBO) return;
+    glBindFramebuffer(GL_FRAMEBUFFER, g_sceneFBO);
+    glViewport(0, 0, g_sceneWidth, g_sceneHeight);
+}
+
+void present_scene_target() {
+    if (!g_sceneFBO) return;
+    GLuint source = g_sceneFBO;
+    if (g_resolveFBO) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, g_sceneFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_resolveFBO);
+        glBlitFramebuffer(0, 0, g_sceneWidth, g_sceneHeight, 0, 0, g_sceneWidth, g_sceneHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        source = g_resolveFBO;
+    }
+    bool scaled = g_sceneWidth != WINDOW_WIDTH || g_sceneHeight != WINDOW_HEIGHT;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, g_sceneWidth, g_sceneHeight, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_COLOR_BUFFER_BIT, scaled ? GL_LINEAR : GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+}
+
+// Calibration's render workload: a screenful of blended quads at window resolution, GPU time included
+double measure_render_ms() {
+    const int quads = 2000;
+    const int frames = 20;
+    glm::mat4 proj = glm::ortho(0.0f, float(WINDOW_WIDTH), 0.0f, float(WINDOW_HEIGHT), -1.0f, 1.0f);
+    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(g_prog);
+    glBindVertexArray(g_vao);
+    glUniform1i(g_uUseTexture, false);
+    glUniform3f(g_uColor, 0.5f, 0.5f, 0.5f);
+
+    auto draw = [&]() {
+        glClear(GL_COLOR_BUFFER_BIT);
+        for (int i = 0; i < quads; ++i) {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), { static_cast<float>((i * 37) % WINDOW_WIDTH),
+                static_cast<float>((i * 53) % WINDOW_HEIGHT), 0.0f });
+            model = glm::scale(model, { 64.0f, 64.0f, 1.0f });
+            glm::mat4 mvp = proj * model;
+            glUniformMatrix4fv(g_uMVP, 1, GL_FALSE, glm::value_ptr(mvp));
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        }
+    };
+    draw();
+    glFinish(); // Shader compilation and first-use costs stay out of the timing
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) draw();
+    glFinish();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / frames;
+}
+
+// ---------------- Archetype Batches ----------------
+// Draws every body of one archetype in one instanced call: extents are compile-time constants,
+// the material is bound once and each body contributes only its ArchetypeInstance<T>
+template <EntityType T>
+void draw_archetype_batch(const glm::mat4& proj, const std::vector<b2BodyId>& bodies, const UserData& material) {
+    if (bodies.empty()) return;
+    constexpr ArchetypeDesc desc = Archetype<T>::desc;
+    static std::vector<ArchetypeInstance<T>> instances;
+    instances.clear();
+    for (b2BodyId b : bodies) instances.push_back(make_archetype_instance<T>(b));
+
+    glm::mat4 model(1.0f);
+    model = glm::translate(model, { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 0.0f });
+    model = glm::scale(model, { PIXELS_PER_METER, PIXELS_PER_METER, 1.0f });
+    glm::mat4 mvp = proj * model;
+
+    glm::vec3 color = material.color ? *material.color : glm::vec3(1.0f);
+    glUseProgram(g_archetypeProg);
+    glUniformMatrix4fv(g_archetypeUMVP, 1, GL_FALSE, glm::value_ptr(mvp));
+    glUniform2f(g_archetypeUHalfExtents, desc.halfW, desc.halfH);
+    glUniform3f(g_archetypeUColor, color.r, color.g, color.b);
+    glUniform1i(g_archetypeUUseTexture, material.useTexture);
+    glUniform1i(g_archetypeUTexture, 0);
+    if (material.useTexture && material.textureID != 0) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, material.textureID);
+    }
+
+    glBindVertexArray(g_archetypeVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, g_archetypeInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(ArchetypeInstance<T>), instances.data(), GL_STREAM_DRAW);
+    glVertexAttribPointer(2, archetype_instance_components<T>(), GL_FLOAT, GL_FALSE, sizeof(ArchetypeInstance<T>), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(instances.size()));
+
+    // Callers keep drawing single bodies with the square program
+    glBindVertexArray(g_vao);
+    glUseProgram(g_prog);
+}
+
 // ---------------- AABB ----------------
 struct AABB { float minX, minY, maxX, maxY; };
 
@@ -311,20 +724,13 @@ AABB getAABBWithProximity(b2BodyId body, float halfW, float halfH, float proximi
     };
 }
 
-bool aabbOverlap(const AABB& a, const AABB& b) {
-    return !(a.maxX<b.minX || a.minX>b.maxX || a.maxY<b.minY || a.minY>b.maxY);
-}
-
 // ---------------- Input ----------------
-void process_input(GLFWwindow* win, b2BodyId player) {
-    float moveForce = 20.0f;
-    float jumpImpulse = 6.0f;
-    if (glfwGetKey(win, GLFW_KEY_LEFT) == GLFW_PRESS) b2Body_ApplyForceToCenter(player, { -moveForce,0.0f }, true);
-    if (glfwGetKey(win, GLFW_KEY_RIGHT) == GLFW_PRESS) b2Body_ApplyForceToCenter(player, { moveForce,0.0f }, true);
-    if (glfwGetKey(win, GLFW_KEY_SPACE) == GLFW_PRESS) {
-        b2Vec2 vel = b2Body_GetLinearVelocity(player);
-        if (fabs(vel.y) < 0.01f) b2Body_ApplyLinearImpulseToCenter(player, { 0.0f,jumpImpulse }, true);
-    }
+void process_input(GLFWwindow* win, b2BodyId player, CharacterController& controller) {
+    // Movement and jumping are applied by the character controller (grounded state comes from contact events)
+    controller.moveInput = 0.0f;
+    if (glfwGetKey(win, GLFW_KEY_LEFT) == GLFW_PRESS) controller.moveInput -= 1.0f;
+    if (glfwGetKey(win, GLFW_KEY_RIGHT) == GLFW_PRESS) controller.moveInput += 1.0f;
+    controller.jumpRequested = glfwGetKey(win, GLFW_KEY_SPACE) == GLFW_PRESS;
     if (glfwGetKey(win, GLFW_KEY_R) == GLFW_PRESS) {
         b2Body_SetTransform(player, { 0.0f,10.0f }, b2MakeRot(0.0f));
         b2Body_SetLinearVelocity(player, { 0.0f,0.0f });
@@ -341,6 +747,76 @@ void process_input(GLFWwindow* win, b2BodyId player) {
     else {
         xKeyPressed = false;
     }
+    // Stats overlay on F3, Chrome trace of the last few seconds on F4, hardware counter report on F5,
+    // system timings and critical path on F6
+    static bool f3KeyPressed = false;
+    if (glfwGetKey(win, GLFW_KEY_F3) == GLFW_PRESS) {
+        if (!f3KeyPressed) {
+            g_showStats = !g_showStats;
+            f3KeyPressed = true;
+        }
+    }
+    else {
+        f3KeyPressed = false;
+    }
+    static bool f4KeyPressed = false;
+    if (glfwGetKey(win, GLFW_KEY_F4) == GLFW_PRESS) {
+        if (!f4KeyPressed) {
+            g_writeChromeTrace = true;
+            f4KeyPressed = true;
+        }
+    }
+    else {
+        f4KeyPressed = false;
+    }
+    static bool f5KeyPressed = false;
+    if (glfwGetKey(win, GLFW_KEY_F5) == GLFW_PRESS) {
+        if (!f5KeyPressed) {
+            profiler_print_hw_report();
+            f5KeyPressed = true;
+        }
+    }
+    else {
+        f5KeyPressed = false;
+    }
+    static bool f6KeyPressed = false;
+    if (glfwGetKey(win, GLFW_KEY_F6) == GLFW_PRESS) {
+        if (!f6KeyPressed) {
+            g_printSystemsReport = true;
+            f6KeyPressed = true;
+        }
+    }
+    else {
+        f6KeyPressed = false;
+    }
+    // Collision layer pair counts on C key
+    static bool cKeyPressed = false;
+    if (glfwGetKey(win, GLFW_KEY_C) == GLFW_PRESS) {
+        if (!cKeyPressed) {
+            print_collision_layer_stats(g_world);
+            cKeyPressed = true;
+        }
+    }
+    else {
+        cKeyPressed = false;
+    }
+    // Memory reservations, page faults and TLB misses on M key
+    static bool mKeyPressed = false;
+    if (glfwGetKey(win, GLFW_KEY_M) == GLFW_PRESS) {
+        if (!mKeyPressed) {
+            print_memory_reservations();
+            mKeyPressed = true;
+        }
+    }
+    else {
+        mKeyPressed = false;
+    }
+}
+
+// Key edges go on the profiler timeline, so hitch traces show what the player was doing
+void record_key_event(GLFWwindow*, int key, int, int action, int) {
+    if (action == GLFW_PRESS) profiler_instant("key down", key);
+    else if (action == GLFW_RELEASE) profiler_instant("key up", key);
 }
 
 // ---------------- Animation Functions ----------------
@@ -364,12 +840,8 @@ void update_box_animation(UserData* boxUD, float deltaTime, bool isPlayerNear) {
 
 
 // ---------------- Particle System Functions ----------------
+// The particle texture comes in main's startup texture batch
 void init_particle_system() {
-    particles.reserve(MAX_PARTICLES);
-
-    // Load the particle texture
-    g_particleTexture = load_texture("explosion.png");
-
     // If loading fails, create a simple fallback texture
     if (g_particleTexture == 0) {
         std::cout << "Failed to load particle.png, creating fallback texture" << std::endl;
@@ -403,10 +875,12 @@ void init_particle_system() {
             }
         }
 
+        CookedTexture texture;
+        build_mip_chain(texture, textureData.data(), TEX_SIZE, TEX_SIZE);
+
         glGenTextures(1, &g_particleTexture);
         glBindTexture(GL_TEXTURE_2D, g_particleTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TEX_SIZE, TEX_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData.data());
-        glGenerateMipmap(GL_TEXTURE_2D);
+        upload_mip_chain(texture);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -418,8 +892,9 @@ void init_particle_system() {
 void spawn_explosion(const glm::vec2& position) {
     // Create 10-15 particles for the explosion
     int numParticles = 10 + rand() % 6;
+    size_t liveBefore = particles.size();
 
-    for (int i = 0; i < numParticles && particles.size() < MAX_PARTICLES; ++i) {
+    for (int i = 0; i < numParticles && particles.size() < static_cast<size_t>(g_quality.maxParticles); ++i) {
         Particle p;
         p.position = position;
 
@@ -435,9 +910,11 @@ void spawn_explosion(const glm::vec2& position) {
 
         particles.push_back(p);
     }
+    TRACE_PROBE2(particle_spawn, particles.size() - liveBefore, particles.size());
 }
 
 void update_particles(float deltaTime) {
+    TRACE_PROBE1(particle_update_begin, particles.size());
     for (auto it = particles.begin(); it != particles.end(); ) {
         it->life -= deltaTime;
 
@@ -459,6 +936,7 @@ void update_particles(float deltaTime) {
             ++it;
         }
     }
+    TRACE_PROBE1(particle_update_end, particles.size());
 }
 
 void render_particles(const glm::mat4& proj) {
@@ -494,42 +972,116 @@ void render_particles(const glm::mat4& proj) {
 
 
 // ---------------- Font Rendering Functions ----------------
-void init_font_rendering() {
+// Load font (try a few common font paths)
+const char* fontPaths[] = {
+    "PressStart2P.ttf",  // Pixel font
+    "arial.ttf",
+    "C:/Windows/Fonts/arial.ttf",
+    "/usr/share/fonts/truetype/freefont/FreeSans.ttf",
+    "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf"
+};
+
+GLuint create_glyph_texture(int width, int height, const unsigned char* pixels) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+
+    // Set texture options - nearest-neighbor to keep pixel look
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+// Shaping uses the advances of the glyph textures just created plus the font's kerning pairs
+void register_text_font(const char* fontPath, int pixelSize, const std::vector<CookedKerning>& kerning) {
+    int advances[SHAPING_GLYPHS] = {};
+    for (const auto& entry : characters) {
+        unsigned char code = static_cast<unsigned char>(entry.first);
+        if (code < SHAPING_GLYPHS) advances[code] = static_cast<int>(entry.second.advance);
+    }
+    g_textFont = shaping_add_font(fontPath, pixelSize, advances, kerning);
+}
+
+// Glyphs pre-rasterized by Asset Cook, so startup skips FreeType entirely
+bool load_cooked_font() {
+    // Every candidate in one batch; the first in fontPaths order that parses wins
+    IoBatch batch;
+    for (const char* path : fontPaths) async_io_add(batch, cooked_path(path, ".font"));
+    async_io_submit(batch);
+    async_io_wait(batch);
+
+    CookedFont font;
+    const char* fontPath = nullptr;
+    for (size_t i = 0; i < batch.requests.size(); ++i) {
+        IoRequest& request = batch.requests[i];
+        if (!fontPath && request.ok && parse_cooked_font(request.buffer.data, request.buffer.size, font)) fontPath = fontPaths[i];
+        io_buffer_release(request.buffer);
+    }
+    if (!fontPath) return false;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, font.atlasWidth);
+    for (const CookedGlyph& g : font.glyphs) {
+        const unsigned char* pixels = font.atlas.data() + static_cast<size_t>(g.y) * font.atlasWidth + g.x;
+        Character character = {
+            create_glyph_texture(g.width, g.height, pixels),
+            glm::ivec2(g.width, g.height),
+            glm::ivec2(g.bearingX, g.bearingY),
+            static_cast<unsigned int>(g.advance)
+        };
+        characters.insert(std::pair<char, Character>(static_cast<char>(g.code), character));
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    std::cout << "Loaded cooked font: " << cooked_path(fontPath, ".font") << std::endl;
+    register_text_font(fontPath, font.pixelSize, font.kerning);
+    return true;
+}
+
+bool load_freetype_font() {
     // Initialize FreeType
     FT_Library ft;
     if (FT_Init_FreeType(&ft)) {
         std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-        return;
+        return false;
     }
 
-    // Load font (try a few common font paths)
-    const char* fontPaths[] = {
-        "PressStart2P.ttf",  // Pixel font
-        "arial.ttf",
-        "C:/Windows/Fonts/arial.ttf",
-        "/usr/share/fonts/truetype/freefont/FreeSans.ttf",
-        "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf"
-    };
+    // Font files come through async_io in one batch; FreeType reads the face from memory,
+    // so the chosen file's buffer has to outlive the face
+    IoBatch batch;
+    for (const char* fontPath : fontPaths) async_io_add(batch, fontPath);
+    async_io_submit(batch);
+    async_io_wait(batch);
 
     FT_Face face = 0;
     bool fontLoaded = false;
+    const char* loadedPath = nullptr;
+    IoBuffer fontFile;
 
-    for (const char* fontPath : fontPaths) {
-        if (FT_New_Face(ft, fontPath, 0, &face) == 0) {
+    for (size_t i = 0; i < batch.requests.size(); ++i) {
+        IoRequest& request = batch.requests[i];
+        if (!fontLoaded && request.ok &&
+            FT_New_Memory_Face(ft, request.buffer.data, static_cast<FT_Long>(request.buffer.size), 0, &face) == 0) {
             fontLoaded = true;
-            std::cout << "Loaded font: " << fontPath << std::endl;
-            break;
+            loadedPath = fontPaths[i];
+            fontFile = request.buffer;
+            std::cout << "Loaded font: " << loadedPath << std::endl;
+            continue;
         }
+        io_buffer_release(request.buffer);
     }
 
     if (!fontLoaded) {
         std::cout << "ERROR::FREETYPE: Failed to load any font" << std::endl;
         FT_Done_FreeType(ft);
-        return;
+        return false;
     }
 
     // Set size to load glyphs as
-    FT_Set_Pixel_Sizes(face, 0, 30); // Pixel font size
+    FT_Set_Pixel_Sizes(face, 0, TEXT_PIXEL_SIZE);
 
     // Disable byte-alignment restriction
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
@@ -543,26 +1095,7 @@ void init_font_rendering() {
         }
 
         // Generate texture
-        GLuint texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-
-        // Set texture options - nearest-neighbor to keep pixel look
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        GLuint texture = create_glyph_texture(face->glyph->bitmap.width, face->glyph->bitmap.rows, face->glyph->bitmap.buffer);
 
         // Now store character for later use
         Character character = {
@@ -574,9 +1107,18 @@ void init_font_rendering() {
         characters.insert(std::pair<char, Character>(c, character));
     }
 
+    register_text_font(loadedPath, TEXT_PIXEL_SIZE, extract_kerning(face));
+
     // Destroy FreeType once we're finished
     FT_Done_Face(face);
     FT_Done_FreeType(ft);
+    io_buffer_release(fontFile);
+
+    return true;
+}
+
+void init_font_rendering() {
+    if (!load_cooked_font() && !load_freetype_font()) return;
 
     // Configure font VAO/VBO for texture quads
     glGenVertexArrays(1, &fontVAO);
@@ -605,6 +1147,11 @@ void init_font_rendering() {
 void render_text(const std::string& text, float x, float y, float scale,
     const glm::vec3& color, const glm::vec3& shadowColor,
     const glm::vec2& shadowOffset) {
+    // Kerned glyph positions come from the run cache; HUD labels and popups repeat every frame
+    if (g_textFont < 0) return;
+    const ShapedRun& run = shape_text(g_textFont, text);
+    TRACE_PROBE2(text_render, text.c_str(), text.size());
+
     glUseProgram(fontProgram);
     glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(WINDOW_WIDTH),
         0.0f, static_cast<float>(WINDOW_HEIGHT));
@@ -616,13 +1163,12 @@ void render_text(const std::string& text, float x, float y, float scale,
     auto draw = [&](glm::vec3 c, float dx, float dy) {
         glUniform3f(font_uTextColor, c.r, c.g, c.b);
 
-        float xpos = x + dx;
         float ypos = y + dy;
 
-        for (auto ch : text) {
-            Character chdata = characters[ch];
+        for (const ShapedGlyph& g : run.glyphs) {
+            const Character& chdata = characters[static_cast<char>(g.code)];
 
-            float xposc = xpos + chdata.bearing.x * scale;
+            float xposc = x + dx + (g.x / 64.0f + chdata.bearing.x) * scale;
             float yposc = ypos - (chdata.size.y - chdata.bearing.y) * scale;
             float w = chdata.size.x * scale;
             float h = chdata.size.y * scale;
@@ -642,8 +1188,6 @@ void render_text(const std::string& text, float x, float y, float scale,
             glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
             glBindBuffer(GL_ARRAY_BUFFER, 0);
             glDrawArrays(GL_TRIANGLES, 0, 6);
-
-            xpos += (chdata.advance >> 6) * scale;
         }
         };
 
@@ -658,6 +1202,7 @@ void render_text(const std::string& text, float x, float y, float scale,
 
 
 void spawn_score_popup(int points, const glm::vec2& position) {
+    TRACE_PROBE2(score, points, currentScore);
     FloatingText ft;
     ft.text = "+" + std::to_string(points);
     ft.position = glm::vec2(position.x * PIXELS_PER_METER + WINDOW_WIDTH / 2.0f,
@@ -690,134 +1235,362 @@ void render_score_popups(const glm::mat4& proj) {
         float alpha = ft.life / ft.duration;
         glm::vec3 color = ft.color * alpha;
         glm::vec3 shadow = ft.shadowColor * alpha;
-        render_text(ft.text, ft.position.x, ft.position.y, ft.scale, color, shadow, ft.shadowOffset);
+        render_text(ft.text, ft.position.x - g_cameraOffset.x, ft.position.y - g_cameraOffset.y, ft.scale, color, shadow, ft.shadowOffset);
     }
 }
 
-// ---------------- Main ----------------
-int main() {
-    if (!glfwInit()) return -1;
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* win = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Box2D Textured Game", nullptr, nullptr);
-    if (!win) { glfwTerminate(); return -1; }
-    glfwMakeContextCurrent(win);
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) return -1;
-    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+// ---------------- Stats Overlay ----------------
+// One line per row of the overlay, redrawn by the UI layer whenever a number changes
+std::string stats_overlay_text() {
+    const ProfileFrame& frame = profiler_last_frame();
+    const FrameStats& s = frame.stats;
+    const b2Profile& p = s.physics;
+    const b2Counters& c = s.counters;
+
+    char lines[9][96];
+    int lineCount = 7;
+    snprintf(lines[0], sizeof(lines[0]), "frame %.2fms  steps %d", (s.end - s.start) / 1000.0, s.physicsSteps);
+    snprintf(lines[1], sizeof(lines[1]), "step %.2f pairs %.2f collide %.2f", p.step, p.pairs, p.collide);
+    snprintf(lines[2], sizeof(lines[2]), "solve %.2f ccd %.2f sleep %.2f", p.solve, p.bullets, p.sleepIslands);
+    snprintf(lines[3], sizeof(lines[3]), "bodies %d contacts %d", c.bodyCount, c.contactCount);
+    snprintf(lines[4], sizeof(lines[4]), "islands %d tasks %d", c.islandCount, c.taskCount);
+    snprintf(lines[5], sizeof(lines[5]), "render %.2fms", profiler_scope_ms(frame, "render"));
+    // Longest system on the update's critical path: the one that sets the frame time
+    std::vector<int> path;
+    double criticalMs = scheduler_critical_path(g_systems, path);
+    const char* slowest = "-";
+    double slowestMs = -1.0;
+    for (int i : path) {
+        double ms = g_systems.timings[i].end - g_systems.timings[i].start;
+        if (ms > slowestMs) { slowestMs = ms; slowest = g_systems.systems[i].name; }
+    }
+    snprintf(lines[6], sizeof(lines[6]), "critical %.2fms of %.2fms  %s", criticalMs,
+        (g_systems.frameEnd - g_systems.frameStart) / 1000.0, slowest);
+    // With --hw-counters: IPC and misses per element for the scopes that report elements;
+    // '~' marks multiplexed (scaled) counts
+    for (const char* name : { "particles", "draw bodies" }) {
+        ProfileHwScope hw;
+        if (!profiler_hw_scope(frame, name, hw) || hw.elements == 0) continue;
+        if (hw.uncounted > 0) {
+            snprintf(lines[lineCount], sizeof(lines[lineCount]), "%s counters not scheduled", name);
+        }
+        else {
+            snprintf(lines[lineCount], sizeof(lines[lineCount]), "%s ipc %.2f L1D %.2f LLC %.3f /elem%s", name,
+                hw.counts[HW_CYCLES] > 0 ? static_cast<double>(hw.counts[HW_INSTRUCTIONS]) / hw.counts[HW_CYCLES] : 0.0,
+                static_cast<double>(hw.counts[HW_L1D_MISSES]) / hw.elements, static_cast<double>(hw.counts[HW_LLC_MISSES]) / hw.elements,
+                hw.multiplexed > 0 ? " ~" : "");
+        }
+        lineCount++;
+    }
+
+    std::string text;
+    for (int i = 0; i < lineCount; ++i) text += std::string(lines[i]) + "\n";
+    return text;
+}
 
-    GLuint vs = compile_shader(vertex_shader_src, GL_VERTEX_SHADER);
-    GLuint fs = compile_shader(fragment_shader_src, GL_FRAGMENT_SHADER);
-    g_prog = link_program(vs, fs);
-    glDeleteShader(vs); glDeleteShader(fs);
+// ---------------- UI Layer ----------------
+// HUD widgets (ui_layer.h) are drawn into a window-sized texture only where their content changed,
+// and the texture goes over the frame as one quad. Score popups move with the world and stay immediate.
+GLuint g_uiFBO = 0;
+GLuint g_uiTexture = 0;
+int g_hudScore = -1;
+int g_hudSpeed = -1;
+int g_hudStats = -1;
+
+void init_ui_layer() {
+    glGenTextures(1, &g_uiTexture);
+    glBindTexture(GL_TEXTURE_2D, g_uiTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, WINDOW_WIDTH, WINDOW_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // Always drawn 1:1
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glGenFramebuffers(1, &g_uiFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_uiFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_uiTexture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cout << "UI layer texture unavailable, drawing the HUD every frame" << std::endl;
+        glDeleteFramebuffers(1, &g_uiFBO);
+        glDeleteTextures(1, &g_uiTexture);
+        g_uiFBO = g_uiTexture = 0;
+    }
 
-    g_vao = create_square_vao_ebo();
-    g_uMVP = glGetUniformLocation(g_prog, "uMVP");
-    g_uColor = glGetUniformLocation(g_prog, "uColor");
-    g_uUseTexture = glGetUniformLocation(g_prog, "uUseTexture");
-    g_uTexture = glGetUniformLocation(g_prog, "uTexture");
+    // Rects cover the text and its shadow
+    g_hudScore = ui_add_widget("score", { 10, WINDOW_HEIGHT - 60, 360, 50 }, [](const UiWidget& w) {
+        render_text(w.content, 20.0f, WINDOW_HEIGHT - 40.0f, 0.8f, glm::vec3(1, 1, 1), glm::vec3(0.2f, 0.6f, 1.0f), glm::vec2(2, -2));
+    });
+    g_hudSpeed = ui_add_widget("speed", { WINDOW_WIDTH - 190, WINDOW_HEIGHT - 50, 180, 35 }, [](const UiWidget& w) {
+        render_text(w.content, WINDOW_WIDTH - 180.0f, WINDOW_HEIGHT - 38.0f, 0.5f, glm::vec3(1, 1, 1), glm::vec3(0.2f, 0.6f, 1.0f), glm::vec2(2, -2));
+    });
+    g_hudStats = ui_add_widget("stats", { 10, WINDOW_HEIGHT - 210, 520, 155 }, [](const UiWidget& w) {
+        float y = WINDOW_HEIGHT - 70.0f;
+        for (size_t start = 0, end; (end = w.content.find('\n', start)) != std::string::npos; start = end + 1) {
+            render_text(w.content.substr(start, end - start), 20.0f, y, 0.35f, glm::vec3(0.8f, 1.0f, 0.8f), glm::vec3(0.0f), glm::vec2(1, -1));
+            y -= 16.0f;
+        }
+    });
+    ui_invalidate();
+}
 
-    // Load textures (or create procedural ones if files not available)
-    GLuint playerTexture = load_texture("enemy2.png");
-    if (playerTexture == 0) {
-        playerTexture = create_procedural_texture(64, 64, glm::vec3(0.9f, 0.3f, 0.25f), glm::vec3(0.7f, 0.2f, 0.2f));
+void destroy_ui_layer() {
+    if (g_uiFBO) {
+        glDeleteFramebuffers(1, &g_uiFBO);
+        glDeleteTextures(1, &g_uiTexture);
     }
+    g_uiFBO = g_uiTexture = 0;
+    ui_clear_widgets();
+}
 
-    GLuint boxTexture = load_texture("playegr.png");
-    if (boxTexture == 0) {
-        boxTexture = create_procedural_texture(64, 64, glm::vec3(0.2f, 0.5f, 0.8f), glm::vec3(0.1f, 0.3f, 0.6f));
+// Updates widget content and redraws the dirty regions of the layer; no GL work when nothing changed
+void update_ui_layer(b2BodyId player) {
+    b2Vec2 velocity = b2Body_GetLinearVelocity(player);
+    char speed[32];
+    snprintf(speed, sizeof(speed), "%d km/h", static_cast<int>(std::fabs(velocity.x) * 3.6f + 0.5f));
+    ui_set_content(g_hudScore, "Score:" + std::to_string(currentScore));
+    ui_set_content(g_hudSpeed, speed);
+    ui_set_visible(g_hudStats, g_showStats);
+    if (g_showStats) ui_set_content(g_hudStats, stats_overlay_text());
+
+    static std::vector<UiRect> regions;
+    static std::vector<const UiWidget*> widgets;
+    ui_take_dirty_regions(WINDOW_WIDTH, WINDOW_HEIGHT, regions);
+    if (!g_uiFBO || regions.empty()) return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, g_uiFBO);
+    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+    glEnable(GL_SCISSOR_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    // Premultiplied alpha in the layer, so compositing it is a single ONE / ONE_MINUS_SRC_ALPHA blend
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    for (const UiRect& region : regions) {
+        glScissor(region.x, region.y, region.width, region.height);
+        glClear(GL_COLOR_BUFFER_BIT);
+        ui_widgets_in(region, widgets);
+        int glyphs = 0;
+        for (const UiWidget* w : widgets) {
+            w->draw(*w);
+            glyphs += static_cast<int>(w->content.size());
+        }
+        ui_record_redraw(region, static_cast<int>(widgets.size()), glyphs);
     }
+    glDisable(GL_SCISSOR_TEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+}
 
-    GLuint groundTexture = load_texture("ground_texture.png");
-    if (groundTexture == 0) {
-        groundTexture = create_procedural_texture(64, 64, glm::vec3(0.4f, 0.6f, 0.3f), glm::vec3(0.3f, 0.5f, 0.2f));
+// The whole HUD in one draw call
+void composite_ui_layer(const glm::mat4& proj) {
+    if (!g_uiFBO) {
+        for (int widget : { g_hudScore, g_hudSpeed, g_hudStats }) {
+            const UiWidget& w = ui_widget(widget);
+            if (w.visible) w.draw(w);
+        }
+        ui_end_frame();
+        return;
     }
+    glUseProgram(g_prog);
+    glBindVertexArray(g_vao);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, g_uiTexture);
+    glUniform1i(g_uTexture, 0);
+    glUniform1i(g_uUseTexture, true);
+    glUniform3f(g_uColor, 1.0f, 1.0f, 1.0f);
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 0.0f });
+    model = glm::scale(model, { static_cast<float>(WINDOW_WIDTH), static_cast<float>(WINDOW_HEIGHT), 1.0f });
+    glm::mat4 mvp = proj * model;
+    glUniformMatrix4fv(g_uMVP, 1, GL_FALSE, glm::value_ptr(mvp));
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    ui_end_frame();
+}
 
-    // Initialize bullet system
-    init_particle_system();
+// ---------------- Scene ----------------
+// Bodies and materials the frame loop works on, built from a scenario (the default one is the game's own scene)
+struct Scene {
+    b2BodyId ground;
+    b2BodyId player;
+    b2BodyId box;
+    UserData* groundUD;
+    UserData* playerUD;
+    int boxIndex;                 // Into boxBatch; spawning into the batch may move its user data, so no pointer is kept
+    UserData boxTemplate;
+    UserData enemyTemplate;
+    UserData vehicleTemplate;
+    UserData stressBoxTemplate;   // Own color: the scoring box's one flashes when the player is near
+    BodyArchetype stressBoxArchetype;
+    SpawnBatch boxBatch;          // The scoring box
+    SpawnBatch stressBoxes;       // Extra boxes from the scenario and its spawn events
+    SpawnBatch vehicleBatch;      // Extra player characters
+    std::vector<int> controllers; // Player first, then one per extra vehicle
+    int boxTrigger;
+    bool playerNear = false;      // Written by the proximity system, read by the box animation
+};
 
-    // Initialize font rendering
-    init_font_rendering();
+// Boxes in a stack of columns, bottom row centered on base
+void spawn_box_stack(Scene& scene, int count, b2Vec2 base) {
+    constexpr ArchetypeDesc boxDesc = Archetype<ENTITY_BOX>::desc;
+    const int columns = 10;
+    float spacing = boxDesc.halfW * 2.0f + 0.1f;
+    std::vector<b2Transform> transforms(count);
+    for (int i = 0; i < count; ++i) {
+        transforms[i].p = { base.x + (i % columns - columns / 2) * spacing, base.y + (i / columns) * spacing };
+        transforms[i].q = b2MakeRot(0.0f);
+    }
+    spawn_bodies(g_world, scene.stressBoxArchetype, transforms.data(), count, scene.stressBoxes);
+}
 
-    // Box2D world
-    b2WorldDef worldDef = b2DefaultWorldDef();
-    worldDef.gravity = { 0.0f,-10.0f };
-    g_world = b2CreateWorld(&worldDef);
+void create_scene(const Scenario& scenario, GLuint playerTexture, GLuint boxTexture, GLuint groundTexture, Scene& scene) {
+    // Sizes, densities, frictions and filters come from the archetype table (archetypes.h)
+    constexpr ArchetypeDesc groundDesc = Archetype<ENTITY_GROUND>::desc;
+    constexpr ArchetypeDesc playerDesc = Archetype<ENTITY_PLAYER>::desc;
+    constexpr ArchetypeDesc boxDesc = Archetype<ENTITY_BOX>::desc;
 
     // Ground
-    b2BodyDef groundDef = b2DefaultBodyDef();
-    groundDef.type = b2_staticBody;
-    groundDef.position = { 0.0f,-5.0f };
-    b2BodyId ground = b2CreateBody(g_world, &groundDef);
-    UserData* groundUD = new UserData{ ENTITY_GROUND, &g_groundColor, groundTexture, true, 0.0f, false, 1.0f };
-    b2Body_SetUserData(ground, groundUD);
-    b2Polygon groundShape = b2MakeBox(50.0f, 0.1f);
-    b2ShapeDef groundSD = b2DefaultShapeDef();
-    b2CreatePolygonShape(ground, &groundSD, &groundShape);
+    scene.groundUD = new UserData{ ENTITY_GROUND, &g_groundColor, groundTexture, true, 0.0f, false, 1.0f };
+    scene.ground = spawn_archetype<ENTITY_GROUND>(g_world, { 0.0f,-5.0f }, scene.groundUD);
 
     // Player
-    b2BodyDef playerDef = b2DefaultBodyDef();
-    playerDef.type = b2_dynamicBody;
-    playerDef.position = { 0.0f,10.0f };
-    b2BodyId player = b2CreateBody(g_world, &playerDef);
-    UserData* playerUD = new UserData{ ENTITY_PLAYER,nullptr, playerTexture,true, 0.0f, false, 1.0f };
-    b2Body_SetUserData(player, playerUD);
-    b2Polygon playerShape = b2MakeBox(1.0f, 1.0f);
-    b2ShapeDef playerSD = b2DefaultShapeDef(); playerSD.density = 1.0f; playerSD.material.friction = 0.3f;
-    b2CreatePolygonShape(player, &playerSD, &playerShape);
-
-    // Single Box
-    b2BodyDef boxDef = b2DefaultBodyDef();
-    boxDef.type = b2_dynamicBody;
-    boxDef.position = { 2.0f,6.0f };
-    b2BodyId box = b2CreateBody(g_world, &boxDef);
-    UserData* boxUD = new UserData{ ENTITY_BOX, new glm::vec3(g_boxColor), boxTexture, true, 0.0f, false, 1.0f };
-    b2Body_SetUserData(box, boxUD);
-    b2Polygon boxShape = b2MakeBox(0.5f, 0.5f);
-    b2ShapeDef boxSD = b2DefaultShapeDef(); boxSD.density = 1.0f; boxSD.material.friction = 0.3f;
-    b2CreatePolygonShape(box, &boxSD, &boxShape);
-
-    float timeStep = 1.0f / 60.0f;
-    glm::mat4 proj = glm::ortho(0.0f, float(WINDOW_WIDTH), 0.0f, float(WINDOW_HEIGHT), -1.0f, 1.0f);
-    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-
-    // Tells OpenGL to properly handle the alpha channel in your PNGs
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    scene.playerUD = new UserData{ ENTITY_PLAYER,nullptr, playerTexture,true, 0.0f, false, 1.0f };
+    scene.player = spawn_archetype<ENTITY_PLAYER>(g_world, { 0.0f,10.0f }, scene.playerUD);
+    b2ShapeId playerShapeId;
+    b2Body_GetShapes(scene.player, &playerShapeId, 1);
+    scene.controllers.push_back(create_character_controller(scene.player, playerShapeId, playerDesc.halfW, playerDesc.halfH, 20.0f, 6.0f));
+
+    // Extra vehicles drop in a row behind the player and take the same input
+    scene.vehicleTemplate = UserData{ ENTITY_PLAYER, nullptr, playerTexture, true, 0.0f, false, 1.0f };
+    std::vector<b2Transform> vehicleTransforms;
+    for (int i = 1; i < scenario.vehicles; ++i) {
+        vehicleTransforms.push_back({ { -1.5f * i, 10.0f }, b2MakeRot(0.0f) });
+    }
+    spawn_bodies(g_world, make_archetype<ENTITY_PLAYER>(scene.vehicleTemplate), vehicleTransforms.data(),
+        static_cast<int>(vehicleTransforms.size()), scene.vehicleBatch);
+    for (b2BodyId body : scene.vehicleBatch.bodies) {
+        b2ShapeId shape;
+        b2Body_GetShapes(body, &shape, 1);
+        scene.controllers.push_back(create_character_controller(body, shape, playerDesc.halfW, playerDesc.halfH, 20.0f, 6.0f));
+    }
 
-    // For tracking time between frames
-    float lastTime = glfwGetTime();
+    // Navigation graph over the flat ground; terrain chunks join and leave it as they stream
+    nav_add_box(NAV_SOURCE_GROUND, { 0.0f,-5.0f }, groundDesc.halfW, groundDesc.halfH);
+
+    // Hill terrain, streamed in chunks around the player
+    init_terrain(g_world, scenario.terrainSeed, TERRAIN_START_X, -4.9f);
+    terrain_add_chunk_listener(nav_on_terrain_chunk);
+    init_coins();
+    terrain_add_chunk_listener(coins_on_terrain_chunk);
+    update_terrain_streaming(0.0f, TERRAIN_STREAM_RANGE);
+
+    // Single Box (through the bulk spawner, so larger box sets only need more transforms)
+    scene.boxTemplate = UserData{ ENTITY_BOX, new glm::vec3(g_boxColor), boxTexture, true, 0.0f, false, 1.0f };
+    BodyArchetype boxArchetype = make_archetype<ENTITY_BOX>(scene.boxTemplate);
+    b2Transform boxTransforms[] = { { { 2.0f,6.0f }, b2MakeRot(0.0f) } };
+    spawn_bodies(g_world, boxArchetype, boxTransforms, 1, scene.boxBatch);
+    scene.boxIndex = 0;
+    scene.box = scene.boxBatch.bodies[scene.boxIndex];
+    grid_init(g_triggerGrid, 4.0f, 256);
+    scene.boxTrigger = grid_insert(g_triggerGrid, boxTransforms[0].p, boxDesc.halfW, boxDesc.halfH);
+    scene.stressBoxTemplate = UserData{ ENTITY_BOX, &g_boxColor, boxTexture, true, 0.0f, false, 1.0f };
+    scene.stressBoxArchetype = make_archetype<ENTITY_BOX>(scene.stressBoxTemplate);
+    if (scenario.boxes > 1) spawn_box_stack(scene, scenario.boxes - 1, { 25.0f, -4.0f });
+
+    // Enemies patrol the flat ground to the right of the spawn
+    init_enemy_ai(ENEMY_THINK_BUDGET_US);
+    std::vector<b2Transform> enemyTransforms;
+    for (int i = 0; i < scenario.enemies; ++i) {
+        enemyTransforms.push_back({ { 10.0f + i * 1.5f, -4.0f }, b2MakeRot(0.0f) });
+    }
+    scene.enemyTemplate = UserData{ ENTITY_ENEMY, &g_enemyColor, playerTexture, true, 0.0f, false, 1.0f };
+    spawn_enemies(g_world, enemyTransforms.data(), scenario.enemies, scene.enemyTemplate);
+}
 
-    while (!glfwWindowShouldClose(win)) {
-        // Calculate delta time
-        float currentTime = glfwGetTime();
-        float deltaTime = currentTime - lastTime;
-        lastTime = currentTime;
+void destroy_scene(Scene& scene) {
+    delete scene.playerUD;
+    delete scene.boxTemplate.color;
+    delete scene.groundUD;
+}
 
-        process_input(win, player);
-        b2World_Step(g_world, timeStep, 8);
+// Scripted input for every vehicle, plus the one-shot key events due this frame
+void apply_scenario_input(Scene& scene, const ScenarioPlayback& playback, const std::vector<ScenarioEvent>& events) {
+    bool jump = playback.held[SCENARIO_KEY_JUMP];
+    for (const ScenarioEvent& e : events) {
+        b2Vec2 pos = b2Body_GetPosition(scene.player);
+        switch (e.type) {
+        case SCENARIO_JUMP: jump = true; break;
+        case SCENARIO_EXPLODE: spawn_explosion(glm::vec2(pos.x, pos.y)); break;
+        case SCENARIO_RESET:
+            b2Body_SetTransform(scene.player, { 0.0f,10.0f }, b2MakeRot(0.0f));
+            b2Body_SetLinearVelocity(scene.player, { 0.0f,0.0f });
+            break;
+        case SCENARIO_SPAWN_BOXES: spawn_box_stack(scene, e.count, e.position); break;
+        default: break;
+        }
+    }
+    for (int index : scene.controllers) {
+        CharacterController& controller = g_controllers[index];
+        controller.moveInput = (playback.held[SCENARIO_KEY_RIGHT] ? 1.0f : 0.0f) - (playback.held[SCENARIO_KEY_LEFT] ? 1.0f : 0.0f);
+        controller.jumpRequested = jump;
+    }
+}
 
-        // Update particles
+// Everything in a frame after input and before rendering; the data each system touches is
+// declared in g_gameSystems (system_scheduler.h)
+void add_update_systems(SystemScheduler& systems, Scene& scene, float deltaTime, float timeStep) {
+    scheduler_add(systems, SYSTEM_ENEMY_AI, [&scene, timeStep] {
+        update_enemy_ai(b2Body_GetPosition(scene.player), timeStep);
+    });
+    scheduler_add(systems, SYSTEM_CONTROLLERS, [timeStep] {
+        update_character_controllers(g_world, timeStep);
+    });
+
+    // Step timings and Box2D's own phase breakdown go to the profiler
+    scheduler_add(systems, SYSTEM_PHYSICS, [timeStep] {
+        double stepStart = profiler_now_us();
+        TRACE_PROBE1(physics_step_begin, g_quality.subSteps);
+        b2World_Step(g_world, timeStep, g_quality.subSteps);
+        profiler_sample_box2d(g_world, stepStart, profiler_now_us());
+    });
+
+    // Ray/shape/overlap queries queued since the last step
+    scheduler_add(systems, SYSTEM_QUERIES, [] { execute_queries(g_world); });
+
+    scheduler_add(systems, SYSTEM_CONTACT_EVENTS, [] {
+        process_character_contact_events(g_world);
+        record_collision_layer_events(g_world);
+    });
+
+    scheduler_add(systems, SYSTEM_PARTICLES, [deltaTime] {
+        profiler_elements("particles", static_cast<long long>(particles.size()));
         update_particles(deltaTime);
-        
-
-        // Update score popups
-        update_score_popups(deltaTime);
-
-        // --- 1-meter proximity AABB ---
-        AABB playerBox = getAABBWithProximity(player, 1.0f, 1.0f, 1.0f); // 1 meter
-        *(boxUD->color) = g_boxColor; // reset
-        AABB boxAABB = getAABBWithProximity(box, 0.5f, 0.5f, 0.0f); // box normal size
-
-        bool isPlayerNear = aabbOverlap(playerBox, boxAABB);
-        if (isPlayerNear) {
-            *(boxUD->color) = g_yellowColor;
+    });
+    scheduler_add(systems, SYSTEM_POPUPS, [deltaTime] { update_score_popups(deltaTime); });
+
+    // --- 1-meter proximity AABB ---
+    scheduler_add(systems, SYSTEM_PROXIMITY, [&scene] {
+        constexpr ArchetypeDesc playerDesc = Archetype<ENTITY_PLAYER>::desc;
+        AABB playerBox = getAABBWithProximity(scene.player, playerDesc.halfW, playerDesc.halfH, 1.0f); // 1 meter
+        UserData& boxUD = scene.boxBatch.userData[scene.boxIndex];
+        *(boxUD.color) = g_boxColor; // reset
+        grid_move(g_triggerGrid, scene.boxTrigger, b2Body_GetPosition(scene.box));
+
+        scene.playerNear = false;
+        grid_query_aabb(g_triggerGrid, { { playerBox.minX, playerBox.minY }, { playerBox.maxX, playerBox.maxY } }, g_triggerHits);
+        for (int id : g_triggerHits) scene.playerNear |= id == scene.boxTrigger;
+        if (scene.playerNear) {
+            *(boxUD.color) = g_yellowColor;
 
             // Add score and spawn popup (only once per collision)
             if (!wasPlayerNear) {
                 currentScore += 10;
-                b2Vec2 boxPos = b2Body_GetPosition(box);
+                b2Vec2 boxPos = b2Body_GetPosition(scene.box);
                 spawn_score_popup(10, glm::vec2(boxPos.x, boxPos.y + 1.0f));
                 std::cout << "Score: " << currentScore << std::endl;
             }
@@ -826,102 +1599,452 @@ int main() {
         else {
             wasPlayerNear = false;
         }
+    });
+
+    // Coins touching the player; everything picked up this frame shares one popup
+    scheduler_add(systems, SYSTEM_COINS, [&scene] {
+        constexpr ArchetypeDesc playerDesc = Archetype<ENTITY_PLAYER>::desc;
+        CoinPickup pickup = collect_coins(b2Body_GetPosition(scene.player), playerDesc.halfW, playerDesc.halfH);
+        if (pickup.coins > 0) {
+            currentScore += pickup.points;
+            spawn_score_popup(pickup.points, glm::vec2(pickup.position.x, pickup.position.y + 1.0f));
+        }
+    });
+
+    // Update box animation
+    scheduler_add(systems, SYSTEM_ANIMATION, [&scene, deltaTime] {
+        update_box_animation(&scene.boxBatch.userData[scene.boxIndex], deltaTime, scene.playerNear);
+    });
+
+    // Stream terrain chunks around the player (chunks carry their coins)
+    scheduler_add(systems, SYSTEM_TERRAIN, [&scene] {
+        update_terrain_streaming(b2Body_GetPosition(scene.player).x, TERRAIN_STREAM_RANGE);
+    });
+
+    scheduler_add(systems, SYSTEM_FALL_CHECK, [&scene] {
+        // Enemies that fall off the world go back home
+        for (Enemy& e : g_enemies) {
+            if (b2Body_GetPosition(e.body).y < -20.0f) {
+                b2Body_SetTransform(e.body, { e.homeX,-4.0f }, b2MakeRot(0.0f));
+                b2Body_SetLinearVelocity(e.body, { 0.0f,0.0f });
+            }
+        }
 
-        // Update box animation
-        update_box_animation(boxUD, deltaTime, isPlayerNear);
-
-        // Auto reset if player falls
-        b2Vec2 ppos = b2Body_GetPosition(player);
-        if (ppos.y < -20.0f) {
-            b2Body_SetTransform(player, { 0.0f,10.0f }, b2MakeRot(0.0f));
-            b2Body_SetLinearVelocity(player, { 0.0f,0.0f });
+        // Auto reset if player (or a scenario's extra vehicle) falls
+        for (int index : scene.controllers) {
+            b2BodyId body = g_controllers[index].body;
+            b2Vec2 ppos = b2Body_GetPosition(body);
+            if (ppos.y < -20.0f) {
+                b2Body_SetTransform(body, { 0.0f,10.0f }, b2MakeRot(0.0f));
+                b2Body_SetLinearVelocity(body, { 0.0f,0.0f });
+            }
         }
+    });
+}
 
-        // --- Rendering ---
-        glClear(GL_COLOR_BUFFER_BIT);
-        glUseProgram(g_prog);
-        glBindVertexArray(g_vao);
-
-        // Set texture unit
-        glUniform1i(g_uTexture, 0);
-
-        auto drawBody = [&](b2BodyId b, float w, float h) {
-            b2Vec2 pos = b2Body_GetPosition(b);
-            float angle = b2Rot_GetAngle(b2Body_GetRotation(b));
-            float px = pos.x * PIXELS_PER_METER + WINDOW_WIDTH / 2.0f;
-            float py = pos.y * PIXELS_PER_METER + WINDOW_HEIGHT / 2.0f;
-            glm::mat4 model(1.0f);
-            model = glm::translate(model, { px,py,0.0f });
-            model = glm::rotate(model, angle, { 0,0,1 });
-
-            // Apply animation scale if needed
-            UserData* ud = (UserData*)b2Body_GetUserData(b);
-            float scale = ud ? ud->animationScale : 1.0f;
-            model = glm::scale(model, { w * PIXELS_PER_METER * 2.0f * scale,
-                                        h * PIXELS_PER_METER * 2.0f * scale, 1.0f });
+// camera is the world point (meters) drawn at the window's center; the HUD doesn't move with it
+void render_scene(const Scene& scene, const glm::mat4& proj, b2Vec2 camera, GLuint groundTexture) {
+    glm::mat4 view = glm::translate(proj, { -camera.x * PIXELS_PER_METER, -camera.y * PIXELS_PER_METER, 0.0f });
+    g_cameraOffset = glm::vec2(camera.x, camera.y) * PIXELS_PER_METER;
 
-            glm::mat4 mvp = proj * model;
-            glUniformMatrix4fv(g_uMVP, 1, GL_FALSE, glm::value_ptr(mvp));
+    begin_scene_target();
+    glClear(GL_COLOR_BUFFER_BIT);
+    render_terrain(view, groundTexture);
+    render_coins(view, static_cast<float>(glfwGetTime()));
+    glUseProgram(g_prog);
+    glBindVertexArray(g_vao);
 
-            if (ud) {
-                glUniform3f(g_uColor, ud->color ? ud->color->r : 1.0f,
-                    ud->color ? ud->color->g : 1.0f,
-                    ud->color ? ud->color->b : 1.0f);
-                glUniform1i(g_uUseTexture, ud->useTexture);
-                if (ud->useTexture && ud->textureID != 0) {
-                    glActiveTexture(GL_TEXTURE0);
-                    glBindTexture(GL_TEXTURE_2D, ud->textureID);
-                }
-            }
-            else {
-                glUniform3f(g_uColor, 1.0f, 1.0f, 1.0f);
-                glUniform1i(g_uUseTexture, false);
+    // Set texture unit
+    glUniform1i(g_uTexture, 0);
+
+    auto drawBody = [&](b2BodyId b) {
+        b2Vec2 pos = b2Body_GetPosition(b);
+        float angle = b2Rot_GetAngle(b2Body_GetRotation(b));
+        float px = pos.x * PIXELS_PER_METER + WINDOW_WIDTH / 2.0f;
+        float py = pos.y * PIXELS_PER_METER + WINDOW_HEIGHT / 2.0f;
+        glm::mat4 model(1.0f);
+        model = glm::translate(model, { px,py,0.0f });
+        model = glm::rotate(model, angle, { 0,0,1 });
+
+        // Apply animation scale if needed
+        UserData* ud = (UserData*)b2Body_GetUserData(b);
+        float scale = ud ? ud->animationScale : 1.0f;
+        float w = ud ? ud->halfW : 0.5f;
+        float h = ud ? ud->halfH : 0.5f;
+        model = glm::scale(model, { w * PIXELS_PER_METER * 2.0f * scale,
+                                    h * PIXELS_PER_METER * 2.0f * scale, 1.0f });
+
+        glm::mat4 mvp = view * model;
+        glUniformMatrix4fv(g_uMVP, 1, GL_FALSE, glm::value_ptr(mvp));
+
+        if (ud) {
+            glUniform3f(g_uColor, ud->color ? ud->color->r : 1.0f,
+                ud->color ? ud->color->g : 1.0f,
+                ud->color ? ud->color->b : 1.0f);
+            glUniform1i(g_uUseTexture, ud->useTexture);
+            if (ud->useTexture && ud->textureID != 0) {
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, ud->textureID);
             }
+        }
+        else {
+            glUniform3f(g_uColor, 1.0f, 1.0f, 1.0f);
+            glUniform1i(g_uUseTexture, false);
+        }
 
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-            };
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        };
 
-        drawBody(ground, 50.0f, 0.1f);
-        drawBody(player, 1.0f, 1.0f);
-        drawBody(box, 0.5f, 0.5f);
+    {
+        PROFILE_SCOPE("draw bodies");
+        profiler_elements("draw bodies", 3 + static_cast<long long>(g_enemyBatch.bodies.size() +
+            scene.stressBoxes.bodies.size() + scene.vehicleBatch.bodies.size()));
+        drawBody(scene.ground);
+        drawBody(scene.player);
+        drawBody(scene.box);
+        draw_archetype_batch<ENTITY_BOX>(view, scene.stressBoxes.bodies, scene.stressBoxTemplate);
+        draw_archetype_batch<ENTITY_PLAYER>(view, scene.vehicleBatch.bodies, scene.vehicleTemplate);
+        draw_archetype_batch<ENTITY_ENEMY>(view, g_enemyBatch.bodies, scene.enemyTemplate);
+    }
 
-        // Render particles
-        render_particles(proj);
+    // Render particles
+    render_particles(view);
 
-        // Render score popups
-        render_score_popups(proj);
+    // Render score popups
+    render_score_popups(proj);
+    present_scene_target();
 
-        // Render current score in the corner with pixel font
-        render_text("Score:" + std::to_string(currentScore), 20.0f, WINDOW_HEIGHT - 40.0f, 0.8f,
-            glm::vec3(1, 1, 1), glm::vec3(0.2f, 0.6f, 1.0f), glm::vec2(2, -2));
+    // HUD: score, speed and the stats overlay from the cached UI layer
+    update_ui_layer(scene.player);
+    composite_ui_layer(proj);
+}
+
+ScenarioSample sample_scenario_frame(double updateMs) {
+    const ProfileFrame& frame = profiler_last_frame();
+    ScenarioSample sample = {};
+    sample.values[METRIC_FRAME_MS] = (frame.stats.end - frame.stats.start) / 1000.0;
+    sample.values[METRIC_UPDATE_MS] = updateMs;
+    sample.values[METRIC_PHYSICS_MS] = frame.stats.physics.step;
+    sample.values[METRIC_RENDER_MS] = profiler_scope_ms(frame, "render") + profiler_scope_ms(frame, "swap");
+    sample.values[METRIC_PARTICLES] = static_cast<double>(particles.size());
+    sample.values[METRIC_BODIES] = frame.stats.counters.bodyCount;
+    sample.values[METRIC_CONTACTS] = frame.stats.counters.contactCount;
+    sample.values[METRIC_SCORE] = currentScore;
+    return sample;
+}
 
-        glfwSwapBuffers(win);
-        glfwPollEvents();
+// ---------------- Main ----------------
+int main(int argc, char** argv) {
+    // Pools are reserved and prefaulted up front so first use doesn't page-fault mid-game.
+    // Transparent huge pages by default; --huge-pages asks for explicit ones.
+    bool explicitHugePages = false;
+    for (int i = 1; i < argc; ++i) explicitHugePages |= std::string(argv[i]) == "--huge-pages";
+    memory_init(explicitHugePages ? MEMORY_PAGES_EXPLICIT_HUGE : MEMORY_PAGES_TRANSPARENT_HUGE);
+
+    // Headless benchmarks: --bench <name> [count]
+    if (argc > 2 && std::string(argv[1]) == "--bench") {
+        return run_benchmark(argv[2], argc > 3 ? atoi(argv[3]) : 0);
+    }
+    // Per-frame telemetry CSV: --telemetry <file>
+    // Hitch flight recorder threshold: --hitch-ms <ms> (0 turns it off)
+    // Per-scope hardware counters: --hw-counters (report on F5)
+    // Update systems one after another on the main thread: --serial-systems (for comparing with the parallel schedule)
+    // Scripted run: --scenario <file> (see scenario.cpp for the format), exits when it ends
+    // Quality: --calibrate reruns the hardware calibration, --quality <low|medium|high|ultra> overrides quality.cfg for this run
+    // Threads: --threads auto (main on its own core, workers one per other core), --main-cpu <n>,
+    // --worker-cpus <list, e.g. 2-5,8>, --worker-priority <low|normal|high>, --realtime (SCHED_FIFO main thread; needs main and workers pinned apart)
+    double hitchMs = 50.0;
+    Scenario scenario;
+    bool scripted = false;
+    bool calibrate = false;
+    std::string qualityName;
+    ThreadConfig threads;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--hw-counters") profiler_enable_hw_counters(true);
+        if (std::string(argv[i]) == "--calibrate") calibrate = true;
+        if (std::string(argv[i]) == "--serial-systems") g_systems.serial = true;
+        if (std::string(argv[i]) == "--realtime") threads.enabled = threads.realtimeMain = true;
+    }
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--telemetry") profiler_open_telemetry(argv[i + 1]);
+        if (std::string(argv[i]) == "--hitch-ms") hitchMs = atof(argv[i + 1]);
+        if (std::string(argv[i]) == "--scenario") {
+            if (!load_scenario(argv[i + 1], scenario)) return 1;
+            scripted = true;
+        }
+        if (std::string(argv[i]) == "--quality") qualityName = argv[i + 1];
+        if (std::string(argv[i]) == "--threads" && std::string(argv[i + 1]) == "auto") {
+            CpuTopology topology = detect_cpu_topology();
+            print_cpu_topology(topology);
+            ThreadConfig planned = plan_thread_config(topology);
+            threads.mainCpu = planned.mainCpu;
+            threads.workerCpus = planned.workerCpus;
+            threads.enabled = true;
+        }
+        if (std::string(argv[i]) == "--main-cpu") {
+            threads.mainCpu = atoi(argv[i + 1]);
+            threads.enabled = true;
+        }
+        if (std::string(argv[i]) == "--worker-cpus") {
+            if (!parse_cpu_list(argv[i + 1], threads.workerCpus)) std::cout << "Bad CPU list: " << argv[i + 1] << std::endl;
+            threads.enabled = true;
+        }
+        if (std::string(argv[i]) == "--worker-priority") {
+            std::string prio = argv[i + 1];
+            threads.workerPriority = prio == "low" ? THREAD_PRIO_LOW : prio == "high" ? THREAD_PRIO_HIGH : THREAD_PRIO_NORMAL;
+            threads.enabled = true;
+        }
+    }
+    // A scenario's own preset is used as is, so its results don't depend on this machine's quality.cfg
+    bool scenarioQuality = scripted && !scenario.quality.empty() && qualityName.empty();
+    if (scenarioQuality) qualityName = scenario.quality;
+    profiler_set_hitch_recorder(hitchMs);
+    bool headless = scripted && scenario.mode == SCENARIO_HEADLESS;
+
+    GLFWwindow* win = nullptr;
+    GLuint playerTexture = 0, boxTexture = 0, groundTexture = 0;
+    if (!headless) {
+        if (!glfwInit()) return -1;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        if (scripted) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // Offscreen: the default framebuffer of a hidden window
+
+        win = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Box2D Textured Game", nullptr, nullptr);
+        if (!win) { glfwTerminate(); return -1; }
+        glfwMakeContextCurrent(win);
+        glfwSetKeyCallback(win, record_key_event);
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) return -1;
+        if (scripted) glfwSwapInterval(0); // Measure the frame, not the display's refresh
+        glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+        GLuint vs = compile_shader(vertex_shader_src, GL_VERTEX_SHADER);
+        GLuint fs = compile_shader(fragment_shader_src, GL_FRAGMENT_SHADER);
+        g_prog = link_program(vs, fs);
+        glDeleteShader(vs); glDeleteShader(fs);
+
+        g_vao = create_square_vao_ebo();
+        g_uMVP = glGetUniformLocation(g_prog, "uMVP");
+        g_uColor = glGetUniformLocation(g_prog, "uColor");
+        g_uUseTexture = glGetUniformLocation(g_prog, "uUseTexture");
+        g_uTexture = glGetUniformLocation(g_prog, "uTexture");
+
+        GLuint archetypeVS = compile_shader(archetype_vertex_shader_src, GL_VERTEX_SHADER);
+        GLuint archetypeFS = compile_shader(fragment_shader_src, GL_FRAGMENT_SHADER);
+        g_archetypeProg = link_program(archetypeVS, archetypeFS);
+        glDeleteShader(archetypeVS); glDeleteShader(archetypeFS);
+        g_archetypeUMVP = glGetUniformLocation(g_archetypeProg, "uMVP");
+        g_archetypeUHalfExtents = glGetUniformLocation(g_archetypeProg, "uHalfExtents");
+        g_archetypeUColor = glGetUniformLocation(g_archetypeProg, "uColor");
+        g_archetypeUUseTexture = glGetUniformLocation(g_archetypeProg, "uUseTexture");
+        g_archetypeUTexture = glGetUniformLocation(g_archetypeProg, "uTexture");
+        g_archetypeVAO = create_square_vao_ebo();
+        glGenBuffers(1, &g_archetypeInstanceVBO);
+        glBindVertexArray(g_archetypeVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, g_archetypeInstanceVBO);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+
+        GLuint coinVS = compile_shader(coin_vertex_shader_src, GL_VERTEX_SHADER);
+        GLuint coinFS = compile_shader(coin_fragment_shader_src, GL_FRAGMENT_SHADER);
+        g_coinProg = link_program(coinVS, coinFS);
+        glDeleteShader(coinVS); glDeleteShader(coinFS);
+        g_coinUMVP = glGetUniformLocation(g_coinProg, "uMVP");
+        g_coinUTime = glGetUniformLocation(g_coinProg, "uTime");
+        g_coinURadius = glGetUniformLocation(g_coinProg, "uRadius");
+        g_coinUColor = glGetUniformLocation(g_coinProg, "uColor");
     }
 
-    // Cleanup
-    delete playerUD;
-    delete boxUD->color;
-    delete boxUD;
-    delete groundUD;
+    // Quality preset from quality.cfg; the first interactive launch (or --calibrate) measures this machine
+    // and writes it. Scenario runs never calibrate on their own: headless ones can't time rendering, and
+    // an offscreen run would time a hidden window's default framebuffer rather than what the game draws
+    bool configured = load_quality_config(QUALITY_CONFIG_PATH, g_quality);
+    if ((!configured && !scripted) || calibrate) {
+        QualityCalibration calibration = run_quality_calibration(headless ? nullptr : measure_render_ms);
+        save_quality_config(QUALITY_CONFIG_PATH, choose_quality_preset(calibration), calibration);
+        load_quality_config(QUALITY_CONFIG_PATH, g_quality); // Picks up the user's override lines
+    }
+    if (!qualityName.empty()) {
+        QualityPreset preset;
+        if (quality_preset_from_name(qualityName.c_str(), preset)) {
+            // The user's override lines still win over a preset picked with --quality
+            g_quality = quality_preset(preset);
+            if (!scenarioQuality) apply_quality_overrides(QUALITY_CONFIG_PATH, g_quality);
+        }
+        else std::cout << "Unknown quality preset: " << qualityName << std::endl;
+    }
+    print_quality(g_quality);
+
+    // Worker threads (mip chains, batched world queries); pinned workers get one thread per listed CPU.
+    // The thread config goes first so the pool threads drop the main thread's pin and policy as they start
+    apply_thread_config(threads);
+    job_system_init(threads.workerCpus.empty() ? g_quality.workerThreads : static_cast<int>(threads.workerCpus.size()));
+    // Asset reads: io_uring where the kernel allows it, I/O threads otherwise
+    async_io_init();
+    particles.reserve(g_quality.maxParticles);
+
+    if (!headless) {
+        init_scene_target(g_quality.renderScale, g_quality.msaaSamples);
+
+        // Load textures (or create procedural ones if files not available), all four in one read batch
+        const char* texturePaths[] = { "enemy2.png", "playegr.png", "ground_texture.png", "explosion.png" };
+        GLuint textures[4];
+        load_textures(texturePaths, 4, textures);
+        playerTexture = textures[0];
+        boxTexture = textures[1];
+        groundTexture = textures[2];
+        g_particleTexture = textures[3];
+        if (playerTexture == 0) {
+            playerTexture = create_procedural_texture(64, 64, glm::vec3(0.9f, 0.3f, 0.25f), glm::vec3(0.7f, 0.2f, 0.2f));
+        }
+
+        if (boxTexture == 0) {
+            boxTexture = create_procedural_texture(64, 64, glm::vec3(0.2f, 0.5f, 0.8f), glm::vec3(0.1f, 0.3f, 0.6f));
+        }
+
+        if (groundTexture == 0) {
+            groundTexture = create_procedural_texture(64, 64, glm::vec3(0.4f, 0.6f, 0.3f), glm::vec3(0.3f, 0.5f, 0.2f));
+        }
+
+        // Initialize bullet system
+        init_particle_system();
+
+        // Initialize font rendering
+        init_font_rendering();
+        print_async_io_stats();
+        init_ui_layer();
+    }
+
+    // Box2D world
+    validate_collision_layers();
+    b2WorldDef worldDef = b2DefaultWorldDef();
+    worldDef.gravity = { 0.0f,-10.0f };
+    g_world = b2CreateWorld(&worldDef);
+
+    Scene scene;
+    create_scene(scenario, playerTexture, boxTexture, groundTexture, scene);
+
+    float timeStep = 1.0f / 60.0f;
+    glm::mat4 proj = glm::ortho(0.0f, float(WINDOW_WIDTH), 0.0f, float(WINDOW_HEIGHT), -1.0f, 1.0f);
+    if (!headless) {
+        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
 
-    // Cleanup font resources
-    glDeleteVertexArrays(1, &fontVAO);
-    glDeleteBuffers(1, &fontVBO);
-    glDeleteProgram(fontProgram);
+        // Tells OpenGL to properly handle the alpha channel in your PNGs
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    // Scripted runs step a fixed number of frames at the fixed step, whatever the wall clock does
+    ScenarioPlayback playback;
+    std::vector<ScenarioEvent> dueEvents;
+    std::vector<ScenarioSample> samples;
+    int scenarioFrames = scripted ? scenario_frame_count(scenario) : 0;
+    if (scripted) samples.reserve(scenarioFrames);
+
+    // For tracking time between frames
+    float lastTime = headless ? 0.0f : glfwGetTime();
+
+    while (scripted ? playback.frame < scenarioFrames : !glfwWindowShouldClose(win)) {
+        // Calculate delta time
+        float deltaTime = SCENARIO_TIME_STEP;
+        if (!scripted) {
+            float currentTime = glfwGetTime();
+            deltaTime = currentTime - lastTime;
+            lastTime = currentTime;
+        }
+        profiler_begin_frame();
+
+        // Input and update systems; the DAG is rebuilt every frame from what each one declares
+        scheduler_begin_frame(g_systems);
+        scheduler_add(g_systems, SYSTEM_INPUT, [&] {
+            if (scripted) {
+                scenario_advance(scenario, playback, dueEvents);
+                apply_scenario_input(scene, playback, dueEvents);
+            }
+            else {
+                process_input(win, scene.player, g_controllers[scene.controllers[0]]);
+            }
+        });
+        add_update_systems(g_systems, scene, deltaTime, timeStep);
+        scheduler_run(g_systems);
+        double updateMs = (g_systems.frameEnd - g_systems.frameStart) / 1000.0;
+        if (g_printSystemsReport) {
+            scheduler_print_report(g_systems);
+            g_printSystemsReport = false;
+        }
+        if (g_writeChromeTrace) {
+            profiler_write_chrome_trace("trace.json");
+            g_writeChromeTrace = false;
+        }
 
-    // Cleanup character textures
-    for (auto& character : characters) {
-        glDeleteTextures(1, &character.second.textureID);
+        // --- Rendering ---
+        if (!headless) {
+            profiler_push("render");
+            b2Vec2 camera = scripted ? scenario_camera(scenario, playback.frame * SCENARIO_TIME_STEP) : b2Vec2{ 0.0f, 0.0f };
+            render_scene(scene, proj, camera, groundTexture);
+            profiler_pop();
+
+            { PROFILE_SCOPE("swap"); glfwSwapBuffers(win); }
+            glfwPollEvents();
+        }
+        // Read under each pool's lock: Box2D and the workers may still be allocating
+        MemoryUsage entityUsage = memory_usage(entity_memory());
+        MemoryUsage particleUsage = memory_usage(particle_memory());
+        MemoryUsage physicsUsage = memory_usage(physics_memory());
+        profiler_counter("entity allocs", static_cast<double>(entityUsage.allocations));
+        profiler_counter("particle allocs", static_cast<double>(particleUsage.allocations));
+        profiler_counter("physics allocs", static_cast<double>(physicsUsage.allocations));
+        profiler_counter("heap fallbacks", static_cast<double>(entityUsage.fallbacks + particleUsage.fallbacks + physicsUsage.fallbacks));
+        profiler_end_frame();
+        if (scripted) samples.push_back(sample_scenario_frame(updateMs));
     }
 
-    glDeleteTextures(1, &playerTexture);
-    glDeleteTextures(1, &boxTexture);
-    glDeleteTextures(1, &groundTexture);
-   
-    glDeleteTextures(1, &g_particleTexture);
+    profiler_close_telemetry();
+    profiler_finish_hitch_dumps();
+    if (scripted) scenario_report(scenario, samples);
+
+    // Cleanup
+    destroy_scene(scene);
+
+    if (!headless) {
+        // Cleanup font resources
+        glDeleteVertexArrays(1, &fontVAO);
+        glDeleteBuffers(1, &fontVBO);
+        glDeleteProgram(fontProgram);
+        print_ui_layer_stats();
+        destroy_ui_layer();
+
+        // Cleanup character textures
+        for (auto& character : characters) {
+            glDeleteTextures(1, &character.second.textureID);
+        }
+
+        glDeleteTextures(1, &playerTexture);
+        glDeleteTextures(1, &boxTexture);
+        glDeleteTextures(1, &groundTexture);
+
+        glDeleteTextures(1, &g_particleTexture);
+
+        glDeleteVertexArrays(1, &g_terrainVAO);
+        glDeleteBuffers(1, &g_terrainVBO);
+        glDeleteVertexArrays(1, &g_coinVAO);
+        glDeleteBuffers(1, &g_coinQuadVBO);
+        glDeleteBuffers(1, &g_coinInstanceVBO);
+        glDeleteProgram(g_coinProg);
+        glDeleteVertexArrays(1, &g_archetypeVAO);
+        glDeleteBuffers(1, &g_archetypeInstanceVBO);
+        glDeleteProgram(g_archetypeProg);
+        destroy_scene_target();
+    }
+    shutdown_terrain();
+    nav_clear();
+    shutdown_coins();
 
     b2DestroyWorld(g_world);
-    glfwTerminate();
+    async_io_shutdown();
+    job_system_shutdown();
+    if (!headless) glfwTerminate();
     return 0;
-}
\ No newline at end of file
+}
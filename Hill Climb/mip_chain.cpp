@@ -0,0 +1,226 @@
+// mip_chain.cpp
+// CPU mip chain generation on the job system (SSE2 box or Kaiser filter, optional sRGB-correct averaging)
+
+#include "mip_chain.h"
+
+#include <iostream>
+#include <cmath>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "job_system.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_SSE2 1
+#endif
+
+const int MIP_ROWS_PER_JOB = 32;
+const int KAISER_TAPS = 6;
+const float KAISER_ALPHA = 4.0f;
+
+// ---------------- Tables ----------------
+static float g_srgbToLinear[256];
+static unsigned char g_linearToSrgb[4096];
+static float g_kaiserWeights[KAISER_TAPS];  // Source offsets -2..+3 around 2x
+static std::once_flag g_tablesOnce;
+
+static float bessel_i0(float x) {
+    float sum = 1.0f, term = 1.0f;
+    for (int k = 1; k < 16; ++k) {
+        term *= (x / (2.0f * k)) * (x / (2.0f * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static void init_tables() {
+    for (int i = 0; i < 256; ++i) {
+        float c = i / 255.0f;
+        g_srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+    for (int i = 0; i < 4096; ++i) {
+        float l = i / 4095.0f;
+        float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+        g_linearToSrgb[i] = static_cast<unsigned char>(c * 255.0f + 0.5f);
+    }
+
+    // Taps sit at -2.5..+2.5 source pixels from the output centre; sinc in output
+    // texels (half rate), windowed over a 3 source pixel radius
+    const float pi = 3.14159265f;
+    float total = 0.0f;
+    for (int i = 0; i < KAISER_TAPS; ++i) {
+        float d = i - 2.5f;
+        float t = d * 0.5f;
+        float sinc = sinf(pi * t) / (pi * t);
+        float w = d / 3.0f;
+        float window = bessel_i0(KAISER_ALPHA * sqrtf(1.0f - w * w)) / bessel_i0(KAISER_ALPHA);
+        g_kaiserWeights[i] = sinc * window;
+        total += g_kaiserWeights[i];
+    }
+    for (float& w : g_kaiserWeights) w /= total;
+}
+
+static unsigned char to_byte(float v, bool srgb) {
+    if (v < 0.0f) v = 0.0f;
+    if (v > 1.0f) v = 1.0f;
+    return srgb ? g_linearToSrgb[static_cast<int>(v * 4095.0f + 0.5f)] : static_cast<unsigned char>(v * 255.0f + 0.5f);
+}
+
+// ---------------- Box ----------------
+static void box_rows(const unsigned char* src, int sw, int sh, unsigned char* dst, int dw, int begin, int end, bool srgb) {
+    for (int y = begin; y < end; ++y) {
+        const unsigned char* r0 = src + static_cast<size_t>(y * 2) * sw * 4;
+        const unsigned char* r1 = y * 2 + 1 < sh ? r0 + static_cast<size_t>(sw) * 4 : r0;
+        unsigned char* d = dst + static_cast<size_t>(y) * dw * 4;
+        int x = 0;
+#ifdef MIP_SSE2
+        if (!srgb) {
+            // Two output pixels per step: 4 source pixels from each row widened to 16 bits
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi16(2);
+            for (; x + 1 < dw && x * 2 + 3 < sw; x += 2) {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + x * 8));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + x * 8));
+                __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+                __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), round), 2);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(d + x * 4), _mm_packus_epi16(sum, zero));
+            }
+        }
+#endif
+        for (; x < dw; ++x) {
+            int x0 = x * 2, x1 = x * 2 + 1 < sw ? x * 2 + 1 : x * 2;
+            for (int c = 0; c < 4; ++c) {
+                const unsigned char s[4] = { r0[x0 * 4 + c], r0[x1 * 4 + c], r1[x0 * 4 + c], r1[x1 * 4 + c] };
+                if (srgb && c < 3) {
+                    float l = (g_srgbToLinear[s[0]] + g_srgbToLinear[s[1]] + g_srgbToLinear[s[2]] + g_srgbToLinear[s[3]]) * 0.25f;
+                    d[x * 4 + c] = to_byte(l, true);
+                }
+                else {
+                    d[x * 4 + c] = static_cast<unsigned char>((s[0] + s[1] + s[2] + s[3] + 2) / 4);
+                }
+            }
+        }
+    }
+}
+
+// ---------------- Kaiser ----------------
+// Separable: source -> float (linear if sRGB) -> horizontal pass -> vertical pass -> bytes
+static void kaiser_level(const unsigned char* src, int sw, int sh, unsigned char* dst, int dw, int dh, bool srgb) {
+    std::vector<float> in(static_cast<size_t>(sw) * sh * 4);
+    std::vector<float> wide(static_cast<size_t>(dw) * sh * 4);
+
+    parallel_for(sh, MIP_ROWS_PER_JOB, [&](int begin, int end) {
+        for (size_t i = static_cast<size_t>(begin) * sw * 4; i < static_cast<size_t>(end) * sw * 4; ++i) {
+            in[i] = srgb && i % 4 != 3 ? g_srgbToLinear[src[i]] : src[i] / 255.0f;
+        }
+    });
+    parallel_for(sh, MIP_ROWS_PER_JOB, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            const float* row = &in[static_cast<size_t>(y) * sw * 4];
+            float* out = &wide[static_cast<size_t>(y) * dw * 4];
+            for (int x = 0; x < dw; ++x) {
+                float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (int t = 0; t < KAISER_TAPS; ++t) {
+                    int sx = x * 2 + t - 2;
+                    sx = sx < 0 ? 0 : (sx >= sw ? sw - 1 : sx);
+                    for (int c = 0; c < 4; ++c) acc[c] += row[sx * 4 + c] * g_kaiserWeights[t];
+                }
+                for (int c = 0; c < 4; ++c) out[x * 4 + c] = acc[c];
+            }
+        }
+    });
+    parallel_for(dh, MIP_ROWS_PER_JOB, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            unsigned char* out = dst + static_cast<size_t>(y) * dw * 4;
+            for (int x = 0; x < dw * 4; ++x) {
+                float acc = 0.0f;
+                for (int t = 0; t < KAISER_TAPS; ++t) {
+                    int sy = y * 2 + t - 2;
+                    sy = sy < 0 ? 0 : (sy >= sh ? sh - 1 : sy);
+                    acc += wide[static_cast<size_t>(sy) * dw * 4 + x] * g_kaiserWeights[t];
+                }
+                out[x] = to_byte(acc, srgb && x % 4 != 3);
+            }
+        }
+    });
+}
+
+// ---------------- Chain ----------------
+void build_mip_chain(CookedTexture& texture, const unsigned char* rgba, int width, int height, const MipSettings& settings) {
+    std::call_once(g_tablesOnce, init_tables);
+
+    // A square chain is under 4/3 of mip 0; reserve it so levels don't regrow the buffer
+    size_t base = static_cast<size_t>(width) * height * 4;
+    texture.mips.clear();
+    texture.pixels.reserve(base + base / 3 + 64);
+    texture.pixels.assign(rgba, rgba + base);
+    texture.mips.push_back({ width, height, 0 });
+
+    while (width > 1 || height > 1) {
+        int w = width > 1 ? width / 2 : 1;
+        int h = height > 1 ? height / 2 : 1;
+        size_t srcOffset = static_cast<size_t>(texture.mips.back().offset);
+        size_t dstOffset = texture.pixels.size();
+        texture.pixels.resize(dstOffset + static_cast<size_t>(w) * h * 4);
+
+        const unsigned char* src = texture.pixels.data() + srcOffset;
+        unsigned char* dst = texture.pixels.data() + dstOffset;
+        // A 1-pixel-wide axis has nothing to filter across, so the box path handles it exactly
+        if (settings.filter == MIP_FILTER_KAISER && width > 1 && height > 1) {
+            kaiser_level(src, width, height, dst, w, h, settings.srgb);
+        }
+        else {
+            int sw = width, sh = height;
+            bool srgb = settings.srgb;
+            parallel_for(h, MIP_ROWS_PER_JOB, [=](int begin, int end) { box_rows(src, sw, sh, dst, w, begin, end, srgb); });
+        }
+        texture.mips.push_back({ w, h, dstOffset });
+        width = w;
+        height = h;
+    }
+}
+
+// ---------------- Benchmark ----------------
+void bench_mip_chain(int size) {
+    std::vector<unsigned char> image(static_cast<size_t>(size) * size * 4);
+    unsigned int seed = 12345;
+    for (unsigned char& p : image) {
+        seed = seed * 1664525u + 1013904223u;
+        p = static_cast<unsigned char>(seed >> 24);
+    }
+
+    const struct { const char* name; MipSettings settings; } cases[] = {
+        { "box", { MIP_FILTER_BOX, false } },
+        { "box srgb", { MIP_FILTER_BOX, true } },
+        { "kaiser", { MIP_FILTER_KAISER, false } },
+        { "kaiser srgb", { MIP_FILTER_KAISER, true } },
+    };
+    const int runs = 5;
+    CookedTexture texture;
+    auto time_ms = [&](const MipSettings& settings) {
+        build_mip_chain(texture, image.data(), size, size, settings); // Warm up tables and allocations
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < runs; ++i) build_mip_chain(texture, image.data(), size, size, settings);
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t0).count() / runs;
+    };
+
+    double single[4];
+    for (int i = 0; i < 4; ++i) single[i] = time_ms(cases[i].settings);
+    job_system_init();
+    std::cout << "Mip chain: " << size << "x" << size << " RGBA8, " << texture.mips.size() << " levels, "
+        << job_system_worker_count() + 1 << " threads" << std::endl;
+#ifdef MIP_SSE2
+    std::cout << "  box rows use SSE2" << std::endl;
+#endif
+    for (int i = 0; i < 4; ++i) {
+        double parallel = time_ms(cases[i].settings);
+        std::cout << "  " << cases[i].name << ": " << single[i] << " ms single, " << parallel << " ms jobs ("
+            << single[i] / parallel << "x)" << std::endl;
+    }
+    job_system_shutdown();
+}
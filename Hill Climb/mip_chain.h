@@ -0,0 +1,25 @@
+// mip_chain.h
+// CPU mip chain generation on the job system (SSE2 box or Kaiser filter, optional sRGB-correct averaging)
+
+#pragma once
+
+#include "cooked_asset.h"
+
+enum MipFilter {
+    MIP_FILTER_BOX,     // 2x2 average
+    MIP_FILTER_KAISER,  // Separable 6-tap Kaiser-windowed sinc, sharper for minified detail
+};
+
+struct MipSettings {
+    MipFilter filter = MIP_FILTER_BOX;
+    bool srgb = false;  // Average colour channels in linear light (alpha stays linear)
+};
+
+// Fills texture with mip 0 copied from rgba (RGBA8) and every level down to 1x1.
+// Levels are built one after another, each split by rows across the job system
+// (inline when the pool isn't running, e.g. in Asset Cook where jobs are per asset).
+void build_mip_chain(CookedTexture& texture, const unsigned char* rgba, int width, int height,
+    const MipSettings& settings = MipSettings());
+
+// Single-threaded vs job system for each filter on a size x size image (headless)
+void bench_mip_chain(int size);
@@ -0,0 +1,399 @@
+// nav_graph.cpp
+// Platforming navigation graph: walk/jump/fall links over static surfaces, A* with a path cache
+
+#include "nav_graph.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <queue>
+#include <unordered_map>
+
+const float NAV_NODE_SPACING = 1.0f;
+const float NAV_BUCKET_WIDTH = 4.0f;
+const float NAV_MAX_WALK_SLOPE = 1.0f;  // dy/dx above this needs a jump
+const float NAV_MAX_JUMP_UP = 0.8f;     // Enemy jump apex (impulse 4 on a 1 kg body)
+const float NAV_MAX_JUMP_DX = 4.0f;
+const float NAV_MAX_FALL_DX = 3.0f;
+const size_t NAV_CACHE_CAPACITY = 4096;
+
+struct CachedPath {
+    std::vector<int> nodes;
+    float minX, maxX;     // Span used for invalidation
+};
+
+static std::vector<NavNode> g_nodes;
+static std::vector<int> g_freeNodes;
+static std::unordered_map<int, std::vector<int>> g_buckets;      // x cell -> nodes
+static std::unordered_map<int, std::vector<int>> g_sourceNodes;  // source -> nodes
+static std::unordered_map<uint64_t, CachedPath> g_pathCache;
+static NavStats g_navStats;
+
+static int bucket_of(float x) {
+    return static_cast<int>(floorf(x / NAV_BUCKET_WIDTH));
+}
+
+static float link_cost(NavLinkType type, float distance) {
+    switch (type) {
+    case NAV_JUMP: return distance * 1.5f + 1.0f;
+    case NAV_FALL: return distance + 0.5f;
+    default: return distance;
+    }
+}
+
+static void add_link(int from, int to, NavLinkType type) {
+    b2Vec2 d = { g_nodes[to].pos.x - g_nodes[from].pos.x, g_nodes[to].pos.y - g_nodes[from].pos.y };
+    float distance = sqrtf(d.x * d.x + d.y * d.y);
+    g_nodes[from].links.push_back({ to, type, link_cost(type, distance) });
+    g_navStats.links++;
+}
+
+// Drop cached paths that pass near geometry that just changed
+static void invalidate_cache(float minX, float maxX) {
+    for (auto it = g_pathCache.begin(); it != g_pathCache.end(); ) {
+        if (it->second.maxX >= minX && it->second.minX <= maxX) it = g_pathCache.erase(it);
+        else ++it;
+    }
+}
+
+// ---------------- Building ----------------
+static int alloc_node(int source, b2Vec2 pos, bool edge) {
+    int id;
+    if (!g_freeNodes.empty()) {
+        id = g_freeNodes.back();
+        g_freeNodes.pop_back();
+    }
+    else {
+        id = static_cast<int>(g_nodes.size());
+        g_nodes.push_back({});
+    }
+    NavNode& n = g_nodes[id];
+    n.pos = pos;
+    n.source = source;
+    n.alive = true;
+    n.edge = edge;
+    n.links.clear();
+    g_buckets[bucket_of(pos.x)].push_back(id);
+    g_sourceNodes[source].push_back(id);
+    g_navStats.nodes++;
+    return id;
+}
+
+// Links between a new node and nodes of other sources nearby
+static void link_to_neighbors(int id) {
+    const NavNode& n = g_nodes[id];
+    int b0 = bucket_of(n.pos.x - NAV_MAX_JUMP_DX);
+    int b1 = bucket_of(n.pos.x + NAV_MAX_JUMP_DX);
+    for (int b = b0; b <= b1; ++b) {
+        auto it = g_buckets.find(b);
+        if (it == g_buckets.end()) continue;
+        for (int other : it->second) {
+            const NavNode& m = g_nodes[other];
+            if (!m.alive || m.source == n.source) continue;
+            float dx = fabsf(m.pos.x - n.pos.x);
+            float dy = m.pos.y - n.pos.y;
+
+            // Seam between surfaces (ground -> terrain, chunk -> chunk)
+            if (dx <= NAV_NODE_SPACING * 1.01f && fabsf(dy) <= NAV_NODE_SPACING * NAV_MAX_WALK_SLOPE) {
+                add_link(id, other, NAV_WALK);
+                add_link(other, id, NAV_WALK);
+                continue;
+            }
+            if (!n.edge && !m.edge) continue;
+            if (dx > NAV_MAX_JUMP_DX) continue;
+
+            // n -> m
+            if (dy > 0.0f) { if (dy <= NAV_MAX_JUMP_UP) add_link(id, other, NAV_JUMP); }
+            else if (dx <= NAV_MAX_FALL_DX) add_link(id, other, NAV_FALL);
+            // m -> n
+            if (-dy > 0.0f) { if (-dy <= NAV_MAX_JUMP_UP) add_link(other, id, NAV_JUMP); }
+            else if (dx <= NAV_MAX_FALL_DX) add_link(other, id, NAV_FALL);
+        }
+    }
+}
+
+void nav_add_surface(int source, const b2Vec2* points, int count) {
+    if (count <= 0) return;
+    std::vector<int> ids(count);
+    for (int i = 0; i < count; ++i) {
+        ids[i] = alloc_node(source, points[i], i == 0 || i == count - 1);
+    }
+
+    // Along the surface: walk where it's gentle, jump/fall where it's steep
+    for (int i = 0; i + 1 < count; ++i) {
+        float dx = fabsf(points[i + 1].x - points[i].x);
+        float dy = points[i + 1].y - points[i].y;
+        if (fabsf(dy) <= dx * NAV_MAX_WALK_SLOPE) {
+            add_link(ids[i], ids[i + 1], NAV_WALK);
+            add_link(ids[i + 1], ids[i], NAV_WALK);
+        }
+        else {
+            add_link(ids[i], ids[i + 1], dy > 0.0f ? NAV_JUMP : NAV_FALL);
+            add_link(ids[i + 1], ids[i], dy > 0.0f ? NAV_FALL : NAV_JUMP);
+        }
+    }
+
+    for (int id : ids) link_to_neighbors(id);
+
+    float minX = fminf(points[0].x, points[count - 1].x);
+    float maxX = fmaxf(points[0].x, points[count - 1].x);
+    invalidate_cache(minX - NAV_MAX_JUMP_DX, maxX + NAV_MAX_JUMP_DX);
+}
+
+void nav_add_box(int source, b2Vec2 center, float halfW, float halfH) {
+    std::vector<b2Vec2> points;
+    int segments = static_cast<int>(ceilf(2.0f * halfW / NAV_NODE_SPACING));
+    if (segments < 1) segments = 1;
+    for (int i = 0; i <= segments; ++i) {
+        points.push_back({ center.x - halfW + 2.0f * halfW * i / segments, center.y + halfH });
+    }
+    nav_add_surface(source, points.data(), static_cast<int>(points.size()));
+}
+
+void nav_remove_source(int source) {
+    auto it = g_sourceNodes.find(source);
+    if (it == g_sourceNodes.end()) return;
+
+    float minX = 1e30f, maxX = -1e30f;
+    for (int id : it->second) {
+        NavNode& n = g_nodes[id];
+        n.alive = false;
+        minX = fminf(minX, n.pos.x);
+        maxX = fmaxf(maxX, n.pos.x);
+        g_navStats.links -= static_cast<int>(n.links.size());
+        n.links.clear();
+        g_navStats.nodes--;
+    }
+
+    // Unlink survivors that pointed into the removed source, and drop dead nodes from buckets
+    for (int b = bucket_of(minX - NAV_MAX_JUMP_DX); b <= bucket_of(maxX + NAV_MAX_JUMP_DX); ++b) {
+        auto bucket = g_buckets.find(b);
+        if (bucket == g_buckets.end()) continue;
+        std::vector<int>& ids = bucket->second;
+        for (size_t i = 0; i < ids.size(); ) {
+            NavNode& n = g_nodes[ids[i]];
+            if (!n.alive) {
+                ids[i] = ids.back();
+                ids.pop_back();
+                continue;
+            }
+            for (size_t l = 0; l < n.links.size(); ) {
+                if (!g_nodes[n.links[l].to].alive) {
+                    n.links[l] = n.links.back();
+                    n.links.pop_back();
+                    g_navStats.links--;
+                }
+                else ++l;
+            }
+            ++i;
+        }
+    }
+
+    for (int id : it->second) g_freeNodes.push_back(id);
+    g_sourceNodes.erase(it);
+    invalidate_cache(minX - NAV_MAX_JUMP_DX, maxX + NAV_MAX_JUMP_DX);
+}
+
+void nav_clear() {
+    g_nodes.clear();
+    g_freeNodes.clear();
+    g_buckets.clear();
+    g_sourceNodes.clear();
+    g_pathCache.clear();
+    g_navStats = {};
+}
+
+void nav_on_terrain_chunk(const TerrainChunk& chunk, bool loaded) {
+    int source = NAV_SOURCE_TERRAIN + chunk.index;
+    if (!loaded) {
+        nav_remove_source(source);
+        return;
+    }
+
+    int step = static_cast<int>(NAV_NODE_SPACING / TERRAIN_SAMPLE_SPACING);
+    b2Vec2 points[TERRAIN_CHUNK_SAMPLES + 1];
+    int count = 0;
+    for (int k = 0; k <= TERRAIN_CHUNK_SAMPLES; k += step) {
+        float x = terrain_start_x() + (chunk.index * TERRAIN_CHUNK_SAMPLES + k) * TERRAIN_SAMPLE_SPACING;
+        points[count++] = { x, chunk.heights[k] };
+    }
+    nav_add_surface(source, points, count);
+}
+
+// ---------------- A* ----------------
+static std::vector<float> s_cost;
+static std::vector<int> s_parent;
+static std::vector<uint32_t> s_visited;  // Stamp per node, so nothing is cleared between searches
+static uint32_t s_searchStamp = 0;
+
+static int nearest_node(b2Vec2 p) {
+    int best = -1;
+    float bestDist = 1e30f;
+    int b = bucket_of(p.x);
+    for (int i = b - 1; i <= b + 1; ++i) {
+        auto it = g_buckets.find(i);
+        if (it == g_buckets.end()) continue;
+        for (int id : it->second) {
+            const NavNode& n = g_nodes[id];
+            float dx = n.pos.x - p.x, dy = n.pos.y - p.y;
+            float d = dx * dx + dy * dy;
+            if (n.alive && d < bestDist) { bestDist = d; best = id; }
+        }
+    }
+    return best;
+}
+
+static bool astar(int start, int goal, std::vector<int>& out) {
+    size_t n = g_nodes.size();
+    if (s_visited.size() < n) {
+        s_cost.resize(n);
+        s_parent.resize(n);
+        s_visited.resize(n, 0);
+    }
+    s_searchStamp++;
+
+    auto heuristic = [goal](int id) {
+        float dx = g_nodes[goal].pos.x - g_nodes[id].pos.x;
+        float dy = g_nodes[goal].pos.y - g_nodes[id].pos.y;
+        return sqrtf(dx * dx + dy * dy);
+    };
+
+    typedef std::pair<float, int> Entry;  // (f, node)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    s_cost[start] = 0.0f;
+    s_parent[start] = -1;
+    s_visited[start] = s_searchStamp;
+    open.push({ heuristic(start), start });
+
+    while (!open.empty()) {
+        Entry top = open.top();
+        open.pop();
+        int current = top.second;
+        if (current == goal) {
+            out.clear();
+            for (int id = goal; id != -1; id = s_parent[id]) out.push_back(id);
+            std::reverse(out.begin(), out.end());
+            return true;
+        }
+        if (top.first - heuristic(current) > s_cost[current] + 1e-4f) continue; // Stale entry
+
+        for (const NavLink& link : g_nodes[current].links) {
+            float cost = s_cost[current] + link.cost;
+            if (s_visited[link.to] == s_searchStamp && cost >= s_cost[link.to]) continue;
+            s_visited[link.to] = s_searchStamp;
+            s_cost[link.to] = cost;
+            s_parent[link.to] = current;
+            open.push({ cost + heuristic(link.to), link.to });
+        }
+    }
+    return false;
+}
+
+bool nav_find_path(b2Vec2 from, b2Vec2 to, std::vector<NavPathPoint>& path) {
+    path.clear();
+    int start = nearest_node(from);
+    int goal = nearest_node(to);
+    if (start < 0 || goal < 0) return false;
+
+    uint64_t key = (static_cast<uint64_t>(start) << 32) | static_cast<uint32_t>(goal);
+    auto it = g_pathCache.find(key);
+    if (it != g_pathCache.end()) {
+        g_navStats.cacheHits++;
+    }
+    else {
+        g_navStats.cacheMisses++;
+        CachedPath cached;
+        if (!astar(start, goal, cached.nodes)) return false;
+        cached.minX = 1e30f;
+        cached.maxX = -1e30f;
+        for (int id : cached.nodes) {
+            cached.minX = fminf(cached.minX, g_nodes[id].pos.x);
+            cached.maxX = fmaxf(cached.maxX, g_nodes[id].pos.x);
+        }
+        if (g_pathCache.size() >= NAV_CACHE_CAPACITY) g_pathCache.clear();
+        it = g_pathCache.emplace(key, std::move(cached)).first;
+    }
+
+    const std::vector<int>& nodes = it->second.nodes;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        NavLinkType type = NAV_WALK;
+        if (i > 0) {
+            for (const NavLink& link : g_nodes[nodes[i - 1]].links) {
+                if (link.to == nodes[i]) { type = link.type; break; }
+            }
+        }
+        path.push_back({ g_nodes[nodes[i]].pos, type });
+    }
+    return true;
+}
+
+const NavStats& nav_stats() {
+    g_navStats.cachedPaths = static_cast<int>(g_pathCache.size());
+    return g_navStats;
+}
+
+const std::vector<NavNode>& nav_nodes() {
+    return g_nodes;
+}
+
+// ---------------- Benchmark ----------------
+void bench_nav_graph(int count) {
+    b2WorldDef worldDef = b2DefaultWorldDef();
+    b2WorldId world = b2CreateWorld(&worldDef);
+    nav_clear();
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    init_terrain(world, 1234, 0.0f, 0.0f);
+    terrain_add_chunk_listener(nav_on_terrain_chunk);
+    float span = TERRAIN_MAX_CHUNKS * TERRAIN_CHUNK_WIDTH;
+    update_terrain_streaming(span * 0.5f, span * 0.5f - 0.01f);
+
+    // Boxes sitting on the hills every 10 m
+    int boxes = 0;
+    for (float x = 5.0f; x < span - 5.0f; x += 10.0f) {
+        float h;
+        if (terrain_height_at(x, &h, nullptr)) nav_add_box(NAV_SOURCE_BOX + boxes++, { x, h + 0.5f }, 0.5f, 0.5f);
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    std::vector<b2Vec2> from(count), to(count);
+    for (int i = 0; i < count; ++i) {
+        float a = static_cast<float>(rand()) / RAND_MAX * span;
+        float b = static_cast<float>(rand()) / RAND_MAX * span;
+        float ha = 0.0f, hb = 0.0f;
+        terrain_height_at(a, &ha, nullptr);
+        terrain_height_at(b, &hb, nullptr);
+        from[i] = { a, ha };
+        to[i] = { b, hb };
+    }
+
+    std::vector<NavPathPoint> path;
+    int found = 0;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < count; ++i) found += nav_find_path(from[i], to[i], path) ? 1 : 0;
+    auto t3 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < count; ++i) nav_find_path(from[i], to[i], path);
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    // Stream one chunk forward: incremental unlink/link plus cache invalidation
+    update_terrain_streaming(span * 0.5f + TERRAIN_CHUNK_WIDTH, span * 0.5f - 0.01f);
+    auto t5 = std::chrono::high_resolution_clock::now();
+
+    auto seconds = [](std::chrono::high_resolution_clock::duration d) {
+        return std::chrono::duration<double>(d).count();
+    };
+    const NavStats& stats = nav_stats();
+    std::cout << "Nav graph: " << stats.nodes << " nodes, " << stats.links << " links, " << boxes << " boxes" << std::endl;
+    std::cout << "  build:         " << seconds(t1 - t0) * 1000.0 << " ms" << std::endl;
+    std::cout << "  cold queries:  " << count / seconds(t3 - t2) << " queries/s (" << found << "/" << count << " found)" << std::endl;
+    std::cout << "  cached:        " << count / seconds(t4 - t3) << " queries/s" << std::endl;
+    std::cout << "  stream chunk:  " << seconds(t5 - t4) * 1000.0 << " ms, " << nav_stats().cachedPaths
+        << " cached paths survived" << std::endl;
+
+    shutdown_terrain();
+    nav_clear();
+    b2DestroyWorld(world);
+}
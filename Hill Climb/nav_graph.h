@@ -0,0 +1,59 @@
+// nav_graph.h
+// Platforming navigation graph: walk/jump/fall links over static surfaces, A* with a path cache
+
+#pragma once
+
+#include <vector>
+#include <box2d/box2d.h>
+#include "terrain.h"
+
+const int NAV_SOURCE_GROUND = 0;
+const int NAV_SOURCE_TERRAIN = 1000;  // + chunk index
+const int NAV_SOURCE_BOX = 100000;    // + caller's box id
+
+enum NavLinkType { NAV_WALK, NAV_JUMP, NAV_FALL };
+
+struct NavLink {
+    int to;
+    NavLinkType type;
+    float cost;
+};
+
+struct NavNode {
+    b2Vec2 pos;           // Standing point on the surface
+    int source;           // Geometry this node came from (for incremental removal)
+    bool alive;
+    bool edge;            // First/last node of its surface; jumps and falls start or end here
+    std::vector<NavLink> links;
+};
+
+struct NavPathPoint {
+    b2Vec2 pos;
+    NavLinkType link;     // How this point is reached from the previous one
+};
+
+struct NavStats {
+    int nodes;
+    int links;
+    int cachedPaths;
+    long long cacheHits;
+    long long cacheMisses;
+};
+
+// Surfaces: polyline of standing points (left to right). Links to nearby geometry are built incrementally.
+void nav_add_surface(int source, const b2Vec2* points, int count);
+void nav_add_box(int source, b2Vec2 center, float halfW, float halfH);
+void nav_remove_source(int source);
+void nav_clear();
+
+// Terrain chunk listener (see terrain_add_chunk_listener)
+void nav_on_terrain_chunk(const TerrainChunk& chunk, bool loaded);
+
+// A* between the nodes nearest to from/to. Cached until geometry near the path changes.
+bool nav_find_path(b2Vec2 from, b2Vec2 to, std::vector<NavPathPoint>& path);
+
+const NavStats& nav_stats();
+const std::vector<NavNode>& nav_nodes();
+
+// Build time and queries per second, cold and cached (headless)
+void bench_nav_graph(int count);
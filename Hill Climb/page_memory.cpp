@@ -0,0 +1,400 @@
+// page_memory.cpp
+// Large virtual memory reservations for pools: optional huge pages, prefaulted at load, fault/TLB counters
+
+#include "page_memory.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <box2d/box2d.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+// Leaked on purpose, see page_memory.h
+MemoryReservation& entity_memory() {
+    static MemoryReservation* reservation = new MemoryReservation();
+    return *reservation;
+}
+
+MemoryReservation& particle_memory() {
+    static MemoryReservation* reservation = new MemoryReservation();
+    return *reservation;
+}
+
+MemoryReservation& physics_memory() {
+    static MemoryReservation* reservation = new MemoryReservation();
+    return *reservation;
+}
+
+const size_t MEMORY_BLOCK_ALIGN = 64;        // Every carved block starts on a cache line
+const int MEMORY_MIN_CLASS = 6;              // 64 byte blocks
+const uint32_t MEMORY_FALLBACK_CLASS = 0xffffffffu;
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Stored just before every pointer handed out
+struct BlockHeader {
+    uint32_t sizeClass;
+    uint32_t offset;      // From the block start to the user pointer
+};
+
+static MemoryFaultStats g_faultsAtInit;
+static MemoryFaultStats g_faultsAfterPrefault;
+static volatile long long g_benchSink;  // Keeps benchmark reads from being optimized out
+
+static const char* page_mode_name(MemoryPageMode mode) {
+    switch (mode) {
+    case MEMORY_PAGES_TRANSPARENT_HUGE: return "transparent huge";
+    case MEMORY_PAGES_EXPLICIT_HUGE: return "explicit huge";
+    default: return "normal";
+    }
+}
+
+static size_t round_up(size_t v, size_t to) {
+    return (v + to - 1) / to * to;
+}
+
+// ---------------- Reserve / release ----------------
+bool memory_reserve(MemoryReservation& r, const char* name, size_t bytes, MemoryPageMode mode) {
+    r.name = name;
+    r.base = nullptr;
+    r.committed = 0;
+    r.used = 0;
+    r.allocations = 0;
+    r.fallbacks = 0;
+    memset(r.freeLists, 0, sizeof(r.freeLists));
+
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    if (mode == MEMORY_PAGES_EXPLICIT_HUGE) {
+        // Needs the "Lock pages in memory" privilege; large pages are always committed and resident
+        size_t large = GetLargePageMinimum();
+        if (large != 0) {
+            size_t size = round_up(bytes, large);
+            void* p = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (p) {
+                r.base = static_cast<char*>(p);
+                r.reserved = r.committed = size;
+                r.pageSize = large;
+                r.mode = MEMORY_PAGES_EXPLICIT_HUGE;
+                return true;
+            }
+        }
+        std::cout << "Memory: large pages unavailable for " << name << " (error " << GetLastError()
+            << "), using normal pages" << std::endl;
+    }
+    r.base = static_cast<char*>(VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_READWRITE));
+    r.reserved = bytes;
+    r.pageSize = info.dwPageSize;
+    r.mode = MEMORY_PAGES_NORMAL;
+#else
+    r.pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#ifdef __linux__
+    if (mode == MEMORY_PAGES_EXPLICIT_HUGE) {
+        size_t size = round_up(bytes, HUGE_PAGE_SIZE);
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            r.base = static_cast<char*>(p);
+            r.reserved = size;
+            r.pageSize = HUGE_PAGE_SIZE;
+            r.mode = MEMORY_PAGES_EXPLICIT_HUGE;
+            return true;
+        }
+        std::cout << "Memory: no hugetlbfs pages for " << name << ", trying transparent huge pages" << std::endl;
+        mode = MEMORY_PAGES_TRANSPARENT_HUGE;
+    }
+    if (mode == MEMORY_PAGES_TRANSPARENT_HUGE) {
+        // Over-map and trim so the range is 2 MB aligned, otherwise THP can't back its ends
+        size_t size = round_up(bytes, HUGE_PAGE_SIZE);
+        void* p = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p != MAP_FAILED) {
+            char* raw = static_cast<char*>(p);
+            char* aligned = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(raw), HUGE_PAGE_SIZE));
+            if (aligned > raw) munmap(raw, aligned - raw);
+            munmap(aligned + size, raw + size + HUGE_PAGE_SIZE - (aligned + size));
+            r.base = aligned;
+            r.reserved = size;
+            r.mode = madvise(aligned, size, MADV_HUGEPAGE) == 0 ? MEMORY_PAGES_TRANSPARENT_HUGE : MEMORY_PAGES_NORMAL;
+            return true;
+        }
+    }
+#endif
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    r.base = p == MAP_FAILED ? nullptr : static_cast<char*>(p);
+    r.reserved = bytes;
+    r.mode = MEMORY_PAGES_NORMAL;
+#endif
+
+    if (!r.base) {
+        std::cout << "Memory: failed to reserve " << (bytes >> 20) << " MB for " << name << std::endl;
+        r.reserved = 0;
+        return false;
+    }
+    return true;
+}
+
+void memory_release(MemoryReservation& r) {
+    if (!r.base) return;
+#ifdef _WIN32
+    VirtualFree(r.base, 0, MEM_RELEASE);
+#else
+    munmap(r.base, r.reserved);
+#endif
+    r.base = nullptr;
+    r.reserved = r.committed = r.used = 0;
+    memset(r.freeLists, 0, sizeof(r.freeLists));
+}
+
+// Makes [committed, upTo) usable; on Windows that is a commit, elsewhere the pages are already mapped
+static bool commit_to(MemoryReservation& r, size_t upTo) {
+    if (upTo <= r.committed) return true;
+    upTo = round_up(upTo, 64 * 1024);
+    if (upTo > r.reserved) upTo = r.reserved;
+#ifdef _WIN32
+    if (!VirtualAlloc(r.base + r.committed, upTo - r.committed, MEM_COMMIT, PAGE_READWRITE)) return false;
+#endif
+    r.committed = upTo;
+    return true;
+}
+
+void memory_prefault(MemoryReservation& r, size_t bytes) {
+    if (!r.base) return;
+    if (bytes > r.reserved) bytes = r.reserved;
+    std::lock_guard<std::mutex> guard(r.lock);
+    size_t first = r.committed;
+    if (!commit_to(r, bytes)) return;
+    // One write per page; with huge pages the first write faults in the whole 2 MB
+    volatile char* p = r.base;
+    for (size_t offset = first; offset < bytes; offset += r.pageSize) p[offset] = 0;
+}
+
+// ---------------- Allocation ----------------
+static int size_class(size_t bytes) {
+    int c = MEMORY_MIN_CLASS;
+    while ((size_t(1) << c) < bytes) ++c;
+    return c;
+}
+
+void* memory_alloc(MemoryReservation& r, size_t bytes, size_t alignment) {
+    if (alignment < alignof(BlockHeader)) alignment = alignof(BlockHeader);
+    size_t headerSpace = alignment < sizeof(BlockHeader) ? sizeof(BlockHeader) : alignment;
+    int c = size_class(bytes + headerSpace);
+
+    char* block = nullptr;
+    if (r.base && alignment <= MEMORY_BLOCK_ALIGN && c < MEMORY_SIZE_CLASSES) {
+        std::lock_guard<std::mutex> guard(r.lock);
+        if (r.freeLists[c]) {
+            block = static_cast<char*>(r.freeLists[c]);
+            r.freeLists[c] = *reinterpret_cast<void**>(block);
+        }
+        else {
+            size_t start = round_up(r.used, MEMORY_BLOCK_ALIGN);
+            size_t end = start + (size_t(1) << c);
+            if (end <= r.reserved && commit_to(r, end)) {
+                block = r.base + start;
+                r.used = end;
+            }
+        }
+        if (block) r.allocations++;
+        else r.fallbacks++;
+    }
+    else {
+        std::lock_guard<std::mutex> guard(r.lock);
+        r.fallbacks++;
+    }
+
+    uint32_t sizeClass = static_cast<uint32_t>(c);
+    if (!block) {
+        // Heap fallback: over-allocate so the user pointer can be aligned after the header
+        block = static_cast<char*>(malloc(bytes + headerSpace + alignment));
+        if (!block) return nullptr;
+        sizeClass = MEMORY_FALLBACK_CLASS;
+    }
+    char* user = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(block) + sizeof(BlockHeader), alignment));
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(user) - 1;
+    header->sizeClass = sizeClass;
+    header->offset = static_cast<uint32_t>(user - block);
+    return user;
+}
+
+void memory_free(MemoryReservation& r, void* ptr) {
+    if (!ptr) return;
+    BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+    char* block = static_cast<char*>(ptr) - header->offset;
+    if (header->sizeClass == MEMORY_FALLBACK_CLASS) {
+        free(block);
+        return;
+    }
+    std::lock_guard<std::mutex> guard(r.lock);
+    *reinterpret_cast<void**>(block) = r.freeLists[header->sizeClass];
+    r.freeLists[header->sizeClass] = block;
+}
+
+MemoryUsage memory_usage(MemoryReservation& r) {
+    std::lock_guard<std::mutex> guard(r.lock);
+    return { r.committed, r.used, r.allocations, r.fallbacks };
+}
+
+// ---------------- Game pools ----------------
+struct PoolConfig {
+    MemoryReservation& (*reservation)();
+    const char* name;
+    size_t reserveBytes;
+    size_t prefaultBytes;
+};
+
+static const PoolConfig g_poolConfigs[] = {
+    { entity_memory,   "entities",  64u << 20,  8u << 20 },
+    { particle_memory, "particles", 16u << 20,  2u << 20 },
+    { physics_memory,  "physics",   256u << 20, 32u << 20 },  // Box2D worlds, arenas and contact arrays
+};
+
+static void* box2d_alloc(unsigned int size, int alignment) {
+    return memory_alloc(physics_memory(), size, static_cast<size_t>(alignment));
+}
+
+static void box2d_free(void* mem) {
+    memory_free(physics_memory(), mem);
+}
+
+void memory_init(MemoryPageMode mode) {
+    memory_fault_stats(); // Opens the TLB counter before worker threads start, so they inherit it
+    g_faultsAtInit = memory_fault_stats();
+    for (const PoolConfig& pool : g_poolConfigs) {
+        if (memory_reserve(pool.reservation(), pool.name, pool.reserveBytes, mode)) {
+            memory_prefault(pool.reservation(), pool.prefaultBytes);
+        }
+    }
+    g_faultsAfterPrefault = memory_fault_stats();
+    b2SetAllocator(box2d_alloc, box2d_free);
+}
+
+// ---------------- Counters ----------------
+#ifdef __linux__
+static int g_dtlbCounter = -2; // -2: not opened yet, -1: unavailable
+
+static long long read_dtlb_misses() {
+    if (g_dtlbCounter == -2) {
+        perf_event_attr attr = {};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        g_dtlbCounter = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (g_dtlbCounter < 0) g_dtlbCounter = -1;
+    }
+    long long value = 0;
+    if (g_dtlbCounter < 0 || read(g_dtlbCounter, &value, sizeof(value)) != sizeof(value)) return -1;
+    return value;
+}
+#endif
+
+MemoryFaultStats memory_fault_stats() {
+    MemoryFaultStats stats = { 0, 0, -1 };
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        stats.minorFaults = counters.PageFaultCount;
+    }
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        stats.minorFaults = usage.ru_minflt;
+        stats.majorFaults = usage.ru_majflt;
+    }
+#endif
+#ifdef __linux__
+    stats.dtlbMisses = read_dtlb_misses();
+#endif
+    return stats;
+}
+
+void print_memory_reservations() {
+    MemoryFaultStats now = memory_fault_stats();
+    std::cout << "---- Memory reservations ----" << std::endl;
+    std::cout << std::left << std::setw(10) << "pool" << std::setw(18) << "pages" << std::right
+        << std::setw(10) << "page KB" << std::setw(10) << "res MB" << std::setw(10) << "commit MB"
+        << std::setw(10) << "used MB" << std::setw(10) << "allocs" << std::setw(10) << "fallback" << std::endl;
+    for (const PoolConfig& pool : g_poolConfigs) {
+        MemoryReservation& r = pool.reservation();
+        MemoryUsage usage = memory_usage(r);
+        std::cout << std::left << std::setw(10) << pool.name << std::setw(18) << page_mode_name(r.mode) << std::right
+            << std::setw(10) << (r.pageSize >> 10) << std::setw(10) << (r.reserved >> 20)
+            << std::setw(10) << (usage.committed >> 20) << std::setw(10) << std::fixed << std::setprecision(2)
+            << usage.used / 1048576.0 << std::setw(10) << usage.allocations << std::setw(10) << usage.fallbacks << std::endl;
+    }
+    std::cout << "Page faults: " << g_faultsAfterPrefault.minorFaults - g_faultsAtInit.minorFaults
+        << " during prefault, " << now.minorFaults - g_faultsAfterPrefault.minorFaults << " minor / "
+        << now.majorFaults - g_faultsAfterPrefault.majorFaults << " major since" << std::endl;
+    if (now.dtlbMisses >= 0) std::cout << "dTLB load misses: " << now.dtlbMisses << std::endl;
+    else std::cout << "dTLB load misses: unavailable" << std::endl;
+}
+
+// ---------------- Benchmark ----------------
+static void bench_page_mode(const char* label, size_t bytes, MemoryPageMode mode, bool prefault) {
+    MemoryReservation r;
+    if (!memory_reserve(r, label, bytes, mode)) return;
+
+    MemoryFaultStats f0 = memory_fault_stats();
+    auto t0 = std::chrono::high_resolution_clock::now();
+    if (prefault) memory_prefault(r, bytes);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    MemoryFaultStats fPrefault = memory_fault_stats();
+
+    // "Gameplay" touch: what the first explosion would pay without prefaulting
+    commit_to(r, bytes);
+    for (size_t offset = 0; offset < bytes; offset += 4096) r.base[offset] = 1;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    MemoryFaultStats f1 = memory_fault_stats();
+
+    // Random reads over the whole range stress the TLB
+    uint32_t x = 12345;
+    long long sum = 0;
+    for (int i = 0; i < 4000000; ++i) {
+        x = x * 1664525u + 1013904223u;
+        sum += r.base[(static_cast<size_t>(x) * 64) % bytes];
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+    MemoryFaultStats f2 = memory_fault_stats();
+
+    auto ms = [](std::chrono::high_resolution_clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    std::cout << "  " << std::left << std::setw(24) << label << std::right << std::fixed << std::setprecision(2)
+        << " got " << page_mode_name(r.mode) << ": prefault " << ms(t1 - t0) << " ms ("
+        << fPrefault.minorFaults - f0.minorFaults << " faults), first touch " << ms(t2 - t1) << " ms ("
+        << f1.minorFaults - fPrefault.minorFaults << " faults), random reads "
+        << ms(t3 - t2) << " ms";
+    if (f2.dtlbMisses >= 0) std::cout << " (" << f2.dtlbMisses - f1.dtlbMisses << " dTLB misses)";
+    std::cout << std::endl;
+    g_benchSink = sum;
+    memory_release(r);
+}
+
+void bench_page_memory(int megabytes) {
+    size_t bytes = static_cast<size_t>(megabytes) << 20;
+    std::cout << "Page memory: " << megabytes << " MB per reservation" << std::endl;
+    bench_page_mode("normal", bytes, MEMORY_PAGES_NORMAL, false);
+    bench_page_mode("normal, prefaulted", bytes, MEMORY_PAGES_NORMAL, true);
+    bench_page_mode("transparent huge", bytes, MEMORY_PAGES_TRANSPARENT_HUGE, true);
+    bench_page_mode("explicit huge", bytes, MEMORY_PAGES_EXPLICIT_HUGE, true);
+}
@@ -0,0 +1,89 @@
+// page_memory.h
+// Large virtual memory reservations for pools: optional huge pages, prefaulted at load, fault/TLB counters
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+enum MemoryPageMode {
+    MEMORY_PAGES_NORMAL,
+    MEMORY_PAGES_TRANSPARENT_HUGE,  // Linux THP via madvise; Windows treats it as normal pages
+    MEMORY_PAGES_EXPLICIT_HUGE,     // MAP_HUGETLB / MEM_LARGE_PAGES, falls back to the modes above
+};
+
+const int MEMORY_SIZE_CLASSES = 40;
+
+// One contiguous range. Allocations are carved bump-style; freed blocks go to per size class free lists.
+struct MemoryReservation {
+    const char* name;
+    char* base;
+    size_t reserved;
+    size_t committed;     // Bytes made resident (Windows commit / prefault watermark)
+    size_t used;          // Bump offset
+    size_t pageSize;
+    MemoryPageMode mode;  // Mode actually obtained
+    void* freeLists[MEMORY_SIZE_CLASSES];
+    long long allocations;
+    long long fallbacks;  // Served from the heap because the range was full or not reserved yet
+    std::mutex lock;
+};
+
+// What other threads change, copied under the lock
+struct MemoryUsage {
+    size_t committed;
+    size_t used;
+    long long allocations;
+    long long fallbacks;
+};
+
+struct MemoryFaultStats {
+    long long minorFaults;  // Windows only reports a single total, counted here
+    long long majorFaults;
+    long long dtlbMisses;   // -1 when hardware counters aren't available
+};
+
+// Pools that carve from reservations (reserved by memory_init). Created on first use and never
+// destroyed: pool containers with static storage (particles, g_enemyBatch) free into them during
+// static destruction, when a global reservation and its mutex could already be gone.
+MemoryReservation& entity_memory();
+MemoryReservation& particle_memory();
+MemoryReservation& physics_memory();
+
+bool memory_reserve(MemoryReservation& r, const char* name, size_t bytes, MemoryPageMode mode);
+void memory_release(MemoryReservation& r);
+// Makes the first bytes of the range resident now instead of on first touch
+void memory_prefault(MemoryReservation& r, size_t bytes);
+
+void* memory_alloc(MemoryReservation& r, size_t bytes, size_t alignment);
+void memory_free(MemoryReservation& r, void* ptr);
+// Safe while workers and Box2D allocate from r
+MemoryUsage memory_usage(MemoryReservation& r);
+
+// Reserves and prefaults the game pools and routes Box2D allocations to physics_memory().
+// Call before the first b2CreateWorld. The pools live until the process exits, since pool
+// containers (global batches, locals in main) are destroyed after main's cleanup.
+void memory_init(MemoryPageMode mode);
+
+MemoryFaultStats memory_fault_stats();
+void print_memory_reservations();
+
+// Stateless std allocator over one reservation, for pool containers
+template <typename T, MemoryReservation& (*R)()>
+struct ReservationAllocator {
+    typedef T value_type;
+    template <typename U> struct rebind { typedef ReservationAllocator<U, R> other; };
+
+    ReservationAllocator() = default;
+    template <typename U> ReservationAllocator(const ReservationAllocator<U, R>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(memory_alloc(R(), n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, size_t) { memory_free(R(), p); }
+
+    template <typename U> bool operator==(const ReservationAllocator<U, R>&) const { return true; }
+    template <typename U> bool operator!=(const ReservationAllocator<U, R>&) const { return false; }
+};
+
+// Fault counts and time for first touch of fresh pages vs prefaulted vs huge pages (headless)
+void bench_page_memory(int megabytes);
@@ -0,0 +1,580 @@
+// profiler.cpp
+// Frame profiler: scoped timings, hardware counters, Box2D step profile/counters, telemetry CSV, Chrome trace export and hitch recorder
+
+#include "profiler.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+
+#include "thread_config.h"
+#include "tracepoints.h"
+
+static const auto g_profilerEpoch = std::chrono::steady_clock::now();
+
+static ProfileFrame g_frames[PROFILER_HISTORY];
+static int g_currentFrame = 0;
+static uint64_t g_frameCounter = 0;
+static std::mutex g_eventMutex;
+
+static std::ofstream g_telemetry;
+
+// Flight recorder
+static double g_hitchThresholdMs = 0.0;
+static int g_hitchPostFrames = 30;
+static double g_hitchCooldownUs = 10e6;
+static int g_hitchFramesLeft = -1;      // Frames to wait before dumping, -1 when idle
+static uint64_t g_hitchFrame = 0;
+static double g_lastHitchDump = -1e18;
+static int g_hitchDumps = 0;
+
+// Hitch dumps are written on a thread of their own: a job could be picked up by the frame
+// thread itself while it waits in job_wait or helps out in scheduler_run
+struct HitchDump {
+    std::shared_ptr<std::vector<ProfileFrame>> frames;
+    std::string path;
+};
+static std::thread g_hitchWriter;
+static std::mutex g_hitchMutex;
+static std::condition_variable g_hitchChanged;
+static std::deque<HitchDump> g_hitchQueue;
+static bool g_hitchWriterQuit = false;
+
+static std::atomic<bool> g_hwCounters{ false };
+
+struct OpenScope {
+    const char* name;
+    double start;
+    bool hasCounters;
+    HwCounterValues counters;
+};
+
+thread_local std::vector<OpenScope> t_scopeStack;
+
+double profiler_now_us() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - g_profilerEpoch).count();
+}
+
+uint32_t profiler_thread_index() {
+    static std::atomic<uint32_t> nextIndex{ 0 };
+    thread_local uint32_t index = nextIndex++;
+    return index;
+}
+
+// ---------------- Frames ----------------
+void profiler_begin_frame() {
+    ProfileFrame& frame = g_frames[g_currentFrame];
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    frame.events.clear(); // Keeps capacity, so steady-state frames don't allocate
+    frame.counters.clear();
+    frame.instants.clear();
+    frame.hwScopes.clear();
+    memset(&frame.stats, 0, sizeof(frame.stats));
+    frame.stats.frameIndex = g_frameCounter;
+    frame.stats.start = profiler_now_us();
+    TRACE_PROBE1(frame_begin, frame.stats.frameIndex);
+}
+
+static void write_telemetry_line(const FrameStats& s) {
+    const b2Profile& p = s.physics;
+    const b2Counters& c = s.counters;
+    g_telemetry << s.frameIndex << ',' << (s.end - s.start) / 1000.0 << ',' << s.physicsSteps << ','
+        << p.step << ',' << p.pairs << ',' << p.collide << ',' << p.solve << ',' << p.bullets << ','
+        << p.sleepIslands << ',' << p.sensors << ','
+        << c.bodyCount << ',' << c.shapeCount << ',' << c.contactCount << ',' << c.islandCount << ','
+        << c.taskCount << '\n';
+}
+
+static bool update_hitch_recorder(ProfileFrame& frame);
+static void dump_hitch_trace();
+
+void profiler_end_frame() {
+    ProfileFrame& frame = g_frames[g_currentFrame];
+    frame.stats.end = profiler_now_us();
+    TRACE_PROBE2(frame_end, frame.stats.frameIndex, static_cast<long long>(frame.stats.end - frame.stats.start));
+
+    if (g_telemetry.is_open()) write_telemetry_line(frame.stats);
+    bool dump = update_hitch_recorder(frame);
+
+    g_frameCounter++;
+    g_currentFrame = (g_currentFrame + 1) % PROFILER_HISTORY;
+    if (dump) dump_hitch_trace();
+}
+
+const ProfileFrame& profiler_last_frame() {
+    return g_frames[(g_currentFrame + PROFILER_HISTORY - 1) % PROFILER_HISTORY];
+}
+
+void profiler_history(std::vector<const ProfileFrame*>& out) {
+    out.clear();
+    // Completed frames only: the current slot is still being filled by worker threads
+    const int completed = PROFILER_HISTORY - 1;
+    int count = g_frameCounter < static_cast<uint64_t>(completed) ? static_cast<int>(g_frameCounter) : completed;
+    for (int i = count; i > 0; --i) {
+        out.push_back(&g_frames[(g_currentFrame + PROFILER_HISTORY - i) % PROFILER_HISTORY]);
+    }
+}
+
+double profiler_scope_ms(const ProfileFrame& frame, const char* name) {
+    double total = 0.0;
+    for (const ProfileEvent& e : frame.events) {
+        if (strcmp(e.name, name) == 0) total += e.end - e.start;
+    }
+    return total / 1000.0;
+}
+
+// ---------------- Scopes ----------------
+void profiler_record(const char* name, double start, double end, int depth) {
+    ProfileEvent e = { name, start, end, depth, profiler_thread_index() };
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    g_frames[g_currentFrame].events.push_back(e);
+}
+
+void profiler_counter(const char* name, double value) {
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    g_frames[g_currentFrame].counters.push_back({ name, value });
+}
+
+void profiler_instant(const char* name, int value) {
+    ProfileInstant e = { name, profiler_now_us(), value };
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    g_frames[g_currentFrame].instants.push_back(e);
+}
+
+// Caller holds g_eventMutex
+static ProfileHwScope& find_hw_scope(ProfileFrame& frame, const char* name) {
+    for (ProfileHwScope& s : frame.hwScopes) {
+        if (s.name == name || strcmp(s.name, name) == 0) return s;
+    }
+    ProfileHwScope s = {};
+    s.name = name;
+    frame.hwScopes.push_back(s);
+    return frame.hwScopes.back();
+}
+
+void profiler_push(const char* name) {
+    OpenScope scope = { name, profiler_now_us(), false, {} };
+    t_scopeStack.push_back(scope);
+    // Counters read last on push and first on pop, so the profiler's own work stays outside
+    if (g_hwCounters.load(std::memory_order_relaxed)) {
+        OpenScope& top = t_scopeStack.back();
+        top.hasCounters = hw_counters_read(top.counters);
+    }
+}
+
+void profiler_pop() {
+    HwCounterValues now;
+    bool counted = t_scopeStack.back().hasCounters && hw_counters_read(now);
+    OpenScope scope = t_scopeStack.back();
+    t_scopeStack.pop_back();
+    profiler_record(scope.name, scope.start, profiler_now_us(), static_cast<int>(t_scopeStack.size()));
+    if (!counted) return;
+
+    long long delta[HW_COUNTER_COUNT];
+    bool scaled = false;
+    bool ran = hw_counters_delta(scope.counters, now, delta, scaled);
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    ProfileHwScope& s = find_hw_scope(g_frames[g_currentFrame], scope.name);
+    s.calls++;
+    s.multiplexed += scaled ? 1 : 0;
+    s.uncounted += ran ? 0 : 1;
+    for (int i = 0; i < HW_COUNTER_COUNT; ++i) s.counts[i] += delta[i];
+}
+
+// ---------------- Hardware Counters ----------------
+bool profiler_enable_hw_counters(bool enable) {
+    if (enable && !hw_counters_available()) enable = false;
+    g_hwCounters = enable;
+    return enable;
+}
+
+bool profiler_hw_counters_enabled() {
+    return g_hwCounters;
+}
+
+void profiler_elements(const char* name, long long count) {
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    find_hw_scope(g_frames[g_currentFrame], name).elements += count;
+}
+
+bool profiler_hw_scope(const ProfileFrame& frame, const char* name, ProfileHwScope& out) {
+    for (const ProfileHwScope& s : frame.hwScopes) {
+        if (s.calls > 0 && strcmp(s.name, name) == 0) {
+            out = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+static double hw_ratio(long long a, long long b) {
+    return b > 0 ? static_cast<double>(a) / b : 0.0;
+}
+
+void profiler_print_hw_report() {
+    std::vector<const ProfileFrame*> history;
+    profiler_history(history);
+    if (history.empty()) return;
+
+    // Summed by name over the history, in first-seen order, averaged over the frames each scope ran in
+    std::vector<ProfileHwScope> totals;
+    std::vector<int> frameCounts;
+    {
+        std::lock_guard<std::mutex> lock(g_eventMutex);
+        for (const ProfileFrame* frame : history) {
+            for (const ProfileHwScope& s : frame->hwScopes) {
+                size_t i = 0;
+                while (i < totals.size() && strcmp(totals[i].name, s.name) != 0) ++i;
+                if (i == totals.size()) {
+                    totals.push_back({ s.name, 0, 0, {} });
+                    frameCounts.push_back(0);
+                }
+                frameCounts[i] += s.calls > 0 ? 1 : 0;
+                totals[i].calls += s.calls;
+                totals[i].elements += s.elements;
+                totals[i].multiplexed += s.multiplexed;
+                totals[i].uncounted += s.uncounted;
+                for (int c = 0; c < HW_COUNTER_COUNT; ++c) totals[i].counts[c] += s.counts[c];
+            }
+        }
+    }
+
+    std::cout << "Hardware counters, per frame over the last " << history.size() << " frames"
+        << (g_hwCounters ? "" : " (counters off, start with --hw-counters)") << std::endl;
+    std::cout << "  " << std::left << std::setw(18) << "scope" << std::right
+        << std::setw(12) << "cycles" << std::setw(12) << "instr" << std::setw(6) << "IPC"
+        << std::setw(10) << "L1D miss" << std::setw(10) << "LLC miss" << std::setw(10) << "br miss"
+        << "   per element: cycles L1D LLC" << std::endl;
+    std::cout << std::fixed;
+    for (size_t i = 0; i < totals.size(); ++i) {
+        const ProfileHwScope& s = totals[i];
+        if (s.calls == 0) continue;
+        double frames = frameCounts[i];
+        const long long* c = s.counts;
+        std::cout << "  " << std::left << std::setw(18) << s.name << std::right << std::setprecision(0)
+            << std::setw(12) << c[HW_CYCLES] / frames << std::setw(12) << c[HW_INSTRUCTIONS] / frames
+            << std::setw(6) << std::setprecision(2) << hw_ratio(c[HW_INSTRUCTIONS], c[HW_CYCLES]) << std::setprecision(0)
+            << std::setw(10) << c[HW_L1D_MISSES] / frames << std::setw(10) << c[HW_LLC_MISSES] / frames
+            << std::setw(10) << c[HW_BRANCH_MISSES] / frames;
+        if (s.elements > 0) {
+            std::cout << "   " << std::setprecision(1) << hw_ratio(c[HW_CYCLES], s.elements) << " "
+                << std::setprecision(3) << hw_ratio(c[HW_L1D_MISSES], s.elements) << " "
+                << hw_ratio(c[HW_LLC_MISSES], s.elements) << std::setprecision(0) << " (" << s.elements / frames << " elements)";
+        }
+        // Other perf users or the watchdog held the PMU: scaled counts are estimates, uncounted calls are missing
+        if (s.multiplexed > 0) std::cout << "   [multiplexed in " << s.multiplexed << "/" << s.calls << " calls]";
+        if (s.uncounted > 0) std::cout << "   [NOT COUNTED in " << s.uncounted << "/" << s.calls << " calls]";
+        std::cout << std::endl;
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+// ---------------- Box2D ----------------
+void profiler_sample_box2d(b2WorldId world, double stepStart, double stepEnd) {
+    b2Profile p = b2World_GetProfile(world);
+    b2Counters c = b2World_GetCounters(world);
+    int depth = static_cast<int>(t_scopeStack.size());
+
+    FrameStats& s = g_frames[g_currentFrame].stats;
+    s.physicsSteps++;
+    s.physics.step += p.step;
+    s.physics.pairs += p.pairs;
+    s.physics.collide += p.collide;
+    s.physics.solve += p.solve;
+    s.physics.solveConstraints += p.solveConstraints;
+    s.physics.transforms += p.transforms;
+    s.physics.refit += p.refit;
+    s.physics.bullets += p.bullets;
+    s.physics.sleepIslands += p.sleepIslands;
+    s.physics.sensors += p.sensors;
+    s.counters = c; // Counters are a snapshot, not a sum
+    TRACE_PROBE2(physics_step_end, static_cast<long long>(stepEnd - stepStart), c.contactCount);
+
+    profiler_record("b2World_Step", stepStart, stepEnd, depth);
+
+    // Box2D only reports durations, so phases are laid out back to back in execution order
+    double t = stepStart;
+    auto phase = [&](const char* name, float ms, int d) {
+        double end = t + ms * 1000.0;
+        profiler_record(name, t, end, d);
+        return end;
+    };
+    t = phase("b2 pairs", p.pairs, depth + 1);
+    t = phase("b2 collide", p.collide, depth + 1);
+    double solveEnd = phase("b2 solve", p.solve, depth + 1); // Children start where solve starts
+    t = phase("b2 constraints", p.solveConstraints, depth + 2);
+    t = phase("b2 transforms", p.transforms, depth + 2);
+    t = phase("b2 refit", p.refit, depth + 2);
+    t = phase("b2 continuous", p.bullets, depth + 2);
+    t = phase("b2 sleep islands", p.sleepIslands, depth + 2);
+    t = solveEnd;
+    phase("b2 sensors", p.sensors, depth + 1);
+}
+
+// ---------------- Telemetry ----------------
+bool profiler_open_telemetry(const char* path) {
+    g_telemetry.open(path, std::ios::out | std::ios::trunc);
+    if (!g_telemetry.is_open()) {
+        std::cout << "Failed to open telemetry file: " << path << std::endl;
+        return false;
+    }
+    g_telemetry << "frame,frame_ms,steps,b2_step_ms,b2_pairs_ms,b2_collide_ms,b2_solve_ms,b2_continuous_ms,"
+        "b2_sleep_islands_ms,b2_sensors_ms,bodies,shapes,contacts,islands,tasks\n";
+    return true;
+}
+
+void profiler_close_telemetry() {
+    if (g_telemetry.is_open()) g_telemetry.close();
+}
+
+// ---------------- Chrome Trace ----------------
+static bool write_chrome_trace(const char* path, const std::vector<const ProfileFrame*>& frames) {
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cout << "Failed to write trace: " << path << std::endl;
+        return false;
+    }
+
+    // Timestamps are microseconds since startup: the default 6 significant digits would round them
+    // to 100 us after about 10 s, so they're written fixed-point with nanosecond resolution
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto sep = [&]() { if (!first) out << ",\n"; first = false; };
+    for (const ProfileFrame* frame : frames) {
+        sep();
+        out << "{\"name\":\"frame " << frame->stats.frameIndex << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1000,\"ts\":"
+            << frame->stats.start << ",\"dur\":" << frame->stats.end - frame->stats.start << "}";
+        for (const ProfileEvent& e : frame->events) {
+            sep();
+            out << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+                << ",\"ts\":" << e.start << ",\"dur\":" << e.end - e.start << "}";
+        }
+        for (const ProfileInstant& e : frame->instants) {
+            sep();
+            out << "{\"name\":\"" << e.name << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1000,\"ts\":" << e.time
+                << ",\"args\":{\"value\":" << e.value << "}}";
+        }
+        for (const ProfileCounter& c : frame->counters) {
+            sep();
+            out << "{\"name\":\"" << c.name << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame->stats.start
+                << ",\"args\":{\"value\":" << c.value << "}}";
+        }
+        for (const ProfileHwScope& s : frame->hwScopes) {
+            if (s.calls == 0) continue;
+            sep();
+            out << "{\"name\":\"hw " << s.name << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame->stats.start
+                << ",\"args\":{\"ipc\":" << hw_ratio(s.counts[HW_INSTRUCTIONS], s.counts[HW_CYCLES])
+                << ",\"l1d_misses\":" << s.counts[HW_L1D_MISSES] << ",\"llc_misses\":" << s.counts[HW_LLC_MISSES]
+                << ",\"branch_misses\":" << s.counts[HW_BRANCH_MISSES] << "}}";
+        }
+        const b2Counters& c = frame->stats.counters;
+        sep();
+        out << "{\"name\":\"box2d\",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame->stats.start
+            << ",\"args\":{\"bodies\":" << c.bodyCount << ",\"contacts\":" << c.contactCount
+            << ",\"islands\":" << c.islandCount << ",\"tasks\":" << c.taskCount << "}}";
+    }
+    out << "\n]}\n" << std::defaultfloat << std::setprecision(6);
+    return true;
+}
+
+bool profiler_write_chrome_trace(const char* path) {
+    std::vector<const ProfileFrame*> frames;
+    profiler_history(frames);
+    if (!write_chrome_trace(path, frames)) return false;
+    std::cout << "Wrote trace of " << frames.size() << " frames to " << path << std::endl;
+    return true;
+}
+
+// ---------------- Flight Recorder ----------------
+void profiler_set_hitch_recorder(double thresholdMs, int postFrames, double cooldownSeconds) {
+    g_hitchThresholdMs = thresholdMs;
+    g_hitchPostFrames = postFrames < PROFILER_HISTORY / 2 ? postFrames : PROFILER_HISTORY / 2;
+    g_hitchCooldownUs = cooldownSeconds * 1e6;
+    g_hitchFramesLeft = -1;
+}
+
+int profiler_hitch_dumps() {
+    return g_hitchDumps;
+}
+
+// Returns true when a pending hitch has collected its frames after the spike
+static bool update_hitch_recorder(ProfileFrame& frame) {
+    if (g_hitchThresholdMs <= 0.0) return false;
+    double ms = (frame.stats.end - frame.stats.start) / 1000.0;
+    if (g_hitchFramesLeft < 0) {
+        if (ms <= g_hitchThresholdMs || frame.stats.end - g_lastHitchDump < g_hitchCooldownUs) return false;
+        g_hitchFrame = frame.stats.frameIndex;
+        g_hitchFramesLeft = g_hitchPostFrames;
+        std::lock_guard<std::mutex> lock(g_eventMutex);
+        frame.instants.push_back({ "hitch", frame.stats.end, static_cast<int>(ms) });
+    }
+    else {
+        g_hitchFramesLeft--;
+    }
+    if (g_hitchFramesLeft > 0) return false;
+    g_hitchFramesLeft = -1;
+    g_lastHitchDump = frame.stats.end;
+    return true;
+}
+
+static void hitch_writer_main() {
+    // Unpinned and below the workers: a dump can take its time
+    apply_background_thread_config();
+    set_current_thread_priority(THREAD_PRIO_LOW);
+    for (;;) {
+        HitchDump dump;
+        {
+            std::unique_lock<std::mutex> lock(g_hitchMutex);
+            g_hitchChanged.wait(lock, [] { return g_hitchWriterQuit || !g_hitchQueue.empty(); });
+            if (g_hitchQueue.empty()) return;
+            dump = std::move(g_hitchQueue.front());
+            g_hitchQueue.pop_front();
+        }
+        std::vector<const ProfileFrame*> frames;
+        for (const ProfileFrame& frame : *dump.frames) frames.push_back(&frame);
+        if (write_chrome_trace(dump.path.c_str(), frames)) {
+            std::cout << "Hitch recorded: " << dump.path << " (" << frames.size() << " frames)" << std::endl;
+        }
+    }
+}
+
+static void dump_hitch_trace() {
+    // Copy now, before the ring overwrites the spike; formatting and disk I/O go to the writer thread
+    std::vector<const ProfileFrame*> history;
+    profiler_history(history);
+    auto snapshot = std::make_shared<std::vector<ProfileFrame>>();
+    snapshot->reserve(history.size());
+    {
+        std::lock_guard<std::mutex> lock(g_eventMutex);
+        for (const ProfileFrame* frame : history) snapshot->push_back(*frame);
+    }
+    std::string path = "hitch_" + std::to_string(g_hitchFrame) + ".json";
+    g_hitchDumps++;
+
+    {
+        std::lock_guard<std::mutex> lock(g_hitchMutex);
+        g_hitchQueue.push_back({ snapshot, path });
+        g_hitchWriterQuit = false;
+    }
+    if (!g_hitchWriter.joinable()) g_hitchWriter = std::thread(hitch_writer_main);
+    g_hitchChanged.notify_all();
+}
+
+void profiler_finish_hitch_dumps() {
+    if (!g_hitchWriter.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(g_hitchMutex);
+        g_hitchWriterQuit = true;
+    }
+    g_hitchChanged.notify_all();
+    g_hitchWriter.join();
+}
+
+// ---------------- Benchmark ----------------
+void bench_profiler(int frames) {
+    const int scopesPerFrame = 64;
+    auto run = [&](int count) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int f = 0; f < count; ++f) {
+            profiler_begin_frame();
+            for (int i = 0; i < scopesPerFrame; ++i) {
+                PROFILE_SCOPE("bench scope");
+            }
+            profiler_counter("bench allocs", f);
+            profiler_instant("bench input", f);
+            profiler_end_frame();
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / count;
+    };
+
+    profiler_set_hitch_recorder(0.0);
+    run(PROFILER_HISTORY); // Fill the ring so buffers have their capacity
+    double off = run(frames);
+    profiler_set_hitch_recorder(1000.0);
+    double on = run(frames);
+
+    // One forced hitch: time the main-thread part of the dump (the snapshot copy)
+    profiler_set_hitch_recorder(1.0, 0, 0.0);
+    profiler_begin_frame();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    auto t0 = std::chrono::steady_clock::now();
+    profiler_end_frame();
+    double dumpUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    profiler_finish_hitch_dumps();
+    profiler_set_hitch_recorder(0.0);
+
+    std::cout << "Profiler: " << frames << " frames, " << scopesPerFrame << " scopes + 1 counter + 1 instant each" << std::endl;
+    std::cout << "  recorder off: " << off << " us/frame" << std::endl;
+    std::cout << "  recorder on:  " << on << " us/frame (no hitches)" << std::endl;
+    std::cout << "  hitch dump:   " << dumpUs << " us on the frame thread (" << PROFILER_HISTORY - 1 << " frames copied)" << std::endl;
+}
+
+void bench_hw_counters(int elements) {
+    if (elements < 1024) elements = 1024;
+    const int frames = 16;
+    std::vector<int> data(elements);
+    std::vector<int> order(elements);
+    uint32_t rng = 12345;
+    for (int i = 0; i < elements; ++i) {
+        data[i] = i;
+        order[i] = i;
+    }
+    for (int i = elements - 1; i > 0; --i) {
+        rng = rng * 1664525u + 1013904223u;
+        std::swap(order[i], order[rng % (i + 1)]);
+    }
+
+    auto scopes = [&]() {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < 10000; ++i) {
+            PROFILE_SCOPE("bench scope");
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / 10000;
+    };
+
+    profiler_set_hitch_recorder(0.0);
+    profiler_enable_hw_counters(false);
+    profiler_begin_frame();
+    double off = scopes();
+    profiler_end_frame();
+    if (!profiler_enable_hw_counters(true)) return;
+    profiler_begin_frame();
+    double on = scopes();
+    profiler_end_frame();
+
+    // Same sum, once in memory order and once through a shuffled index: the timings differ,
+    // the counters say why
+    long long sum = 0;
+    for (int f = 0; f < PROFILER_HISTORY; ++f) {
+        profiler_begin_frame();
+        if (f >= PROFILER_HISTORY - frames) {
+            {
+                PROFILE_SCOPE("sequential");
+                for (int i = 0; i < elements; ++i) sum += data[i];
+            }
+            {
+                PROFILE_SCOPE("random");
+                for (int i = 0; i < elements; ++i) sum -= data[order[i]];
+            }
+            profiler_elements("sequential", elements);
+            profiler_elements("random", elements);
+        }
+        profiler_end_frame();
+    }
+
+    std::cout << "Hardware counters: " << elements << " ints (" << elements * sizeof(int) / 1024 << " KB)" << std::endl;
+    std::cout << "  scope cost: " << off << " ns off, " << on << " ns with counters" << std::endl;
+    std::cout << "  sums " << (sum == 0 ? "match" : "DIFFER") << std::endl;
+    profiler_print_hw_report();
+    profiler_enable_hw_counters(false);
+}
@@ -0,0 +1,130 @@
+// profiler.h
+// Frame profiler: scoped timings, hardware counters, Box2D step profile/counters, telemetry CSV, Chrome trace export and hitch recorder
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <box2d/box2d.h>
+
+#include "hw_counters.h"
+
+const int PROFILER_HISTORY = 240; // Frames kept for the timeline (4 s at 60 Hz)
+
+struct ProfileEvent {
+    const char* name;   // Must be a string literal (stored by pointer)
+    double start;       // Microseconds since profiler start
+    double end;
+    int depth;
+    uint32_t thread;
+};
+
+struct ProfileCounter {
+    const char* name;   // String literal
+    double value;
+};
+
+struct ProfileInstant {
+    const char* name;   // String literal
+    double time;
+    int value;          // Shown as an arg, e.g. the key code
+};
+
+// Hardware counter deltas per scope name, summed over the frame. Nested scopes are
+// inclusive, like their timings. elements is whatever the scope reported processing.
+// Multiplexed calls are scaled estimates; uncounted calls add nothing, so the sums are low.
+struct ProfileHwScope {
+    const char* name;   // String literal
+    int calls;
+    long long elements;
+    long long counts[HW_COUNTER_COUNT];
+    int multiplexed;    // Calls scaled by enabled/running
+    int uncounted;      // Calls the group never got onto the PMU for
+};
+
+struct FrameStats {
+    uint64_t frameIndex;
+    double start;
+    double end;
+
+    // Box2D, summed over the steps taken this frame (milliseconds)
+    int physicsSteps;
+    b2Profile physics;
+    b2Counters counters;
+};
+
+struct ProfileFrame {
+    FrameStats stats;
+    std::vector<ProfileEvent> events;
+    std::vector<ProfileCounter> counters;
+    std::vector<ProfileInstant> instants;
+    std::vector<ProfileHwScope> hwScopes;
+};
+
+void profiler_begin_frame();
+void profiler_end_frame();
+
+double profiler_now_us();
+uint32_t profiler_thread_index();
+
+// Scope API (use PROFILE_SCOPE)
+void profiler_push(const char* name);
+void profiler_pop();
+void profiler_record(const char* name, double start, double end, int depth);
+
+// Counter track sample for this frame (allocation counts and the like)
+void profiler_counter(const char* name, double value);
+// Point event on the timeline, e.g. an input edge
+void profiler_instant(const char* name, int value);
+
+// Hardware counters around every scope, on every thread that opens scopes. Each scope
+// costs two extra read() syscalls, so it's an instrumentation mode, off by default.
+// Returns false (and stays off) where perf_event_open isn't available.
+bool profiler_enable_hw_counters(bool enable);
+bool profiler_hw_counters_enabled();
+// Elements processed by the named scope this frame, for misses/cycles per element
+void profiler_elements(const char* name, long long count);
+// Named scope's counters in a frame; false if it has none
+bool profiler_hw_scope(const ProfileFrame& frame, const char* name, ProfileHwScope& out);
+// Per-frame averages over the history: cycles, instructions, IPC, misses and per-element rates
+void profiler_print_hw_report();
+
+// Reads b2World_GetProfile / b2World_GetCounters after a step and adds the
+// Box2D phases to the timeline as children of the step that just ran.
+void profiler_sample_box2d(b2WorldId world, double stepStart, double stepEnd);
+
+const ProfileFrame& profiler_last_frame();
+// Completed frames in order oldest -> newest (never the one in progress)
+void profiler_history(std::vector<const ProfileFrame*>& out);
+// Time spent in named scopes during the last frame (milliseconds)
+double profiler_scope_ms(const ProfileFrame& frame, const char* name);
+
+// Telemetry stream: one CSV line per frame
+bool profiler_open_telemetry(const char* path);
+void profiler_close_telemetry();
+
+// Chrome trace (chrome://tracing, Perfetto) of the frames in history
+bool profiler_write_chrome_trace(const char* path);
+
+// Flight recorder: a frame slower than thresholdMs gets a "hitch" marker, and postFrames
+// later the whole history (the seconds before and after it) is written to
+// hitch_<frame>.json. The frames are copied on the main thread and written on a low-priority
+// thread of the recorder's own, at most once per cooldownSeconds. thresholdMs <= 0 turns it off.
+void profiler_set_hitch_recorder(double thresholdMs, int postFrames = 30, double cooldownSeconds = 10.0);
+int profiler_hitch_dumps();
+// Writes the dumps still queued and stops the writer thread; call before exit
+void profiler_finish_hitch_dumps();
+
+// Per-frame cost of scopes, counters and the recorder, and the snapshot cost of a dump (headless)
+void bench_profiler(int frames);
+// Scope cost with counters on, and counters for a streaming vs a random-access loop (headless)
+void bench_hw_counters(int elements);
+
+struct ProfileScope {
+    explicit ProfileScope(const char* name) { profiler_push(name); }
+    ~ProfileScope() { profiler_pop(); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
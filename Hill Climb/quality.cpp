@@ -0,0 +1,243 @@
+// quality.cpp
+// Quality presets chosen by a first-run hardware calibration, persisted to quality.cfg with user overrides
+
+#include "quality.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <box2d/box2d.h>
+
+// Share of a 60 Hz frame each side may use on the reference workloads
+const double QUALITY_SIM_BUDGET_MS = 8.0;
+const double QUALITY_RENDER_BUDGET_MS = 6.0;
+const int CALIBRATION_SUB_STEPS = 8;
+const int CALIBRATION_BOXES = 200;
+const int CALIBRATION_PARTICLES = 1000;
+
+static const QualitySettings g_qualityPresets[QUALITY_PRESET_COUNT] = {
+    // preset          particles  sub-steps  scale  msaa  workers
+    { QUALITY_LOW,     100,       2,         0.5f,  0,    1 },
+    { QUALITY_MEDIUM,  300,       4,         0.75f, 0,    2 },
+    { QUALITY_HIGH,    1000,      8,         1.0f,  4,    0 },
+    { QUALITY_ULTRA,   3000,      8,         1.0f,  8,    0 },
+};
+
+static const char* const g_qualityPresetNames[QUALITY_PRESET_COUNT] = { "low", "medium", "high", "ultra" };
+
+QualitySettings g_quality = g_qualityPresets[QUALITY_HIGH];
+
+QualitySettings quality_preset(QualityPreset preset) {
+    return g_qualityPresets[preset];
+}
+
+const char* quality_preset_name(QualityPreset preset) {
+    return g_qualityPresetNames[preset];
+}
+
+bool quality_preset_from_name(const char* name, QualityPreset& preset) {
+    for (int i = 0; i < QUALITY_PRESET_COUNT; ++i) {
+        if (strcmp(name, g_qualityPresetNames[i]) == 0) {
+            preset = static_cast<QualityPreset>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---------------- Microbenchmarks ----------------
+// Settled pile of boxes on a ground slab: broadphase, contacts and islands, like a busy scene
+static double calibrate_physics() {
+    b2WorldDef worldDef = b2DefaultWorldDef();
+    worldDef.gravity = { 0.0f,-10.0f };
+    b2WorldId world = b2CreateWorld(&worldDef);
+
+    b2BodyDef groundDef = b2DefaultBodyDef();
+    groundDef.position = { 0.0f,-5.0f };
+    b2BodyId ground = b2CreateBody(world, &groundDef);
+    b2Polygon groundShape = b2MakeBox(50.0f, 0.5f);
+    b2ShapeDef groundSD = b2DefaultShapeDef();
+    b2CreatePolygonShape(ground, &groundSD, &groundShape);
+
+    b2Polygon boxShape = b2MakeBox(0.5f, 0.5f);
+    b2ShapeDef boxSD = b2DefaultShapeDef(); boxSD.density = 1.0f; boxSD.material.friction = 0.3f;
+    for (int i = 0; i < CALIBRATION_BOXES; ++i) {
+        b2BodyDef def = b2DefaultBodyDef();
+        def.type = b2_dynamicBody;
+        def.position = { (i % 20) * 1.1f - 11.0f, (i / 20) * 1.1f - 4.0f };
+        b2BodyId body = b2CreateBody(world, &def);
+        b2CreatePolygonShape(body, &boxSD, &boxShape);
+    }
+
+    const float timeStep = 1.0f / 60.0f;
+    for (int i = 0; i < 30; ++i) b2World_Step(world, timeStep, CALIBRATION_SUB_STEPS); // Let the pile land
+    const int frames = 60;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) b2World_Step(world, timeStep, CALIBRATION_SUB_STEPS);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / frames;
+    b2DestroyWorld(world);
+    return ms;
+}
+
+// Same layout and math as the game's particle update
+struct CalibrationParticle {
+    float x, y, vx, vy;
+    float life, size, rotation, rotationSpeed;
+};
+
+static double calibrate_particles() {
+    std::vector<CalibrationParticle> particles(CALIBRATION_PARTICLES);
+    for (int i = 0; i < CALIBRATION_PARTICLES; ++i) {
+        particles[i] = { 0.0f, 0.0f, (i % 7) - 3.0f, (i % 5) + 1.0f, 1e9f, 0.2f, 0.0f, (i % 3) - 1.0f };
+    }
+    const float dt = 1.0f / 60.0f;
+    const int frames = 200;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        for (CalibrationParticle& p : particles) {
+            p.life -= dt;
+            p.x += p.vx * dt;
+            p.y += p.vy * dt;
+            p.rotation += p.rotationSpeed * dt;
+            p.vy -= 10.0f * dt;
+            p.size = 0.2f * (p.life / 0.5f) * (0.7f + 0.3f * (p.life / 0.5f));
+        }
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / frames;
+    volatile float sink = particles[0].size; // Keeps the loop from being optimized away
+    (void)sink;
+    return us;
+}
+
+QualityCalibration run_quality_calibration(double (*renderBench)()) {
+    QualityCalibration c;
+    c.cores = static_cast<int>(std::thread::hardware_concurrency());
+    c.physicsMs = calibrate_physics();
+    c.particlesUs = calibrate_particles();
+    c.renderMs = renderBench ? renderBench() : -1.0;
+    std::cout << "Calibration: physics " << c.physicsMs << " ms/step, particles " << c.particlesUs << " us/"
+        << CALIBRATION_PARTICLES << ", render " << c.renderMs << " ms, " << c.cores << " cores" << std::endl;
+    return c;
+}
+
+QualityPreset choose_quality_preset(const QualityCalibration& c) {
+    // Walk down from ultra until the estimated cost of the preset's settings fits
+    for (int i = QUALITY_PRESET_COUNT - 1; i > QUALITY_LOW; --i) {
+        const QualitySettings& q = g_qualityPresets[i];
+        double simMs = c.physicsMs * q.subSteps / CALIBRATION_SUB_STEPS +
+            c.particlesUs / 1000.0 * q.maxParticles / CALIBRATION_PARTICLES;
+        double renderMs = c.renderMs < 0.0 ? 0.0 : c.renderMs * q.renderScale * q.renderScale * (1.0 + 0.15 * q.msaaSamples);
+        bool enoughCores = q.workerThreads == 0 ? c.cores >= 4 : c.cores > q.workerThreads;
+        if (simMs <= QUALITY_SIM_BUDGET_MS && renderMs <= QUALITY_RENDER_BUDGET_MS && enoughCores) {
+            return static_cast<QualityPreset>(i);
+        }
+    }
+    return QUALITY_LOW;
+}
+
+// ---------------- Config ----------------
+static bool apply_override(QualitySettings& s, const std::string& key, std::istringstream& in) {
+    if (key == "max_particles") return static_cast<bool>(in >> s.maxParticles) && s.maxParticles >= 0;
+    if (key == "sub_steps") return static_cast<bool>(in >> s.subSteps) && s.subSteps >= 1;
+    if (key == "render_scale") return static_cast<bool>(in >> s.renderScale) && s.renderScale > 0.0f && s.renderScale <= 1.0f;
+    if (key == "msaa") return static_cast<bool>(in >> s.msaaSamples) && s.msaaSamples >= 0;
+    if (key == "workers") return static_cast<bool>(in >> s.workerThreads) && s.workerThreads >= 0;
+    return false;
+}
+
+static bool is_override_key(const std::string& key) {
+    QualitySettings scratch = g_qualityPresets[QUALITY_HIGH];
+    std::istringstream in("1");
+    return apply_override(scratch, key, in);
+}
+
+// The preset line and the override lines, wherever they are in the file
+static bool read_quality_config(const char* path, QualityPreset& preset, bool& calibrated, std::vector<std::string>& lines) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        std::istringstream in(line);
+        std::string key, value;
+        if (!(in >> key)) continue;
+        if (key == "preset") calibrated = (in >> value) && quality_preset_from_name(value.c_str(), preset);
+        else if (key != "calibration") lines.push_back(line);
+    }
+    return true;
+}
+
+static void apply_override_lines(const char* path, const std::vector<std::string>& lines, QualitySettings& settings) {
+    for (const std::string& l : lines) {
+        std::istringstream in(l);
+        std::string key;
+        in >> key;
+        if (!apply_override(settings, key, in)) std::cout << path << ": ignoring \"" << l << "\"" << std::endl;
+    }
+}
+
+bool load_quality_config(const char* path, QualitySettings& settings) {
+    // The preset comes first, wherever its line is, so overrides apply on top of it
+    std::vector<std::string> lines;
+    QualityPreset preset = QUALITY_HIGH;
+    bool calibrated = false;
+    if (!read_quality_config(path, preset, calibrated, lines) || !calibrated) return false;
+
+    settings = g_qualityPresets[preset];
+    apply_override_lines(path, lines, settings);
+    return true;
+}
+
+void apply_quality_overrides(const char* path, QualitySettings& settings) {
+    std::vector<std::string> lines;
+    QualityPreset preset = QUALITY_HIGH;
+    bool calibrated = false;
+    if (read_quality_config(path, preset, calibrated, lines)) apply_override_lines(path, lines, settings);
+}
+
+bool save_quality_config(const char* path, QualityPreset preset, const QualityCalibration& c) {
+    std::vector<std::string> overrides;
+    {
+        std::ifstream old(path);
+        std::string line;
+        while (std::getline(old, line)) {
+            std::istringstream in(line);
+            std::string key;
+            if (in >> key && is_override_key(key)) overrides.push_back(line);
+        }
+    }
+
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cout << "Failed to write " << path << std::endl;
+        return false;
+    }
+    out << "# Written by calibration (run with --calibrate to redo it).\n"
+        << "# Override any preset value below; those lines are kept when calibration runs again:\n"
+        << "#   max_particles <n>  sub_steps <n>  render_scale <0..1>  msaa <samples>  workers <n, 0 = auto>\n"
+        << "preset " << g_qualityPresetNames[preset] << "\n"
+        << "calibration physics_ms " << c.physicsMs << " particles_us " << c.particlesUs
+        << " render_ms " << c.renderMs << " cores " << c.cores << "\n";
+    for (const std::string& line : overrides) out << line << "\n";
+    return true;
+}
+
+void print_quality(const QualitySettings& s) {
+    std::cout << "Quality " << g_qualityPresetNames[s.preset] << ": " << s.maxParticles << " particles, "
+        << s.subSteps << " sub-steps, render scale " << s.renderScale << ", MSAA " << s.msaaSamples << "x, "
+        << (s.workerThreads > 0 ? std::to_string(s.workerThreads) : std::string("auto")) << " workers" << std::endl;
+}
+
+// ---------------- Benchmark ----------------
+void bench_quality_calibration(int runs) {
+    for (int i = 0; i < runs; ++i) {
+        QualityCalibration c = run_quality_calibration(nullptr);
+        print_quality(g_qualityPresets[choose_quality_preset(c)]);
+    }
+}
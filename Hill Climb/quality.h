@@ -0,0 +1,55 @@
+// quality.h
+// Quality presets chosen by a first-run hardware calibration, persisted to quality.cfg with user overrides
+
+#pragma once
+
+enum QualityPreset {
+    QUALITY_LOW,
+    QUALITY_MEDIUM,
+    QUALITY_HIGH,
+    QUALITY_ULTRA,
+    QUALITY_PRESET_COUNT
+};
+
+struct QualitySettings {
+    QualityPreset preset;
+    int maxParticles;
+    int subSteps;         // Box2D sub-steps per 60 Hz step
+    float renderScale;    // Scene resolution relative to the window, upscaled when presented
+    int msaaSamples;      // Multisampled scene target, resolved in a post pass; 0 is off
+    int workerThreads;    // 0: hardware_concurrency - 1
+};
+
+// Microbenchmark results the preset is chosen from
+struct QualityCalibration {
+    double physicsMs;     // One step of the reference box pile at 8 sub-steps
+    double particlesUs;   // One update of 1000 particles
+    double renderMs;      // Reference sprite batch at full resolution, GPU included; < 0 if not measured
+    int cores;
+};
+
+const char* const QUALITY_CONFIG_PATH = "quality.cfg";
+
+extern QualitySettings g_quality;
+
+QualitySettings quality_preset(QualityPreset preset);
+const char* quality_preset_name(QualityPreset preset);
+bool quality_preset_from_name(const char* name, QualityPreset& preset);
+
+// Runs the physics and particle microbenchmarks, and renderBench if given (it needs a GL context)
+QualityCalibration run_quality_calibration(double (*renderBench)());
+// Highest preset whose estimated simulation and render cost fits the frame budget
+QualityPreset choose_quality_preset(const QualityCalibration& calibration);
+
+// Preset line plus override lines ("max_particles 300" etc.), overrides win over the preset.
+// Returns false if there's no config yet, i.e. calibration hasn't run on this machine.
+bool load_quality_config(const char* path, QualitySettings& settings);
+// Only the override lines, on top of settings (e.g. a preset named on the command line)
+void apply_quality_overrides(const char* path, QualitySettings& settings);
+// Writes the calibrated preset and measurements, keeping the user's override lines
+bool save_quality_config(const char* path, QualityPreset preset, const QualityCalibration& calibration);
+
+void print_quality(const QualitySettings& settings);
+
+// Calibration run and the preset it would pick (headless, nothing saved)
+void bench_quality_calibration(int runs);
@@ -0,0 +1,131 @@
+// query_service.cpp
+// Ray, shape-cast and overlap queries queued during the frame and run in parallel after b2World_Step
+
+#include "query_service.h"
+
+#include <vector>
+#include "job_system.h"
+
+enum QueryType { QUERY_RAY, QUERY_SHAPE_CAST, QUERY_OVERLAP_AABB, QUERY_OVERLAP_SHAPE };
+
+struct QueuedQuery {
+    QueryType type;
+    b2QueryFilter filter;
+    b2Vec2 origin;
+    b2Vec2 translation;
+    b2AABB aabb;
+    b2ShapeProxy proxy;
+    b2BodyId ignoreBody;
+    RayQueryResult* rayResult;
+    OverlapQueryResult* overlapResult;
+};
+
+static std::vector<QueuedQuery> g_queries;
+
+const int QUERY_BATCH_SIZE = 32; // Smallest range handed to one worker
+
+// ---------------- Enqueue ----------------
+void query_ray(b2Vec2 origin, b2Vec2 translation, b2QueryFilter filter, RayQueryResult* out) {
+    QueuedQuery q = {};
+    q.type = QUERY_RAY;
+    q.filter = filter;
+    q.origin = origin;
+    q.translation = translation;
+    q.rayResult = out;
+    g_queries.push_back(q);
+}
+
+void query_shape_cast(const b2ShapeProxy& proxy, b2Vec2 translation, b2QueryFilter filter,
+    b2BodyId ignoreBody, RayQueryResult* out) {
+    QueuedQuery q = {};
+    q.type = QUERY_SHAPE_CAST;
+    q.filter = filter;
+    q.proxy = proxy;
+    q.translation = translation;
+    q.ignoreBody = ignoreBody;
+    q.rayResult = out;
+    g_queries.push_back(q);
+}
+
+void query_overlap_aabb(b2AABB box, b2QueryFilter filter, OverlapQueryResult* out) {
+    QueuedQuery q = {};
+    q.type = QUERY_OVERLAP_AABB;
+    q.filter = filter;
+    q.aabb = box;
+    q.overlapResult = out;
+    g_queries.push_back(q);
+}
+
+void query_overlap_shape(const b2ShapeProxy& proxy, b2QueryFilter filter, OverlapQueryResult* out) {
+    QueuedQuery q = {};
+    q.type = QUERY_OVERLAP_SHAPE;
+    q.filter = filter;
+    q.proxy = proxy;
+    q.overlapResult = out;
+    g_queries.push_back(q);
+}
+
+int pending_query_count() {
+    return static_cast<int>(g_queries.size());
+}
+
+// ---------------- Callbacks ----------------
+struct CastContext {
+    b2BodyId ignoreBody;
+    RayQueryResult* result;
+};
+
+static float cast_closest_fcn(b2ShapeId shapeId, b2Vec2 point, b2Vec2 normal, float fraction, void* context) {
+    CastContext* ctx = static_cast<CastContext*>(context);
+    if (B2_IS_NON_NULL(ctx->ignoreBody) && B2_ID_EQUALS(b2Shape_GetBody(shapeId), ctx->ignoreBody)) return -1.0f;
+
+    RayQueryResult* r = ctx->result;
+    r->shapeId = shapeId;
+    r->point = point;
+    r->normal = normal;
+    r->fraction = fraction;
+    r->hit = true;
+    return fraction;
+}
+
+static bool overlap_collect_fcn(b2ShapeId shapeId, void* context) {
+    OverlapQueryResult* r = static_cast<OverlapQueryResult*>(context);
+    if (r->count < r->capacity) r->shapes[r->count] = shapeId;
+    r->count++;
+    return true;
+}
+
+static void run_query(b2WorldId world, const QueuedQuery& q) {
+    switch (q.type) {
+    case QUERY_RAY: {
+        b2RayResult ray = b2World_CastRayClosest(world, q.origin, q.translation, q.filter);
+        *q.rayResult = { ray.shapeId, ray.point, ray.normal, ray.fraction, ray.hit };
+        break;
+    }
+    case QUERY_SHAPE_CAST: {
+        *q.rayResult = { b2_nullShapeId, { 0.0f, 0.0f }, { 0.0f, 0.0f }, 1.0f, false };
+        CastContext ctx = { q.ignoreBody, q.rayResult };
+        b2World_CastShape(world, &q.proxy, q.translation, q.filter, cast_closest_fcn, &ctx);
+        break;
+    }
+    case QUERY_OVERLAP_AABB:
+        q.overlapResult->count = 0;
+        b2World_OverlapAABB(world, q.aabb, q.filter, overlap_collect_fcn, q.overlapResult);
+        break;
+    case QUERY_OVERLAP_SHAPE:
+        q.overlapResult->count = 0;
+        b2World_OverlapShape(world, &q.proxy, q.filter, overlap_collect_fcn, q.overlapResult);
+        break;
+    }
+}
+
+// ---------------- Execute ----------------
+void execute_queries(b2WorldId world) {
+    if (g_queries.empty()) return;
+
+    // The world isn't stepping here, so concurrent read-only queries are safe
+    parallel_for(static_cast<int>(g_queries.size()), QUERY_BATCH_SIZE, [world](int begin, int end) {
+        for (int i = begin; i < end; ++i) run_query(world, g_queries[i]);
+    });
+    g_queries.clear();
+}
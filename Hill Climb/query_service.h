@@ -0,0 +1,35 @@
+// query_service.h
+// Ray, shape-cast and overlap queries queued during the frame and run in parallel after b2World_Step
+
+#pragma once
+
+#include <box2d/box2d.h>
+
+struct RayQueryResult {
+    b2ShapeId shapeId;
+    b2Vec2 point;
+    b2Vec2 normal;
+    float fraction;
+    bool hit;
+};
+
+struct OverlapQueryResult {
+    b2ShapeId* shapes;  // Caller-owned buffer
+    int capacity;
+    int count;          // May exceed capacity; only capacity shapes are written
+};
+
+// Enqueue functions store the output pointer; it must stay valid until execute_queries returns.
+// Results are written by execute_queries, so they are ready after the step that follows the enqueue.
+void query_ray(b2Vec2 origin, b2Vec2 translation, b2QueryFilter filter, RayQueryResult* out);
+// Closest hit of proxy moved by translation, skipping shapes on ignoreBody (may be b2_nullBodyId)
+void query_shape_cast(const b2ShapeProxy& proxy, b2Vec2 translation, b2QueryFilter filter,
+    b2BodyId ignoreBody, RayQueryResult* out);
+void query_overlap_aabb(b2AABB box, b2QueryFilter filter, OverlapQueryResult* out);
+void query_overlap_shape(const b2ShapeProxy& proxy, b2QueryFilter filter, OverlapQueryResult* out);
+
+// Runs everything queued against the (read-only) world on the job system, then clears the queue.
+// Call right after b2World_Step.
+void execute_queries(b2WorldId world);
+
+int pending_query_count();
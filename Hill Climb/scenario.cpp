@@ -0,0 +1,206 @@
+// scenario.cpp
+// Scripted benchmark scenarios: world setup, input/spawn timeline, camera path and metrics read from a text file
+
+#include "scenario.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+static const char* const g_metricNames[METRIC_COUNT] = {
+    "frame_ms", "update_ms", "physics_ms", "render_ms", "particles", "bodies", "contacts", "score"
+};
+
+static const char* const g_keyNames[SCENARIO_KEY_COUNT] = { "left", "right", "jump" };
+
+const char* scenario_metric_name(int metric) {
+    return metric >= 0 && metric < METRIC_COUNT ? g_metricNames[metric] : "?";
+}
+
+static int find_name(const char* const* names, int count, const std::string& name) {
+    for (int i = 0; i < count; ++i) {
+        if (name == names[i]) return i;
+    }
+    return -1;
+}
+
+static int time_to_frame(float seconds) {
+    return static_cast<int>(std::lround(seconds / SCENARIO_TIME_STEP));
+}
+
+// ---------------- Parsing ----------------
+// One statement per line, '#' starts a comment:
+//   name <text>            mode headless|offscreen    duration <s>    warmup <s>
+//   terrain_seed <n>       boxes <n>                  enemies <n>     vehicles <n>
+//   metrics <name>...      output <file.csv>          quality low|medium|high|ultra
+//   camera <time> <x> <y>
+//   at <time> hold|release left|right|jump
+//   at <time> jump | explode | reset
+//   at <time> spawn_boxes <count> <x> <y>
+static bool parse_event(std::istringstream& in, ScenarioEvent& e) {
+    float time;
+    std::string action;
+    if (!(in >> time >> action) || time < 0.0f) return false;
+    e = {};
+    e.frame = time_to_frame(time);
+    if (action == "hold" || action == "release") {
+        std::string key;
+        in >> key;
+        e.type = action == "hold" ? SCENARIO_HOLD : SCENARIO_RELEASE;
+        e.key = find_name(g_keyNames, SCENARIO_KEY_COUNT, key);
+        return e.key >= 0;
+    }
+    if (action == "jump") { e.type = SCENARIO_JUMP; return true; }
+    if (action == "explode") { e.type = SCENARIO_EXPLODE; return true; }
+    if (action == "reset") { e.type = SCENARIO_RESET; return true; }
+    if (action == "spawn_boxes") {
+        e.type = SCENARIO_SPAWN_BOXES;
+        return static_cast<bool>(in >> e.count >> e.position.x >> e.position.y) && e.count > 0;
+    }
+    return false;
+}
+
+static bool parse_line(const std::string& keyword, std::istringstream& in, Scenario& s) {
+    if (keyword == "name") return static_cast<bool>(in >> s.name);
+    if (keyword == "mode") {
+        std::string mode;
+        in >> mode;
+        if (mode == "headless") s.mode = SCENARIO_HEADLESS;
+        else if (mode == "offscreen") s.mode = SCENARIO_OFFSCREEN;
+        else return false;
+        return true;
+    }
+    if (keyword == "duration") return static_cast<bool>(in >> s.duration) && s.duration > 0.0f;
+    if (keyword == "warmup") return static_cast<bool>(in >> s.warmup) && s.warmup >= 0.0f;
+    if (keyword == "terrain_seed") return static_cast<bool>(in >> s.terrainSeed);
+    if (keyword == "boxes") return static_cast<bool>(in >> s.boxes) && s.boxes >= 1;
+    if (keyword == "enemies") return static_cast<bool>(in >> s.enemies) && s.enemies >= 0;
+    if (keyword == "vehicles") return static_cast<bool>(in >> s.vehicles) && s.vehicles >= 1;
+    if (keyword == "output") return static_cast<bool>(in >> s.output);
+    if (keyword == "quality") return static_cast<bool>(in >> s.quality);
+    if (keyword == "metrics") {
+        std::string name;
+        bool any = false;
+        while (in >> name) {
+            int metric = find_name(g_metricNames, METRIC_COUNT, name);
+            if (metric < 0) return false;
+            s.metrics[metric] = any = true;
+        }
+        return any;
+    }
+    if (keyword == "camera") {
+        ScenarioCameraKey key;
+        if (!(in >> key.time >> key.position.x >> key.position.y)) return false;
+        s.camera.push_back(key);
+        return true;
+    }
+    if (keyword == "at") {
+        ScenarioEvent e;
+        if (!parse_event(in, e)) return false;
+        s.events.push_back(e);
+        return true;
+    }
+    return false;
+}
+
+bool load_scenario(const char* path, Scenario& scenario) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cout << "Failed to open scenario: " << path << std::endl;
+        return false;
+    }
+    scenario = Scenario();
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        std::istringstream in(line);
+        std::string keyword;
+        if (!(in >> keyword)) continue;
+        if (!parse_line(keyword, in, scenario)) {
+            std::cout << path << ":" << number << ": bad scenario line: " << line << std::endl;
+            return false;
+        }
+    }
+
+    // Metrics default to the frame breakdown
+    if (std::none_of(scenario.metrics, scenario.metrics + METRIC_COUNT, [](bool m) { return m; })) {
+        scenario.metrics[METRIC_FRAME_MS] = scenario.metrics[METRIC_UPDATE_MS] = scenario.metrics[METRIC_PHYSICS_MS] = true;
+        if (scenario.mode == SCENARIO_OFFSCREEN) scenario.metrics[METRIC_RENDER_MS] = true;
+    }
+    std::stable_sort(scenario.events.begin(), scenario.events.end(),
+        [](const ScenarioEvent& a, const ScenarioEvent& b) { return a.frame < b.frame; });
+    std::stable_sort(scenario.camera.begin(), scenario.camera.end(),
+        [](const ScenarioCameraKey& a, const ScenarioCameraKey& b) { return a.time < b.time; });
+
+    std::cout << "Scenario " << scenario.name << ": " << scenario.duration << " s "
+        << (scenario.mode == SCENARIO_HEADLESS ? "headless" : "offscreen") << ", " << scenario.boxes << " boxes, "
+        << scenario.enemies << " enemies, " << scenario.vehicles << " vehicles, " << scenario.events.size() << " events" << std::endl;
+    return true;
+}
+
+// ---------------- Playback ----------------
+int scenario_frame_count(const Scenario& scenario) {
+    return time_to_frame(scenario.duration);
+}
+
+void scenario_advance(const Scenario& scenario, ScenarioPlayback& playback, std::vector<ScenarioEvent>& events) {
+    events.clear();
+    while (playback.nextEvent < scenario.events.size() && scenario.events[playback.nextEvent].frame <= playback.frame) {
+        const ScenarioEvent& e = scenario.events[playback.nextEvent++];
+        if (e.type == SCENARIO_HOLD) playback.held[e.key] = true;
+        else if (e.type == SCENARIO_RELEASE) playback.held[e.key] = false;
+        else events.push_back(e);
+    }
+    playback.frame++;
+}
+
+b2Vec2 scenario_camera(const Scenario& scenario, float time) {
+    const std::vector<ScenarioCameraKey>& keys = scenario.camera;
+    if (keys.empty()) return { 0.0f, 0.0f };
+    if (time <= keys.front().time) return keys.front().position;
+    for (size_t i = 1; i < keys.size(); ++i) {
+        if (time < keys[i].time) {
+            float t = (time - keys[i - 1].time) / (keys[i].time - keys[i - 1].time);
+            return b2Lerp(keys[i - 1].position, keys[i].position, t);
+        }
+    }
+    return keys.back().position;
+}
+
+// ---------------- Report ----------------
+void scenario_report(const Scenario& scenario, const std::vector<ScenarioSample>& samples) {
+    size_t first = std::min(samples.size(), static_cast<size_t>(time_to_frame(scenario.warmup)));
+    size_t count = samples.size() - first;
+    std::cout << "Scenario " << scenario.name << ": " << count << " frames measured (" << first << " warmup)" << std::endl;
+    if (count == 0) return;
+
+    std::ofstream csv;
+    if (!scenario.output.empty()) {
+        csv.open(scenario.output, std::ios::out | std::ios::trunc);
+        if (csv.is_open()) csv << "scenario,metric,mean,p50,p95,p99,max\n";
+        else std::cout << "Failed to write scenario output: " << scenario.output << std::endl;
+    }
+
+    std::vector<double> values(count);
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        if (!scenario.metrics[m]) continue;
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = samples[first + i].values[m];
+            sum += values[i];
+        }
+        std::sort(values.begin(), values.end());
+        auto pct = [&](double p) { return values[std::min(count - 1, static_cast<size_t>(p * count))]; };
+        double mean = sum / count;
+        std::cout << "  " << g_metricNames[m] << ": mean " << mean << "  p50 " << pct(0.50) << "  p95 " << pct(0.95)
+            << "  p99 " << pct(0.99) << "  max " << values.back() << std::endl;
+        if (csv.is_open()) {
+            csv << scenario.name << ',' << g_metricNames[m] << ',' << mean << ',' << pct(0.50) << ',' << pct(0.95)
+                << ',' << pct(0.99) << ',' << values.back() << '\n';
+        }
+    }
+    if (csv.is_open()) std::cout << "Wrote " << scenario.output << std::endl;
+}
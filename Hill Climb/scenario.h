@@ -0,0 +1,101 @@
+// scenario.h
+// Scripted benchmark scenarios: world setup, input/spawn timeline, camera path and metrics read from a text file
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <box2d/box2d.h>
+
+const float SCENARIO_TIME_STEP = 1.0f / 60.0f;  // Scenarios always run at the fixed step, so runs are comparable
+
+enum ScenarioMode {
+    SCENARIO_HEADLESS,   // Simulation only, no window or GL context
+    SCENARIO_OFFSCREEN   // Full frame including rendering, in a hidden window
+};
+
+enum ScenarioEventType {
+    SCENARIO_HOLD,          // Key down until the matching release
+    SCENARIO_RELEASE,
+    SCENARIO_JUMP,          // One frame of jump, like tapping space
+    SCENARIO_EXPLODE,       // X key: explosion at the player
+    SCENARIO_RESET,         // R key: player back to the spawn
+    SCENARIO_SPAWN_BOXES    // count boxes in a stack above position
+};
+
+enum ScenarioKey {
+    SCENARIO_KEY_LEFT,
+    SCENARIO_KEY_RIGHT,
+    SCENARIO_KEY_JUMP,
+    SCENARIO_KEY_COUNT
+};
+
+enum ScenarioMetric {
+    METRIC_FRAME_MS,
+    METRIC_UPDATE_MS,
+    METRIC_PHYSICS_MS,
+    METRIC_RENDER_MS,
+    METRIC_PARTICLES,
+    METRIC_BODIES,
+    METRIC_CONTACTS,
+    METRIC_SCORE,
+    METRIC_COUNT
+};
+
+struct ScenarioEvent {
+    int frame;
+    ScenarioEventType type;
+    int key;            // SCENARIO_HOLD / SCENARIO_RELEASE
+    int count;          // SCENARIO_SPAWN_BOXES
+    b2Vec2 position;
+};
+
+struct ScenarioCameraKey {
+    float time;
+    b2Vec2 position;    // Meters, the point at the window's center
+};
+
+// Defaults are the interactive game's scene (main runs a default-constructed one without --scenario)
+struct Scenario {
+    std::string name = "default";
+    ScenarioMode mode = SCENARIO_OFFSCREEN;
+    float duration = 10.0f;          // Seconds of simulated time
+    float warmup = 1.0f;             // Seconds left out of the metrics
+    uint32_t terrainSeed = 1234;
+    int boxes = 1;                   // The first one is the scoring box
+    int enemies = 24;
+    int vehicles = 1;                // Player characters, all driven by the scripted input
+    std::string quality;             // Preset name; empty uses quality.cfg like the game does
+    bool metrics[METRIC_COUNT] = {};
+    std::string output;              // Summary CSV, optional
+    std::vector<ScenarioEvent> events;        // Sorted by frame, file order within a frame
+    std::vector<ScenarioCameraKey> camera;    // Sorted by time; empty keeps the camera at the origin
+};
+
+struct ScenarioSample {
+    double values[METRIC_COUNT];
+};
+
+// Input state and event cursor while a scenario plays
+struct ScenarioPlayback {
+    int frame = 0;
+    size_t nextEvent = 0;
+    bool held[SCENARIO_KEY_COUNT] = {};
+};
+
+// Parses a scenario file; reports the line of the first error and returns false
+bool load_scenario(const char* path, Scenario& scenario);
+
+int scenario_frame_count(const Scenario& scenario);
+
+// Events for playback.frame (hold/release are applied to playback.held), then advances the frame
+void scenario_advance(const Scenario& scenario, ScenarioPlayback& playback, std::vector<ScenarioEvent>& events);
+
+// Camera position at time, linear between keys
+b2Vec2 scenario_camera(const Scenario& scenario, float time);
+
+// Mean and percentiles of each requested metric, to stdout and to scenario.output if set
+void scenario_report(const Scenario& scenario, const std::vector<ScenarioSample>& samples);
+
+const char* scenario_metric_name(int metric);
@@ -0,0 +1,206 @@
+// spatial_grid.cpp
+// Uniform spatial hash grid for gameplay entities that aren't Box2D bodies (pickups, triggers, emitters)
+
+#include "spatial_grid.h"
+
+#include <iostream>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+
+const uint32_t GRID_NO_CELL = 0xffffffffu;
+
+static int cell_coord(const SpatialGrid& grid, float v) {
+    return static_cast<int>(floorf(v * grid.invCellSize));
+}
+
+static uint32_t bucket_of(const SpatialGrid& grid, int cx, int cy) {
+    uint32_t h = static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u;
+    return h & grid.cellMask;
+}
+
+void grid_init(SpatialGrid& grid, float cellSize, int bucketCount) {
+    uint32_t buckets = 1;
+    while (buckets < static_cast<uint32_t>(bucketCount)) buckets <<= 1;
+
+    grid.cellSize = cellSize;
+    grid.invCellSize = 1.0f / cellSize;
+    grid.maxHalfExtent = 0.0f;
+    grid.cellMask = buckets - 1;
+    grid.cells.assign(buckets, {});
+    grid.entityCell.clear();
+    grid.entitySlot.clear();
+    grid.freeIds.clear();
+    grid.count = 0;
+}
+
+void grid_clear(SpatialGrid& grid) {
+    for (std::vector<GridEntry>& cell : grid.cells) cell.clear(); // Keeps capacity
+    grid.entityCell.clear();
+    grid.entitySlot.clear();
+    grid.freeIds.clear();
+    grid.maxHalfExtent = 0.0f;
+    grid.count = 0;
+}
+
+// ---------------- Insert / move / remove ----------------
+static void place(SpatialGrid& grid, const GridEntry& entry) {
+    uint32_t bucket = bucket_of(grid, entry.cellX, entry.cellY);
+    std::vector<GridEntry>& cell = grid.cells[bucket];
+    grid.entityCell[entry.id] = bucket;
+    grid.entitySlot[entry.id] = static_cast<uint32_t>(cell.size());
+    cell.push_back(entry);
+}
+
+static GridEntry take(SpatialGrid& grid, int id) {
+    std::vector<GridEntry>& cell = grid.cells[grid.entityCell[id]];
+    uint32_t slot = grid.entitySlot[id];
+    GridEntry entry = cell[slot];
+
+    // Swap-remove, then fix the slot of the entry that moved
+    cell[slot] = cell.back();
+    cell.pop_back();
+    if (slot < cell.size()) grid.entitySlot[cell[slot].id] = slot;
+    grid.entityCell[id] = GRID_NO_CELL;
+    return entry;
+}
+
+int grid_insert(SpatialGrid& grid, b2Vec2 pos, float halfW, float halfH) {
+    int id;
+    if (!grid.freeIds.empty()) {
+        id = grid.freeIds.back();
+        grid.freeIds.pop_back();
+    }
+    else {
+        id = static_cast<int>(grid.entityCell.size());
+        grid.entityCell.push_back(GRID_NO_CELL);
+        grid.entitySlot.push_back(0);
+    }
+
+    GridEntry entry = { id, cell_coord(grid, pos.x), cell_coord(grid, pos.y), pos.x, pos.y, halfW, halfH };
+    place(grid, entry);
+    grid.maxHalfExtent = fmaxf(grid.maxHalfExtent, fmaxf(halfW, halfH));
+    grid.count++;
+    return id;
+}
+
+void grid_move(SpatialGrid& grid, int id, b2Vec2 pos) {
+    GridEntry& current = grid.cells[grid.entityCell[id]][grid.entitySlot[id]];
+    int cx = cell_coord(grid, pos.x);
+    int cy = cell_coord(grid, pos.y);
+    if (cx == current.cellX && cy == current.cellY) {
+        current.x = pos.x;
+        current.y = pos.y;
+        return;
+    }
+
+    GridEntry entry = take(grid, id);
+    entry.cellX = cx;
+    entry.cellY = cy;
+    entry.x = pos.x;
+    entry.y = pos.y;
+    place(grid, entry);
+}
+
+void grid_remove(SpatialGrid& grid, int id) {
+    if (id < 0 || id >= static_cast<int>(grid.entityCell.size()) || grid.entityCell[id] == GRID_NO_CELL) return;
+    take(grid, id);
+    grid.freeIds.push_back(id);
+    grid.count--;
+}
+
+// ---------------- Queries ----------------
+int grid_query_aabb(const SpatialGrid& grid, b2AABB box, std::vector<int>& out) {
+    out.clear();
+    float pad = grid.maxHalfExtent;
+    int x0 = cell_coord(grid, box.lowerBound.x - pad), x1 = cell_coord(grid, box.upperBound.x + pad);
+    int y0 = cell_coord(grid, box.lowerBound.y - pad), y1 = cell_coord(grid, box.upperBound.y + pad);
+
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            for (const GridEntry& e : grid.cells[bucket_of(grid, cx, cy)]) {
+                if (e.cellX != cx || e.cellY != cy) continue;
+                if (e.x + e.halfW < box.lowerBound.x || e.x - e.halfW > box.upperBound.x ||
+                    e.y + e.halfH < box.lowerBound.y || e.y - e.halfH > box.upperBound.y) continue;
+                out.push_back(e.id);
+            }
+        }
+    }
+    return static_cast<int>(out.size());
+}
+
+int grid_query_radius(const SpatialGrid& grid, b2Vec2 center, float radius, std::vector<int>& out) {
+    out.clear();
+    float pad = radius + grid.maxHalfExtent;
+    int x0 = cell_coord(grid, center.x - pad), x1 = cell_coord(grid, center.x + pad);
+    int y0 = cell_coord(grid, center.y - pad), y1 = cell_coord(grid, center.y + pad);
+    float r2 = radius * radius;
+
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            for (const GridEntry& e : grid.cells[bucket_of(grid, cx, cy)]) {
+                if (e.cellX != cx || e.cellY != cy) continue;
+                // Distance from the circle centre to the entity's box
+                float dx = fmaxf(fabsf(center.x - e.x) - e.halfW, 0.0f);
+                float dy = fmaxf(fabsf(center.y - e.y) - e.halfH, 0.0f);
+                if (dx * dx + dy * dy <= r2) out.push_back(e.id);
+            }
+        }
+    }
+    return static_cast<int>(out.size());
+}
+
+// ---------------- Benchmark ----------------
+void bench_spatial_grid(int count) {
+    const float worldSize = 1000.0f;
+    const float queryRadius = 3.0f;
+    const int queries = 1000;
+
+    auto random01 = []() { return static_cast<float>(rand()) / RAND_MAX; };
+    std::vector<b2Vec2> positions(count);
+    for (b2Vec2& p : positions) p = { random01() * worldSize, random01() * worldSize };
+
+    SpatialGrid grid;
+    grid_init(grid, 4.0f, count);
+    std::vector<int> ids(count);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < count; ++i) ids[i] = grid_insert(grid, positions[i], 0.25f, 0.25f);
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    // One frame of small moves for every entity
+    for (int i = 0; i < count; ++i) {
+        positions[i].x += (random01() - 0.5f) * 0.5f;
+        positions[i].y += (random01() - 0.5f) * 0.5f;
+        grid_move(grid, ids[i], positions[i]);
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    std::vector<int> out;
+    long long gridHits = 0;
+    for (int q = 0; q < queries; ++q) {
+        gridHits += grid_query_radius(grid, positions[q % count], queryRadius, out);
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    long long bruteHits = 0;
+    for (int q = 0; q < queries; ++q) {
+        b2Vec2 c = positions[q % count];
+        for (int i = 0; i < count; ++i) {
+            float dx = fmaxf(fabsf(c.x - positions[i].x) - 0.25f, 0.0f);
+            float dy = fmaxf(fabsf(c.y - positions[i].y) - 0.25f, 0.0f);
+            if (dx * dx + dy * dy <= queryRadius * queryRadius) bruteHits++;
+        }
+    }
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    auto us = [](std::chrono::high_resolution_clock::duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    };
+    std::cout << "Spatial grid: " << count << " entities, " << queries << " radius queries" << std::endl;
+    std::cout << "  insert all:   " << us(t1 - t0) / 1000.0 << " ms" << std::endl;
+    std::cout << "  move all:     " << us(t2 - t1) / 1000.0 << " ms" << std::endl;
+    std::cout << "  grid query:   " << us(t3 - t2) / queries << " us/query (" << gridHits << " hits)" << std::endl;
+    std::cout << "  brute force:  " << us(t4 - t3) / queries << " us/query (" << bruteHits << " hits)" << std::endl;
+    std::cout << "  hits " << (gridHits == bruteHits ? "match" : "DIFFER: the grid query is missing or adding entities") << std::endl;
+}
@@ -0,0 +1,45 @@
+// spatial_grid.h
+// Uniform spatial hash grid for gameplay entities that aren't Box2D bodies (pickups, triggers, emitters)
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <box2d/box2d.h>
+
+struct GridEntry {
+    int id;
+    int cellX, cellY;     // Real cell, so entries from other cells sharing a hash bucket are skipped
+    float x, y;
+    float halfW, halfH;
+};
+
+// Entries are stored by value in their cell, so queries walk contiguous memory
+struct SpatialGrid {
+    float cellSize;
+    float invCellSize;
+    float maxHalfExtent;  // Queries are widened by this so entities overlapping a neighbour cell are found
+    uint32_t cellMask;
+    std::vector<std::vector<GridEntry>> cells;
+    std::vector<uint32_t> entityCell;  // id -> bucket, UINT32_MAX when the id is free
+    std::vector<uint32_t> entitySlot;  // id -> index in its bucket
+    std::vector<int> freeIds;
+    int count;
+};
+
+// bucketCount is rounded up to a power of two; about one bucket per expected entity is plenty
+void grid_init(SpatialGrid& grid, float cellSize, int bucketCount);
+void grid_clear(SpatialGrid& grid);
+
+// Returns the entity id (ids of removed entities are reused)
+int grid_insert(SpatialGrid& grid, b2Vec2 pos, float halfW, float halfH);
+// Only touches bucket arrays when the entity crosses into another cell
+void grid_move(SpatialGrid& grid, int id, b2Vec2 pos);
+void grid_remove(SpatialGrid& grid, int id);
+
+// Ids of entities whose box overlaps the query; out is cleared first and reused between calls
+int grid_query_aabb(const SpatialGrid& grid, b2AABB box, std::vector<int>& out);
+int grid_query_radius(const SpatialGrid& grid, b2Vec2 center, float radius, std::vector<int>& out);
+
+// Compares grid queries with brute force (headless)
+void bench_spatial_grid(int count);
@@ -0,0 +1,249 @@
+// system_scheduler.cpp
+// Gameplay systems with declared read/write data, run as a per-frame dependency DAG on the job pool, with critical-path reporting
+
+#include "system_scheduler.h"
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+
+#include "job_system.h"
+#include "profiler.h"
+
+void scheduler_begin_frame(SystemScheduler& scheduler) {
+    scheduler.systems.clear();
+}
+
+void scheduler_add(SystemScheduler& scheduler, const char* name, uint32_t reads, uint32_t writes,
+    std::function<void()> run, bool mainThread) {
+    scheduler.systems.push_back({ name, reads, writes, mainThread, std::move(run) });
+}
+
+void scheduler_add(SystemScheduler& scheduler, GameSystemId id, std::function<void()> run) {
+    static_assert(g_gameSystems[SYSTEM_FALL_CHECK].id == SYSTEM_FALL_CHECK, "game system table is out of GameSystemId order");
+    const GameSystemDecl& decl = g_gameSystems[id];
+    scheduler_add(scheduler, decl.name, decl.reads, decl.writes, std::move(run), decl.mainThread);
+}
+
+static bool systems_conflict(const GameSystem& a, const GameSystem& b) {
+    return (a.writes & (b.reads | b.writes)) != 0 || (b.writes & a.reads) != 0;
+}
+
+// ---------------- Execution ----------------
+struct SchedulerRun {
+    SystemScheduler* scheduler;
+    std::vector<std::vector<int>> dependents;
+    std::unique_ptr<std::atomic<int>[]> remaining;   // Unfinished dependencies per system
+    std::atomic<int> finished{ 0 };
+    std::mutex mainMutex;
+    std::vector<int> mainReady;                     // Ready main-thread systems, picked up by scheduler_run
+    JobCounter jobs;
+};
+
+static void launch_system(SchedulerRun& run, int index);
+
+static void execute_system(SchedulerRun& run, int index) {
+    GameSystem& system = run.scheduler->systems[index];
+    SystemTiming& timing = run.scheduler->timings[index];
+    timing.start = profiler_now_us();
+    {
+        ProfileScope scope(system.name);
+        system.run();
+    }
+    timing.end = profiler_now_us();
+
+    for (int d : run.dependents[index]) {
+        if (run.remaining[d].fetch_sub(1, std::memory_order_acq_rel) == 1) launch_system(run, d);
+    }
+    run.finished.fetch_add(1, std::memory_order_release);
+}
+
+static void launch_system(SchedulerRun& run, int index) {
+    if (run.scheduler->systems[index].mainThread) {
+        std::lock_guard<std::mutex> lock(run.mainMutex);
+        run.mainReady.push_back(index);
+        return;
+    }
+    job_run(run.jobs, [&run, index] { execute_system(run, index); });
+}
+
+void scheduler_run(SystemScheduler& s) {
+    int count = static_cast<int>(s.systems.size());
+    s.timings.assign(count, { 0.0, 0.0 });
+    s.dependencies.assign(count, {});
+    for (int j = 0; j < count; ++j) {
+        for (int i = 0; i < j; ++i) {
+            if (systems_conflict(s.systems[i], s.systems[j])) s.dependencies[j].push_back(i);
+        }
+    }
+
+    s.frameStart = profiler_now_us();
+    if (s.serial) {
+        for (int i = 0; i < count; ++i) {
+            s.timings[i].start = profiler_now_us();
+            ProfileScope scope(s.systems[i].name);
+            s.systems[i].run();
+            s.timings[i].end = profiler_now_us();
+        }
+    }
+    else {
+        SchedulerRun run;
+        run.scheduler = &s;
+        run.dependents.assign(count, {});
+        run.remaining.reset(new std::atomic<int>[count]);
+        for (int j = 0; j < count; ++j) {
+            run.remaining[j].store(static_cast<int>(s.dependencies[j].size()), std::memory_order_relaxed);
+            for (int i : s.dependencies[j]) run.dependents[i].push_back(j);
+        }
+        for (int j = 0; j < count; ++j) {
+            if (s.dependencies[j].empty()) launch_system(run, j);
+        }
+        // Main-thread systems as they become ready; otherwise help the workers
+        while (run.finished.load(std::memory_order_acquire) < count) {
+            int next = -1;
+            {
+                std::lock_guard<std::mutex> lock(run.mainMutex);
+                if (!run.mainReady.empty()) {
+                    next = run.mainReady.back();
+                    run.mainReady.pop_back();
+                }
+            }
+            if (next >= 0) execute_system(run, next);
+            else if (!job_try_execute()) std::this_thread::yield();
+        }
+        job_wait(run.jobs); // The last job may still be returning
+    }
+    s.frameEnd = profiler_now_us();
+
+    // Report window sums
+    std::vector<int> path;
+    double criticalMs = scheduler_critical_path(s, path);
+    s.reportFrames++;
+    s.reportElapsedMs += (s.frameEnd - s.frameStart) / 1000.0;
+    s.reportCriticalPathMs += criticalMs;
+    for (int i = 0; i < count; ++i) {
+        size_t n = 0;
+        while (n < s.reportNames.size() && strcmp(s.reportNames[n], s.systems[i].name) != 0) ++n;
+        if (n == s.reportNames.size()) {
+            s.reportNames.push_back(s.systems[i].name);
+            s.reportMs.push_back(0.0);
+            s.reportCriticalFrames.push_back(0);
+        }
+        double ms = (s.timings[i].end - s.timings[i].start) / 1000.0;
+        s.reportMs[n] += ms;
+        s.reportWorkMs += ms;
+        if (std::find(path.begin(), path.end(), i) != path.end()) s.reportCriticalFrames[n]++;
+    }
+}
+
+// ---------------- Reporting ----------------
+double scheduler_critical_path(const SystemScheduler& s, std::vector<int>& path) {
+    path.clear();
+    int count = static_cast<int>(s.timings.size());
+    if (count == 0) return 0.0;
+
+    // Dependencies always point to earlier systems, so insertion order is a topological order
+    std::vector<double> finish(count);
+    std::vector<int> previous(count, -1);
+    int last = 0;
+    for (int i = 0; i < count; ++i) {
+        double before = 0.0;
+        for (int d : s.dependencies[i]) {
+            if (finish[d] > before) {
+                before = finish[d];
+                previous[i] = d;
+            }
+        }
+        finish[i] = before + (s.timings[i].end - s.timings[i].start) / 1000.0;
+        if (finish[i] > finish[last]) last = i;
+    }
+    for (int i = last; i >= 0; i = previous[i]) path.push_back(i);
+    std::reverse(path.begin(), path.end());
+    return finish[last];
+}
+
+void scheduler_print_report(SystemScheduler& s) {
+    if (s.reportFrames == 0) return;
+    double frames = s.reportFrames;
+
+    std::cout << "Systems, per frame over " << s.reportFrames << " frames (" << (s.serial ? "serial" : "parallel")
+        << ", " << job_system_worker_count() << " workers)" << std::endl;
+    std::cout << "  " << std::left << std::setw(18) << "system" << std::right << std::setw(10) << "ms"
+        << std::setw(14) << "critical path" << std::endl;
+    std::cout << std::fixed;
+    for (size_t i = 0; i < s.reportNames.size(); ++i) {
+        std::cout << "  " << std::left << std::setw(18) << s.reportNames[i] << std::right << std::setprecision(3)
+            << std::setw(10) << s.reportMs[i] / frames << std::setprecision(0)
+            << std::setw(13) << 100.0 * s.reportCriticalFrames[i] / frames << "%" << std::endl;
+    }
+    double elapsed = s.reportElapsedMs / frames;
+    double work = s.reportWorkMs / frames;
+    std::cout << std::setprecision(3) << "  elapsed " << elapsed << " ms, work " << work << " ms, critical path "
+        << s.reportCriticalPathMs / frames << " ms, overlap " << std::setprecision(2)
+        << (elapsed > 0.0 ? work / elapsed : 0.0) << "x" << std::endl;
+
+    // The last frame's chain: the systems to make faster for a shorter frame
+    std::vector<int> path;
+    scheduler_critical_path(s, path);
+    std::cout << "  last critical path:";
+    for (size_t i = 0; i < path.size(); ++i) std::cout << (i ? " > " : " ") << s.systems[path[i]].name;
+    std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+
+    s.reportNames.clear();
+    s.reportMs.clear();
+    s.reportCriticalFrames.clear();
+    s.reportElapsedMs = s.reportWorkMs = s.reportCriticalPathMs = 0.0;
+    s.reportFrames = 0;
+}
+
+// ---------------- Benchmark ----------------
+static void spin_us(double us) {
+    double end = profiler_now_us() + us;
+    while (profiler_now_us() < end) {}
+}
+
+// The game's systems from g_gameSystems, each spinning for a typical cost
+static void add_bench_systems(SystemScheduler& s) {
+    static const double costUs[GAME_SYSTEM_COUNT] = {
+        50,     // input
+        400,    // enemy ai
+        200,    // controllers
+        2500,   // physics
+        200,    // queries
+        150,    // contact events
+        900,    // particles
+        100,    // popups
+        100,    // proximity
+        200,    // coins
+        300,    // animation
+        300,    // terrain
+        50,     // fall check
+    };
+    for (int i = 0; i < GAME_SYSTEM_COUNT; ++i) {
+        double us = costUs[i];
+        scheduler_add(s, static_cast<GameSystemId>(i), [us] { spin_us(us); });
+    }
+}
+
+void bench_system_scheduler(int frames) {
+    bool ownPool = job_system_worker_count() == 0;
+    if (ownPool) job_system_init();
+
+    SystemScheduler scheduler;
+    for (bool serial : { true, false }) {
+        scheduler.serial = serial;
+        for (int f = 0; f < frames; ++f) {
+            scheduler_begin_frame(scheduler);
+            add_bench_systems(scheduler);
+            scheduler_run(scheduler);
+        }
+        scheduler_print_report(scheduler);
+    }
+
+    if (ownPool) job_system_shutdown();
+}
@@ -0,0 +1,123 @@
+// system_scheduler.h
+// Gameplay systems with declared read/write data, run as a per-frame dependency DAG on the job pool, with critical-path reporting
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+
+// Data a system touches. Two systems conflict if either writes something the other reads or
+// writes; conflicting systems run in the order they were added, everything else may overlap.
+enum SystemData : uint32_t {
+    DATA_INPUT        = 1u << 0,   // Key state, scenario playback
+    DATA_PHYSICS      = 1u << 1,   // The Box2D world: any body read, write or step
+    DATA_CONTROLLERS  = 1u << 2,
+    DATA_ENEMIES      = 1u << 3,
+    DATA_QUERIES      = 1u << 4,   // Batched world queries and their results
+    DATA_PARTICLES    = 1u << 5,
+    DATA_POPUPS       = 1u << 6,
+    DATA_SCORE        = 1u << 7,
+    DATA_TRIGGERS     = 1u << 8,   // Trigger grid and the proximity result
+    DATA_BOX_VISUAL   = 1u << 9,   // Scoring box color and pulse animation
+    DATA_COINS        = 1u << 10,
+    DATA_TERRAIN      = 1u << 11,
+    DATA_LAYER_EVENTS = 1u << 12,  // Collision layer statistics
+};
+
+// The game's systems in frame order. Their data lives in one table so the game and the benchmark
+// can't drift apart; add_update_systems (main.cpp) supplies the bodies.
+enum GameSystemId {
+    SYSTEM_INPUT,
+    SYSTEM_ENEMY_AI,
+    SYSTEM_CONTROLLERS,
+    SYSTEM_PHYSICS,
+    SYSTEM_QUERIES,
+    SYSTEM_CONTACT_EVENTS,
+    SYSTEM_PARTICLES,
+    SYSTEM_POPUPS,
+    SYSTEM_PROXIMITY,
+    SYSTEM_COINS,
+    SYSTEM_ANIMATION,
+    SYSTEM_TERRAIN,
+    SYSTEM_FALL_CHECK,
+    GAME_SYSTEM_COUNT
+};
+
+struct GameSystemDecl {
+    GameSystemId id;
+    const char* name;
+    uint32_t reads;
+    uint32_t writes;
+    bool mainThread;
+};
+
+// Anything that reads or moves a body uses DATA_PHYSICS, so those stay in order around the step;
+// particles and popups touch nothing in the world, so they overlap it. Queries write their results
+// into the callers' structs (enemy sight), so they write those too
+inline constexpr GameSystemDecl g_gameSystems[GAME_SYSTEM_COUNT] = {
+    { SYSTEM_INPUT,          "input",          0,             DATA_INPUT | DATA_CONTROLLERS | DATA_PHYSICS | DATA_PARTICLES, true },
+    { SYSTEM_ENEMY_AI,       "enemy ai",       DATA_PHYSICS,  DATA_ENEMIES | DATA_PHYSICS | DATA_QUERIES, false },
+    { SYSTEM_CONTROLLERS,    "controllers",    0,             DATA_CONTROLLERS | DATA_PHYSICS, false },
+    { SYSTEM_PHYSICS,        "physics",        0,             DATA_PHYSICS, false },
+    { SYSTEM_QUERIES,        "queries",        DATA_PHYSICS,  DATA_QUERIES | DATA_ENEMIES, false },
+    { SYSTEM_CONTACT_EVENTS, "contact events", DATA_PHYSICS,  DATA_CONTROLLERS | DATA_LAYER_EVENTS, false },
+    { SYSTEM_PARTICLES,      "particles",      0,             DATA_PARTICLES, false },
+    { SYSTEM_POPUPS,         "popups",         0,             DATA_POPUPS, false },
+    { SYSTEM_PROXIMITY,      "proximity",      DATA_PHYSICS,  DATA_TRIGGERS | DATA_BOX_VISUAL | DATA_SCORE | DATA_POPUPS, false },
+    { SYSTEM_COINS,          "coins",          DATA_PHYSICS,  DATA_COINS | DATA_SCORE | DATA_POPUPS, false },
+    { SYSTEM_ANIMATION,      "animation",      DATA_TRIGGERS, DATA_BOX_VISUAL, false },
+    { SYSTEM_TERRAIN,        "terrain",        DATA_PHYSICS,  DATA_TERRAIN | DATA_COINS | DATA_PHYSICS, false },
+    { SYSTEM_FALL_CHECK,     "fall check",     DATA_PHYSICS,  DATA_PHYSICS | DATA_ENEMIES | DATA_CONTROLLERS, false },
+};
+
+struct GameSystem {
+    const char* name;           // String literal, also the profiler scope
+    uint32_t reads;
+    uint32_t writes;
+    bool mainThread;            // GLFW/GL calls: never handed to a worker
+    std::function<void()> run;
+};
+
+struct SystemTiming {
+    double start;               // Microseconds, profiler clock
+    double end;
+};
+
+struct SystemScheduler {
+    bool serial = false;                         // Run in insertion order on the calling thread (for comparison)
+    std::vector<GameSystem> systems;             // This frame's systems, cleared by scheduler_begin_frame
+    std::vector<std::vector<int>> dependencies;  // Per system, the earlier systems it conflicts with
+    std::vector<SystemTiming> timings;           // Last run
+    double frameStart = 0.0;
+    double frameEnd = 0.0;
+
+    // Sums since the last report, per system name
+    std::vector<const char*> reportNames;
+    std::vector<double> reportMs;
+    std::vector<int> reportCriticalFrames;       // Frames the system was on the critical path
+    double reportElapsedMs = 0.0;
+    double reportWorkMs = 0.0;
+    double reportCriticalPathMs = 0.0;
+    int reportFrames = 0;
+};
+
+void scheduler_begin_frame(SystemScheduler& scheduler);
+void scheduler_add(SystemScheduler& scheduler, const char* name, uint32_t reads, uint32_t writes,
+    std::function<void()> run, bool mainThread = false);
+// One of the game's systems, with the reads, writes and thread from g_gameSystems
+void scheduler_add(SystemScheduler& scheduler, GameSystemId id, std::function<void()> run);
+
+// Builds the DAG from the declared data and runs it: workers take any ready system, the
+// calling thread takes the main-thread ones and helps with the rest. Call from the main thread.
+void scheduler_run(SystemScheduler& scheduler);
+
+// Longest chain of measured durations through the last run's DAG; returns its length in ms
+double scheduler_critical_path(const SystemScheduler& scheduler, std::vector<int>& path);
+
+// Per-system averages since the last report, share of frames on the critical path, and the
+// speedup over running everything in sequence; then starts a new report window
+void scheduler_print_report(SystemScheduler& scheduler);
+
+// Dependency order, parallel overlap and critical path of the game's systems with stand-in costs (headless)
+void bench_system_scheduler(int frames);
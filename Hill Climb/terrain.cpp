@@ -0,0 +1,267 @@
+// terrain.cpp
+// Streamed hill terrain: chain-shape chunks plus a sampled heightfield for O(1) ground queries
+
+#include "terrain.h"
+
+#include <iostream>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <vector>
+#include <cstdlib>
+
+#include "collision_layers.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TERRAIN_SSE2 1
+#endif
+
+static b2WorldId g_terrainWorld;
+static float g_terrainStartX = 0.0f;
+static float g_terrainBaseY = 0.0f;
+static float g_terrainPhase[3];
+static TerrainChunk g_chunks[TERRAIN_MAX_CHUNKS];
+static std::vector<TerrainChunkCallback> g_chunkListeners;
+static uint32_t g_terrainRevision = 0;
+
+const float TERRAIN_RAMP_LENGTH = 20.0f; // Hills fade in over this distance from the start
+
+static uint32_t hash_u32(uint32_t x) {
+    x ^= x >> 16; x *= 0x7feb352dU;
+    x ^= x >> 15; x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// ---------------- Generation ----------------
+float terrain_generate_height(float x) {
+    float d = x - g_terrainStartX;
+    if (d <= 0.0f) return g_terrainBaseY;
+
+    float ramp = fminf(1.0f, d / TERRAIN_RAMP_LENGTH);
+    float hills = 2.5f * sinf(0.09f * d + g_terrainPhase[0])
+        + 1.2f * sinf(0.23f * d + g_terrainPhase[1])
+        + 0.4f * sinf(0.71f * d + g_terrainPhase[2])
+        + 0.02f * d; // Slowly climbing
+    return g_terrainBaseY + ramp * hills;
+}
+
+static void load_chunk(int chunkIndex) {
+    TerrainChunk& c = g_chunks[chunkIndex % TERRAIN_MAX_CHUNKS];
+    c.index = chunkIndex;
+
+    int firstSample = chunkIndex * TERRAIN_CHUNK_SAMPLES;
+    for (int k = 0; k <= TERRAIN_CHUNK_SAMPLES; ++k) {
+        c.heights[k] = terrain_generate_height(g_terrainStartX + (firstSample + k) * TERRAIN_SAMPLE_SPACING);
+    }
+
+    // Chain points run right to left so the one-sided chain faces up. The outer
+    // points are ghost vertices that give smooth collision across chunk seams.
+    b2Vec2 points[TERRAIN_CHUNK_SAMPLES + 3];
+    int n = 0;
+    for (int k = TERRAIN_CHUNK_SAMPLES + 1; k >= -1; --k) {
+        float x = g_terrainStartX + (firstSample + k) * TERRAIN_SAMPLE_SPACING;
+        float h = (k >= 0 && k <= TERRAIN_CHUNK_SAMPLES) ? c.heights[k] : terrain_generate_height(x);
+        points[n++] = { x, h };
+    }
+
+    b2BodyDef bodyDef = b2DefaultBodyDef();
+    bodyDef.type = b2_staticBody;
+    c.body = b2CreateBody(g_terrainWorld, &bodyDef);
+
+    b2ChainDef chainDef = b2DefaultChainDef();
+    chainDef.points = points;
+    chainDef.count = n;
+    chainDef.isLoop = false;
+    chainDef.filter = make_collision_filter(ENTITY_GROUND);
+    c.chain = b2CreateChain(c.body, &chainDef);
+
+    g_terrainRevision++;
+    for (TerrainChunkCallback cb : g_chunkListeners) cb(c, true);
+}
+
+static void unload_chunk(TerrainChunk& c) {
+    if (c.index < 0) return;
+    for (TerrainChunkCallback cb : g_chunkListeners) cb(c, false);
+
+    b2DestroyBody(c.body); // Destroys the chain too
+    c.index = -1;
+    g_terrainRevision++;
+}
+
+void init_terrain(b2WorldId world, uint32_t seed, float startX, float baseY) {
+    g_terrainWorld = world;
+    g_terrainStartX = startX;
+    g_terrainBaseY = baseY;
+    for (int i = 0; i < 3; ++i) {
+        g_terrainPhase[i] = (hash_u32(seed * 3 + i) & 0xffff) / 65535.0f * 6.2831853f;
+    }
+    for (TerrainChunk& c : g_chunks) c.index = -1;
+    g_terrainRevision++;
+}
+
+void shutdown_terrain() {
+    for (TerrainChunk& c : g_chunks) unload_chunk(c);
+    g_chunkListeners.clear();
+}
+
+void terrain_add_chunk_listener(TerrainChunkCallback callback) {
+    g_chunkListeners.push_back(callback);
+}
+
+void update_terrain_streaming(float centerX, float range) {
+    int first = static_cast<int>(floorf((centerX - range - g_terrainStartX) / TERRAIN_CHUNK_WIDTH));
+    int last = static_cast<int>(floorf((centerX + range - g_terrainStartX) / TERRAIN_CHUNK_WIDTH));
+    if (first < 0) first = 0;
+    if (last - first + 1 > TERRAIN_MAX_CHUNKS) last = first + TERRAIN_MAX_CHUNKS - 1;
+    if (last < first) return;
+
+    for (TerrainChunk& c : g_chunks) {
+        if (c.index >= 0 && (c.index < first || c.index > last)) unload_chunk(c);
+    }
+    for (int i = first; i <= last; ++i) {
+        const TerrainChunk& c = g_chunks[i % TERRAIN_MAX_CHUNKS];
+        if (c.index != i) load_chunk(i);
+    }
+}
+
+// ---------------- Queries ----------------
+float terrain_start_x() {
+    return g_terrainStartX;
+}
+
+const TerrainChunk* terrain_get_chunk(int chunkIndex) {
+    if (chunkIndex < 0) return nullptr;
+    const TerrainChunk& c = g_chunks[chunkIndex % TERRAIN_MAX_CHUNKS];
+    return c.index == chunkIndex ? &c : nullptr;
+}
+
+int terrain_loaded_range(int* firstChunk, int* lastChunk) {
+    int count = 0;
+    *firstChunk = std::numeric_limits<int>::max();
+    *lastChunk = -1;
+    for (const TerrainChunk& c : g_chunks) {
+        if (c.index < 0) continue;
+        count++;
+        if (c.index < *firstChunk) *firstChunk = c.index;
+        if (c.index > *lastChunk) *lastChunk = c.index;
+    }
+    return count;
+}
+
+uint32_t terrain_revision() {
+    return g_terrainRevision;
+}
+
+bool terrain_height_at(float x, float* height, b2Vec2* normal) {
+    float t = (x - g_terrainStartX) / TERRAIN_SAMPLE_SPACING;
+    if (t < 0.0f) return false;
+
+    int i = static_cast<int>(t);
+    int chunkIndex = i / TERRAIN_CHUNK_SAMPLES;
+    const TerrainChunk& c = g_chunks[chunkIndex % TERRAIN_MAX_CHUNKS];
+    if (c.index != chunkIndex) return false;
+
+    int local = i - chunkIndex * TERRAIN_CHUNK_SAMPLES;
+    float h0 = c.heights[local];
+    float h1 = c.heights[local + 1];
+    if (height) *height = h0 + (h1 - h0) * (t - i);
+    if (normal) {
+        float dh = h1 - h0;
+        float len = sqrtf(dh * dh + TERRAIN_SAMPLE_SPACING * TERRAIN_SAMPLE_SPACING);
+        *normal = { -dh / len, TERRAIN_SAMPLE_SPACING / len };
+    }
+    return true;
+}
+
+// Heights of the segment containing sample i, NaN if not resident
+static void fetch_segment(int i, float* h0, float* h1) {
+    int chunkIndex = i / TERRAIN_CHUNK_SAMPLES;
+    const TerrainChunk& c = g_chunks[chunkIndex % TERRAIN_MAX_CHUNKS];
+    if (i < 0 || c.index != chunkIndex) {
+        *h0 = *h1 = std::numeric_limits<float>::quiet_NaN();
+        return;
+    }
+    int local = i - chunkIndex * TERRAIN_CHUNK_SAMPLES;
+    *h0 = c.heights[local];
+    *h1 = c.heights[local + 1];
+}
+
+void terrain_sample_heights(const float* xs, float* heights, int count) {
+    const float invSpacing = 1.0f / TERRAIN_SAMPLE_SPACING;
+    int n = 0;
+
+#ifdef TERRAIN_SSE2
+    // Index/fraction math and the lerp run 4-wide; the height fetches are scalar (no gather in SSE2)
+    const __m128 start = _mm_set1_ps(g_terrainStartX);
+    const __m128 inv = _mm_set1_ps(invSpacing);
+    for (; n + 4 <= count; n += 4) {
+        __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(xs + n), start), inv);
+        __m128i idx = _mm_cvttps_epi32(t);
+        __m128 frac = _mm_sub_ps(t, _mm_cvtepi32_ps(idx));
+
+        alignas(16) int i4[4];
+        alignas(16) float h0[4], h1[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(i4), idx);
+        for (int k = 0; k < 4; ++k) fetch_segment(xs[n + k] < g_terrainStartX ? -1 : i4[k], &h0[k], &h1[k]);
+
+        __m128 a = _mm_load_ps(h0);
+        __m128 b = _mm_load_ps(h1);
+        _mm_storeu_ps(heights + n, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), frac)));
+    }
+#endif
+
+    for (; n < count; ++n) {
+        float t = (xs[n] - g_terrainStartX) * invSpacing;
+        int i = t < 0.0f ? -1 : static_cast<int>(t);
+        float h0, h1;
+        fetch_segment(i, &h0, &h1);
+        heights[n] = h0 + (h1 - h0) * (t - i);
+    }
+}
+
+// ---------------- Benchmark ----------------
+void bench_terrain(int count) {
+    b2WorldDef worldDef = b2DefaultWorldDef();
+    b2WorldId world = b2CreateWorld(&worldDef);
+    init_terrain(world, 1234, 0.0f, 0.0f);
+    float center = TERRAIN_MAX_CHUNKS * TERRAIN_CHUNK_WIDTH * 0.5f;
+    update_terrain_streaming(center, center - 0.01f);
+
+    std::vector<float> xs(count), heights(count), batch(count);
+    for (int i = 0; i < count; ++i) {
+        xs[i] = static_cast<float>(rand()) / RAND_MAX * (2.0f * center - 1.0f);
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < count; ++i) terrain_height_at(xs[i], &heights[i], nullptr);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    terrain_sample_heights(xs.data(), batch.data(), count);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    float maxError = 0.0f;
+    int misses = 0;
+    for (int i = 0; i < count; ++i) {
+        b2RayResult ray = b2World_CastRayClosest(world, { xs[i], 1000.0f }, { 0.0f, -2000.0f }, b2DefaultQueryFilter());
+        if (!ray.hit) { misses++; continue; }
+        maxError = fmaxf(maxError, fabsf(ray.point.y - heights[i]));
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    float batchError = 0.0f;
+    for (int i = 0; i < count; ++i) batchError = fmaxf(batchError, fabsf(batch[i] - heights[i]));
+
+    auto ns = [count](std::chrono::high_resolution_clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count() / count;
+    };
+    std::cout << "Terrain queries: " << count << std::endl;
+    std::cout << "  terrain_height_at:      " << ns(t1 - t0) << " ns/query" << std::endl;
+    std::cout << "  terrain_sample_heights: " << ns(t2 - t1) << " ns/query" << std::endl;
+    std::cout << "  b2World_CastRayClosest: " << ns(t3 - t2) << " ns/query" << std::endl;
+    std::cout << "  max error vs ray cast:  " << maxError << " m (" << misses << " misses), batch vs scalar "
+        << batchError << " m" << std::endl;
+
+    shutdown_terrain();
+    b2DestroyWorld(world);
+}
@@ -0,0 +1,47 @@
+// terrain.h
+// Streamed hill terrain: chain-shape chunks plus a sampled heightfield for O(1) ground queries
+
+#pragma once
+
+#include <cstdint>
+#include <box2d/box2d.h>
+
+const float TERRAIN_SAMPLE_SPACING = 0.5f;  // Meters between heightfield samples (= chain vertices)
+const int TERRAIN_CHUNK_SAMPLES = 64;       // Segments per chunk
+const float TERRAIN_CHUNK_WIDTH = TERRAIN_SAMPLE_SPACING * TERRAIN_CHUNK_SAMPLES;
+const int TERRAIN_MAX_CHUNKS = 16;          // Ring of resident chunks
+
+struct TerrainChunk {
+    int index;          // Chunk number counted from the terrain start, -1 when the slot is free
+    b2BodyId body;
+    b2ChainId chain;
+    float heights[TERRAIN_CHUNK_SAMPLES + 1];  // Shared edge sample with the next chunk
+};
+
+typedef void (*TerrainChunkCallback)(const TerrainChunk& chunk, bool loaded);
+
+void init_terrain(b2WorldId world, uint32_t seed, float startX, float baseY);
+void shutdown_terrain();
+
+// Loads chunks within range of centerX and unloads the rest
+void update_terrain_streaming(float centerX, float range);
+
+// Notified after a chunk is created and before it is destroyed
+void terrain_add_chunk_listener(TerrainChunkCallback callback);
+
+// Procedural height (any x, loaded or not)
+float terrain_generate_height(float x);
+
+// O(1) interpolated height/normal from the resident heightfield. False if x isn't loaded.
+bool terrain_height_at(float x, float* height, b2Vec2* normal);
+
+// Batch query; heights for unloaded x are NaN. SIMD on SSE2 targets.
+void terrain_sample_heights(const float* xs, float* heights, int count);
+
+float terrain_start_x();
+int terrain_loaded_range(int* firstChunk, int* lastChunk);  // Returns the resident chunk count
+const TerrainChunk* terrain_get_chunk(int chunkIndex);
+uint32_t terrain_revision();  // Bumped whenever chunks load/unload (for render caches)
+
+// Heightfield vs b2World_CastRayClosest: timings and max error (headless)
+void bench_terrain(int count);
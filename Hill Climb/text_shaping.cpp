@@ -0,0 +1,159 @@
+// text_shaping.cpp
+// Shaped-run cache: glyph codes and kerned pen positions per (font, string), shaped once and reused until evicted
+
+#include "text_shaping.h"
+
+#include <iostream>
+#include <list>
+#include <unordered_map>
+#include <chrono>
+#include <iterator>
+
+struct ShapingFont {
+    std::string name;
+    int pixelSize;
+    int advances[SHAPING_GLYPHS];
+    std::vector<int> kerning;  // Dense SHAPING_GLYPHS^2 table, [left * SHAPING_GLYPHS + right]
+    bool hasKerning;
+};
+
+struct CachedRun {
+    int font;
+    std::string text;
+    ShapedRun run;
+};
+
+// Most recently used at the front; per font maps from string to list node
+static std::vector<ShapingFont> g_shapingFonts;
+static std::list<CachedRun> g_shapedRuns;
+static std::vector<std::unordered_map<std::string, std::list<CachedRun>::iterator>> g_shapedIndex;
+static ShapingStats g_shapingStats = {};
+
+std::vector<CookedKerning> extract_kerning(FT_Face face) {
+    std::vector<CookedKerning> kerning;
+    if (!FT_HAS_KERNING(face)) return kerning;
+    for (int left = 32; left < 127; ++left) {
+        for (int right = 32; right < 127; ++right) {
+            FT_Vector delta;
+            if (FT_Get_Kerning(face, FT_Get_Char_Index(face, left), FT_Get_Char_Index(face, right), FT_KERNING_DEFAULT, &delta) == 0
+                && delta.x != 0) {
+                kerning.push_back({ left, right, static_cast<int32_t>(delta.x) });
+            }
+        }
+    }
+    return kerning;
+}
+
+int shaping_add_font(const char* name, int pixelSize, const int advances[SHAPING_GLYPHS], const std::vector<CookedKerning>& kerning) {
+    ShapingFont font;
+    font.name = name;
+    font.pixelSize = pixelSize;
+    for (int i = 0; i < SHAPING_GLYPHS; ++i) font.advances[i] = advances[i];
+    font.kerning.assign(SHAPING_GLYPHS * SHAPING_GLYPHS, 0);
+    font.hasKerning = false;
+    for (const CookedKerning& k : kerning) {
+        if (k.left < 0 || k.left >= SHAPING_GLYPHS || k.right < 0 || k.right >= SHAPING_GLYPHS) continue;
+        font.kerning[k.left * SHAPING_GLYPHS + k.right] = k.amount;
+        font.hasKerning = true;
+    }
+    g_shapingFonts.push_back(font);
+    g_shapedIndex.emplace_back();
+    std::cout << "Shaping font: " << name << " " << pixelSize << "px, " << kerning.size() << " kerning pairs" << std::endl;
+    return static_cast<int>(g_shapingFonts.size()) - 1;
+}
+
+static void shape_run(const ShapingFont& font, const std::string& text, ShapedRun& run) {
+    run.glyphs.clear();
+    run.glyphs.reserve(text.size());
+    int pen = 0;
+    int prev = -1;
+    for (unsigned char ch : text) {
+        int code = ch < SHAPING_GLYPHS ? ch : '?';
+        if (prev >= 0 && font.hasKerning) pen += font.kerning[prev * SHAPING_GLYPHS + code];
+        run.glyphs.push_back({ code, pen });
+        pen += font.advances[code];
+        prev = code;
+    }
+    run.width = pen;
+}
+
+const ShapedRun& shape_text(int font, const std::string& text) {
+    auto& index = g_shapedIndex[font];
+    auto found = index.find(text);
+    if (found != index.end()) {
+        g_shapingStats.hits++;
+        g_shapedRuns.splice(g_shapedRuns.begin(), g_shapedRuns, found->second);
+        return found->second->run;
+    }
+
+    g_shapingStats.misses++;
+    if (static_cast<int>(g_shapedRuns.size()) >= SHAPING_CACHE_CAPACITY) {
+        // Reuse the evicted node, and its glyph storage, for the new run
+        CachedRun& oldest = g_shapedRuns.back();
+        g_shapedIndex[oldest.font].erase(oldest.text);
+        g_shapedRuns.splice(g_shapedRuns.begin(), g_shapedRuns, std::prev(g_shapedRuns.end()));
+        g_shapingStats.evictions++;
+    }
+    else {
+        g_shapedRuns.emplace_front();
+    }
+    CachedRun& entry = g_shapedRuns.front();
+    entry.font = font;
+    entry.text = text;
+    shape_run(g_shapingFonts[font], text, entry.run);
+    index[text] = g_shapedRuns.begin();
+    return entry.run;
+}
+
+void shaping_clear() {
+    g_shapedRuns.clear();
+    for (auto& index : g_shapedIndex) index.clear();
+}
+
+ShapingStats shaping_stats() {
+    ShapingStats stats = g_shapingStats;
+    stats.cachedRuns = static_cast<int>(g_shapedRuns.size());
+    return stats;
+}
+
+// ---------------- Benchmark ----------------
+void bench_text_shaping(int count) {
+    // Synthetic monospace-ish font with a few classic kerning pairs
+    int advances[SHAPING_GLYPHS];
+    for (int i = 0; i < SHAPING_GLYPHS; ++i) advances[i] = (12 + i % 7) * 64;
+    std::vector<CookedKerning> kerning = { { 'A', 'V', -128 }, { 'V', 'A', -128 }, { 'T', 'o', -96 }, { 'o', 'r', -32 }, { 'S', 'c', -64 } };
+    int font = shaping_add_font("bench", 30, advances, kerning);
+
+    // A HUD's worth of strings: score, stats labels and popups, repeated every frame
+    std::vector<std::string> labels;
+    for (int i = 0; i < 16; ++i) labels.push_back("Score:" + std::to_string(i * 125));
+    labels.push_back("AVATAR");
+    labels.push_back("Total Score");
+    for (int i = 0; i < 8; ++i) labels.push_back("+" + std::to_string(5 * (i + 1)));
+
+    ShapedRun scratch;
+    long long checksum = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < count; ++frame) {
+        for (const std::string& s : labels) {
+            shape_run(g_shapingFonts[font], s, scratch);
+            checksum += scratch.width;
+        }
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < count; ++frame) {
+        for (const std::string& s : labels) checksum -= shape_text(font, s).width;
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    auto ns = [&](std::chrono::high_resolution_clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count() / (static_cast<double>(count) * labels.size());
+    };
+    ShapingStats stats = shaping_stats();
+    std::cout << "Text shaping: " << labels.size() << " strings x " << count << " frames" << std::endl;
+    std::cout << "  shape every frame: " << ns(t1 - t0) << " ns/string" << std::endl;
+    std::cout << "  cached runs:       " << ns(t2 - t1) << " ns/string (" << stats.hits << " hits, " << stats.misses << " misses)" << std::endl;
+    std::cout << "  widths " << (checksum == 0 ? "match" : "DIFFER") << ", AV kerned " << shape_text(font, "AV").width / 64
+        << "px vs " << (advances['A'] + advances['V']) / 64 << "px unkerned" << std::endl;
+    shaping_clear();
+}
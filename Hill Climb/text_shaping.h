@@ -0,0 +1,49 @@
+// text_shaping.h
+// Shaped-run cache: glyph codes and kerned pen positions per (font, string), shaped once and reused until evicted
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "cooked_asset.h"
+
+const int TEXT_PIXEL_SIZE = 30;          // Size the HUD font is rasterized at, in the game and by Asset Cook
+const int SHAPING_CACHE_CAPACITY = 512;  // Runs across all fonts, least recently used evicted first
+const int SHAPING_GLYPHS = 128;          // ASCII, same set the glyph textures cover
+
+struct ShapedGlyph {
+    int code;  // Character code, indexes the glyph textures
+    int x;     // Pen position in 1/64 pixels at the font's size
+};
+
+struct ShapedRun {
+    std::vector<ShapedGlyph> glyphs;
+    int width;  // 1/64 pixels, advance of the whole run
+};
+
+struct ShapingStats {
+    long long hits;
+    long long misses;
+    long long evictions;
+    int cachedRuns;
+};
+
+// A shaping font is one face at one pixel size; returns the id passed to shape_text.
+// advances are in 1/64 pixels (FreeType's advance.x), indexed by character code.
+int shaping_add_font(const char* name, int pixelSize, const int advances[SHAPING_GLYPHS], const std::vector<CookedKerning>& kerning);
+
+// Nonzero kerning of every printable ASCII pair, at the face's current pixel size
+std::vector<CookedKerning> extract_kerning(FT_Face face);
+
+// Cached run for text; the reference stays valid until the next shape_text call
+const ShapedRun& shape_text(int font, const std::string& text);
+
+void shaping_clear();
+ShapingStats shaping_stats();
+
+// Per-frame shaping of HUD-style strings: uncached vs cache hits (headless)
+void bench_text_shaping(int count);
@@ -0,0 +1,401 @@
+// thread_config.cpp
+// CPU topology detection, thread pinning, priorities and SCHED_FIFO for the main and worker threads, plus a jitter benchmark
+
+#include "thread_config.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "job_system.h"
+#include "async_io.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+// ---------------- Topology ----------------
+bool parse_cpu_list(const char* text, std::vector<int>& cpus) {
+    cpus.clear();
+    std::stringstream in(text);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        int first, last;
+        char dash;
+        std::istringstream r(range);
+        if (!(r >> first)) return false;
+        last = first;
+        if (r >> dash) {
+            if (dash != '-' || !(r >> last) || last < first) return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return true;
+}
+
+#ifdef __linux__
+static bool read_sys_int(const std::string& path, int& value) {
+    std::ifstream file(path);
+    return static_cast<bool>(file >> value);
+}
+#endif
+
+CpuTopology detect_cpu_topology() {
+    CpuTopology topology;
+#ifdef __linux__
+    std::vector<int> isolated;
+    {
+        std::ifstream file("/sys/devices/system/cpu/isolated");
+        std::string list;
+        if (std::getline(file, list)) parse_cpu_list(list.c_str(), isolated);
+    }
+    std::map<std::pair<int, int>, int> coreIds;   // (package, core_id) -> dense core index
+    for (int cpu = 0; ; ++cpu) {
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        int core, package, online = 1;
+        if (!read_sys_int(dir + "/topology/core_id", core)) {
+            // Offline CPUs have no topology directory but later ones may still exist
+            std::ifstream probe(dir + "/online");
+            if (probe.is_open()) continue;
+            break;
+        }
+        read_sys_int(dir + "/online", online);
+        if (!online) continue;
+        if (!read_sys_int(dir + "/topology/physical_package_id", package)) package = 0;
+        auto key = std::make_pair(package, core);
+        if (!coreIds.count(key)) coreIds[key] = static_cast<int>(coreIds.size());
+        bool isIsolated = std::find(isolated.begin(), isolated.end(), cpu) != isolated.end();
+        topology.cpus.push_back({ cpu, coreIds[key], package, isIsolated });
+    }
+#elif defined(_WIN32)
+    DWORD bytes = 0;
+    GetLogicalProcessorInformation(nullptr, &bytes);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(bytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (!info.empty() && GetLogicalProcessorInformation(info.data(), &bytes)) {
+        std::map<int, int> packageOf;
+        int package = 0;
+        for (const auto& entry : info) {
+            if (entry.Relationship != RelationProcessorPackage) continue;
+            for (int cpu = 0; cpu < 64; ++cpu) {
+                if (entry.ProcessorMask & (1ull << cpu)) packageOf[cpu] = package;
+            }
+            package++;
+        }
+        int core = 0;
+        for (const auto& entry : info) {
+            if (entry.Relationship != RelationProcessorCore) continue;
+            for (int cpu = 0; cpu < 64; ++cpu) {
+                if (entry.ProcessorMask & (1ull << cpu)) topology.cpus.push_back({ cpu, core, packageOf[cpu], false });
+            }
+            core++;
+        }
+        std::sort(topology.cpus.begin(), topology.cpus.end(), [](const CpuInfo& a, const CpuInfo& b) { return a.cpu < b.cpu; });
+    }
+#endif
+    if (topology.cpus.empty()) {
+        // Unknown layout: every logical CPU is its own core
+        int count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        for (int cpu = 0; cpu < count; ++cpu) topology.cpus.push_back({ cpu, cpu, 0, false });
+    }
+
+    std::set<int> cores, packages;
+    for (const CpuInfo& c : topology.cpus) {
+        cores.insert(c.core);
+        packages.insert(c.package);
+    }
+    topology.cores = static_cast<int>(cores.size());
+    topology.packages = static_cast<int>(packages.size());
+    return topology;
+}
+
+void print_cpu_topology(const CpuTopology& topology) {
+    std::cout << "CPU topology: " << topology.cpus.size() << " logical CPUs, " << topology.cores << " cores, "
+        << topology.packages << " packages" << std::endl;
+    for (const CpuInfo& c : topology.cpus) {
+        std::cout << "  cpu " << c.cpu << ": core " << c.core << ", package " << c.package
+            << (c.isolated ? ", isolated" : "") << std::endl;
+    }
+}
+
+ThreadConfig plan_thread_config(const CpuTopology& topology) {
+    ThreadConfig config;
+    config.enabled = true;
+
+    // Isolated CPUs first: nothing else gets scheduled there unless asked
+    const CpuInfo* main = nullptr;
+    for (const CpuInfo& c : topology.cpus) {
+        if (c.isolated) { main = &c; break; }
+    }
+    if (!main) main = &topology.cpus.front();
+    config.mainCpu = main->cpu;
+
+    // One logical CPU per remaining core; isolated CPUs stay reserved unless they're all there is
+    std::set<int> usedCores = { main->core };
+    for (int pass = 0; pass < 2 && config.workerCpus.empty(); ++pass) {
+        for (const CpuInfo& c : topology.cpus) {
+            if (usedCores.count(c.core) || (c.isolated && pass == 0)) continue;
+            usedCores.insert(c.core);
+            config.workerCpus.push_back(c.cpu);
+        }
+    }
+    return config;
+}
+
+// ---------------- Thread Settings ----------------
+#ifndef _WIN32
+static bool pin_current_thread_set(const std::vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+#else
+static bool pin_current_thread_set(const std::vector<int>& cpus) {
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu < 64) mask |= DWORD_PTR(1) << cpu;
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+#endif
+
+bool pin_current_thread(int cpu) {
+    return pin_current_thread_set({ cpu });
+}
+
+bool set_current_thread_priority(ThreadPriority priority) {
+#ifdef _WIN32
+    int levels[] = { THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_ABOVE_NORMAL };
+    return SetThreadPriority(GetCurrentThread(), levels[priority]) != 0;
+#elif defined(__linux__)
+    // Nice values are per thread on Linux; raising priority needs CAP_SYS_NICE or an RLIMIT_NICE allowance
+    int nice[] = { 10, 0, -5 };
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), nice[priority]) == 0;
+#else
+    (void)priority;
+    return false;
+#endif
+}
+
+bool set_current_thread_realtime(bool realtime) {
+#ifdef _WIN32
+    return SetThreadPriority(GetCurrentThread(), realtime ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_NORMAL) != 0;
+#else
+    // Low FIFO priority: above every normal thread, below kernel threads that must not be starved
+    sched_param param = {};
+    param.sched_priority = realtime ? sched_get_priority_min(SCHED_FIFO) + 9 : 0;
+    return pthread_setschedparam(pthread_self(), realtime ? SCHED_FIFO : SCHED_OTHER, &param) == 0;
+#endif
+}
+
+static ThreadConfig g_threadConfig;
+static std::vector<int> g_floatingCpus;    // Where unpinned threads may run
+
+// New threads inherit the creating thread's affinity and scheduling policy, so a pinned or
+// SCHED_FIFO main thread would pass both on to every pool thread unless they're taken back
+static void release_main_settings() {
+    if (g_threadConfig.mainCpu >= 0) pin_current_thread_set(g_floatingCpus);
+    if (g_threadConfig.realtimeMain) set_current_thread_realtime(false);
+}
+
+// The main thread yields while it waits for jobs, and a yield never hands the CPU to a
+// SCHED_OTHER thread: a worker sharing the main thread's CPU would never get to finish
+static bool realtime_main_allowed(const ThreadConfig& config) {
+    if (config.mainCpu < 0 || config.workerCpus.empty()) return false;
+    for (int cpu : config.workerCpus) {
+        if (cpu == config.mainCpu) return false;
+    }
+    return true;
+}
+
+static void configure_worker(int workerIndex) {
+    release_main_settings();
+    if (!g_threadConfig.workerCpus.empty()) {
+        int cpu = g_threadConfig.workerCpus[(workerIndex - 1) % g_threadConfig.workerCpus.size()];
+        if (!pin_current_thread(cpu)) std::cout << "Worker " << workerIndex << ": pinning to cpu " << cpu << " failed" << std::endl;
+    }
+    if (g_threadConfig.workerPriority != THREAD_PRIO_NORMAL) set_current_thread_priority(g_threadConfig.workerPriority);
+}
+
+void apply_background_thread_config() {
+    release_main_settings();
+}
+
+void apply_thread_config(const ThreadConfig& config) {
+    if (!config.enabled) return;
+    g_threadConfig = config;
+    if (config.realtimeMain && !realtime_main_allowed(config)) g_threadConfig.realtimeMain = false;
+    // With a SCHED_FIFO main thread, I/O and trace threads keep off its CPU as well
+    g_floatingCpus.clear();
+    for (const CpuInfo& c : detect_cpu_topology().cpus) {
+        if (!g_threadConfig.realtimeMain || c.cpu != config.mainCpu) g_floatingCpus.push_back(c.cpu);
+    }
+
+    std::cout << "Threads: main";
+    if (config.mainCpu >= 0) {
+        std::cout << (pin_current_thread(config.mainCpu) ? " on cpu " : " (pinning failed) cpu ") << config.mainCpu;
+    }
+    if (config.realtimeMain && !g_threadConfig.realtimeMain) {
+        std::cout << ", SCHED_FIFO refused (needs workers pinned to other CPUs than main)";
+    }
+    else if (config.realtimeMain && !set_current_thread_realtime(true)) {
+        g_threadConfig.realtimeMain = false;
+        std::cout << ", SCHED_FIFO not permitted";
+    }
+    else if (config.realtimeMain) {
+        std::cout << ", SCHED_FIFO";
+    }
+    std::cout << "; workers on";
+    for (int cpu : config.workerCpus) std::cout << " " << cpu;
+    if (config.workerCpus.empty()) std::cout << " any cpu";
+    std::cout << std::endl;
+
+    job_system_set_thread_start(configure_worker);
+    async_io_set_thread_start(apply_background_thread_config);
+}
+
+// ---------------- Benchmark ----------------
+struct JitterStats {
+    double meanMs;
+    double stddevMs;
+    double p99Ms;
+    double maxLateMs;
+};
+
+// Fixed amount of work, so preemption shows up as a longer frame (a clock-driven spin would hide it)
+static double busy_work(long long iterations) {
+    double x = 1.0;
+    for (long long i = 0; i < iterations; ++i) x = x * 1.0000001 + 1e-9;
+    return x;
+}
+
+static JitterStats run_jitter_loop(int frames, long long workIterations) {
+    using clock = std::chrono::steady_clock;
+    const auto period = std::chrono::microseconds(16667);
+    std::vector<double> intervals;
+    intervals.reserve(frames);
+    double maxLate = 0.0;
+    volatile double sink = 0.0;
+
+    auto deadline = clock::now();
+    auto previous = deadline;
+    for (int f = 0; f <= frames; ++f) {
+        auto start = clock::now();
+        if (f > 0) {
+            intervals.push_back(std::chrono::duration<double, std::milli>(start - previous).count());
+            maxLate = std::max(maxLate, std::chrono::duration<double, std::milli>(start - deadline).count());
+        }
+        previous = start;
+        sink = sink + busy_work(workIterations);
+        deadline += period;
+        std::this_thread::sleep_until(deadline);
+    }
+
+    JitterStats s = {};
+    double sum = 0.0, sq = 0.0;
+    for (double ms : intervals) { sum += ms; sq += ms * ms; }
+    s.meanMs = sum / intervals.size();
+    s.stddevMs = std::sqrt(std::max(0.0, sq / intervals.size() - s.meanMs * s.meanMs));
+    std::sort(intervals.begin(), intervals.end());
+    s.p99Ms = intervals[std::min(intervals.size() - 1, static_cast<size_t>(intervals.size() * 0.99))];
+    s.maxLateMs = maxLate;
+    return s;
+}
+
+void bench_frame_jitter(int frames) {
+    CpuTopology topology = detect_cpu_topology();
+    print_cpu_topology(topology);
+    ThreadConfig plan = plan_thread_config(topology);
+    std::vector<int> allCpus, otherCpus;
+    // The main core's SMT siblings count as the main core: the load stays off them too
+    int mainCore = 0;
+    for (const CpuInfo& c : topology.cpus) {
+        allCpus.push_back(c.cpu);
+        if (c.cpu == plan.mainCpu) mainCore = c.core;
+    }
+    for (const CpuInfo& c : topology.cpus) {
+        if (c.core != mainCore) otherCpus.push_back(c.cpu);
+    }
+
+    // About 4 ms of work per frame on this machine
+    auto t0 = std::chrono::steady_clock::now();
+    volatile double sink = busy_work(10000000);
+    double msPer10M = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    long long workIterations = static_cast<long long>(10000000 * 4.0 / std::max(0.01, msPer10M));
+    (void)sink;
+
+    // Background load: one spinning thread per logical CPU, like a build running next to the game
+    std::atomic<bool> stop{ false };
+    std::atomic<bool> confine{ false };
+    std::atomic<int> confineGeneration{ 0 };
+    std::vector<std::thread> load;
+    for (size_t i = 0; i < allCpus.size(); ++i) {
+        load.emplace_back([&]() {
+            int seen = 0;
+            double x = 1.0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                int generation = confineGeneration.load();
+                if (generation != seen) {
+                    seen = generation;
+                    pin_current_thread_set(confine && !otherCpus.empty() ? otherCpus : allCpus);
+                }
+                for (int k = 0; k < 100000; ++k) x = x * 1.0000001 + 1e-9;
+            }
+            volatile double keep = x;
+            (void)keep;
+        });
+    }
+
+    auto report = [&](const char* name, const JitterStats& s) {
+        std::cout << "  " << name << ": mean " << s.meanMs << " ms, stddev " << s.stddevMs << " ms, p99 " << s.p99Ms
+            << " ms, worst late " << s.maxLateMs << " ms" << std::endl;
+    };
+    std::cout << "Frame jitter: " << frames << " frames at 60 Hz, ~4 ms work each, " << load.size() << " load threads" << std::endl;
+
+    report("floating          ", run_jitter_loop(frames, workIterations));
+
+    bool pinned = pin_current_thread(plan.mainCpu);
+    report(pinned ? "pinned            " : "pinned (failed)   ", run_jitter_loop(frames, workIterations));
+
+    if (!otherCpus.empty()) {
+        confine = true;
+        confineGeneration++;
+        report("pinned + isolated ", run_jitter_loop(frames, workIterations));
+    }
+    else {
+        std::cout << "  single core: no CPU to move the load to, isolation skipped" << std::endl;
+    }
+    if (set_current_thread_realtime(true)) {
+        report(otherCpus.empty() ? "pinned + FIFO     " : "isolated + FIFO   ", run_jitter_loop(frames, workIterations));
+        set_current_thread_realtime(false);
+    }
+    else {
+        std::cout << "  SCHED_FIFO not permitted (needs CAP_SYS_NICE or an rtprio limit)" << std::endl;
+    }
+
+    stop = true;
+    for (std::thread& t : load) t.join();
+    pin_current_thread_set(allCpus);
+}
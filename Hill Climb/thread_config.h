@@ -0,0 +1,60 @@
+// thread_config.h
+// CPU topology detection, thread pinning, priorities and SCHED_FIFO for the main and worker threads, plus a jitter benchmark
+
+#pragma once
+
+#include <vector>
+
+struct CpuInfo {
+    int cpu;        // Logical CPU number, as used for affinity
+    int core;       // Physical core, unique across packages; SMT siblings share it
+    int package;
+    bool isolated;  // Kept away from the scheduler (isolcpus=) and free for pinning
+};
+
+struct CpuTopology {
+    std::vector<CpuInfo> cpus;
+    int cores = 0;
+    int packages = 0;
+};
+
+enum ThreadPriority {
+    THREAD_PRIO_LOW,
+    THREAD_PRIO_NORMAL,
+    THREAD_PRIO_HIGH
+};
+
+// The simulation and render work share the main thread, so one pin covers both
+struct ThreadConfig {
+    bool enabled = false;
+    int mainCpu = -1;                   // -1 leaves the main thread floating
+    std::vector<int> workerCpus;        // Workers take these round-robin; empty leaves them floating
+    ThreadPriority workerPriority = THREAD_PRIO_NORMAL;
+    bool realtimeMain = false;          // SCHED_FIFO (Linux) / time-critical priority (Windows) where permitted;
+                                        // only with mainCpu set and workerCpus all elsewhere
+};
+
+// Linux: /sys/devices/system/cpu/cpu*/topology and /sys/devices/system/cpu/isolated
+CpuTopology detect_cpu_topology();
+void print_cpu_topology(const CpuTopology& topology);
+
+// Main thread on a physical core of its own (an isolated one if there are any), workers on one
+// logical CPU of every other core, so no worker shares the main thread's core through SMT
+ThreadConfig plan_thread_config(const CpuTopology& topology);
+
+// "0-3,6" -> { 0, 1, 2, 3, 6 }
+bool parse_cpu_list(const char* text, std::vector<int>& cpus);
+
+bool pin_current_thread(int cpu);
+bool set_current_thread_priority(ThreadPriority priority);
+bool set_current_thread_realtime(bool realtime);
+
+// Applies the main thread's settings now and the workers' and I/O threads' as they start, undoing
+// the affinity and policy they inherit from the main thread; call before job_system_init and async_io_init
+void apply_thread_config(const ThreadConfig& config);
+// For other threads the main thread starts (I/O, trace writing): floating, normal scheduling
+void apply_background_thread_config();
+
+// Frame-time jitter of a fixed 60 Hz loop under background load: floating, pinned,
+// pinned with the load kept off the main core, and with SCHED_FIFO if allowed (headless)
+void bench_frame_jitter(int frames);
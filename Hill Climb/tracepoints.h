@@ -0,0 +1,35 @@
+// tracepoints.h
+// USDT static probes (provider "hillclimb") for bpftrace/perf/SystemTap; a single nop each, nothing at all without <sys/sdt.h>
+//
+// Probes and arguments (durations in microseconds, strings as char*):
+//   frame_begin(frame)                      frame_end(frame, duration)
+//   physics_step_begin(subSteps)            physics_step_end(duration, contacts)
+//   particle_spawn(count, live)             particle_update_begin(live) / particle_update_end(live)
+//   texture_load_begin(path)                texture_load_end(path, width, height, cooked)
+//   text_render(text, length)               score(points, total)
+//
+// Arguments are values the code already has, so a disabled probe costs one nop and no extra work.
+// Durations that aren't measured anyway are left to begin/end pairs, e.g.
+//   bpftrace -e 'usdt:./Hill\ Climb:hillclimb:frame_end { @ms = hist(arg1 / 1000); }'
+//   bpftrace -e 'usdt:./Hill\ Climb:hillclimb:texture_load_begin { @t[tid] = nsecs; }
+//                usdt:./Hill\ Climb:hillclimb:texture_load_end /@t[tid]/ { printf("%s %d us\n", str(arg0), (nsecs - @t[tid]) / 1000); }'
+
+#pragma once
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TRACEPOINTS_ENABLED 1
+#endif
+#endif
+
+#ifdef TRACEPOINTS_ENABLED
+#define TRACE_PROBE1(name, a) DTRACE_PROBE1(hillclimb, name, a)
+#define TRACE_PROBE2(name, a, b) DTRACE_PROBE2(hillclimb, name, a, b)
+#define TRACE_PROBE4(name, a, b, c, d) DTRACE_PROBE4(hillclimb, name, a, b, c, d)
+#else
+// sizeof keeps the arguments unevaluated but still counts as a use (no unused-variable warnings)
+#define TRACE_PROBE1(name, a) ((void)sizeof(a))
+#define TRACE_PROBE2(name, a, b) ((void)sizeof(a), (void)sizeof(b))
+#define TRACE_PROBE4(name, a, b, c, d) ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c), (void)sizeof(d))
+#endif
@@ -0,0 +1,166 @@
+// ui_layer.cpp
+// Retained HUD widgets: content changes mark their rectangles dirty, so the cached UI texture is only partly redrawn
+
+#include "ui_layer.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+
+static std::vector<UiWidget> g_uiWidgets;
+static std::vector<UiRect> g_uiDirty;
+static UiLayerStats g_uiStats;
+
+static bool rects_overlap(const UiRect& a, const UiRect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static UiRect rect_union(const UiRect& a, const UiRect& b) {
+    int x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+    int x1 = std::max(a.x + a.width, b.x + b.width), y1 = std::max(a.y + a.height, b.y + b.height);
+    return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+int ui_add_widget(const char* name, UiRect rect, std::function<void(const UiWidget& widget)> draw) {
+    g_uiWidgets.push_back({ name, rect, std::string(), true, std::move(draw) });
+    g_uiDirty.push_back(rect);
+    return static_cast<int>(g_uiWidgets.size()) - 1;
+}
+
+void ui_clear_widgets() {
+    g_uiWidgets.clear();
+    g_uiDirty.clear();
+}
+
+const UiWidget& ui_widget(int widget) {
+    return g_uiWidgets[widget];
+}
+
+void ui_set_content(int widget, const std::string& content) {
+    UiWidget& w = g_uiWidgets[widget];
+    if (w.content == content) return;
+    w.content = content;
+    if (w.visible) g_uiDirty.push_back(w.rect);
+}
+
+void ui_set_visible(int widget, bool visible) {
+    UiWidget& w = g_uiWidgets[widget];
+    if (w.visible == visible) return;
+    w.visible = visible;
+    g_uiDirty.push_back(w.rect);
+}
+
+void ui_invalidate() {
+    g_uiDirty.clear();
+    for (const UiWidget& w : g_uiWidgets) g_uiDirty.push_back(w.rect);
+}
+
+void ui_take_dirty_regions(int width, int height, std::vector<UiRect>& regions) {
+    regions.clear();
+    for (UiRect r : g_uiDirty) {
+        // Clip to the layer
+        int x1 = std::min(r.x + r.width, width), y1 = std::min(r.y + r.height, height);
+        r.x = std::max(r.x, 0);
+        r.y = std::max(r.y, 0);
+        r.width = x1 - r.x;
+        r.height = y1 - r.y;
+        if (r.width <= 0 || r.height <= 0) continue;
+
+        // Merge until nothing overlaps, so no pixel is cleared and redrawn twice
+        for (size_t i = 0; i < regions.size();) {
+            if (rects_overlap(regions[i], r)) {
+                r = rect_union(regions[i], r);
+                regions[i] = regions.back();
+                regions.pop_back();
+                i = 0;
+            }
+            else {
+                ++i;
+            }
+        }
+        regions.push_back(r);
+    }
+    g_uiDirty.clear();
+}
+
+void ui_widgets_in(const UiRect& region, std::vector<const UiWidget*>& widgets) {
+    widgets.clear();
+    for (const UiWidget& w : g_uiWidgets) {
+        if (w.visible && rects_overlap(w.rect, region)) widgets.push_back(&w);
+    }
+}
+
+// ---------------- Stats ----------------
+static bool g_uiRedrawnThisFrame = false;
+
+void ui_record_redraw(const UiRect& region, int widgetDraws, int glyphs) {
+    g_uiStats.regions++;
+    g_uiStats.widgetDraws += widgetDraws;
+    g_uiStats.pixels += static_cast<long long>(region.width) * region.height;
+    g_uiStats.glyphsDrawn += glyphs;
+    g_uiRedrawnThisFrame = true;
+}
+
+void ui_end_frame() {
+    g_uiStats.frames++;
+    if (g_uiRedrawnThisFrame) g_uiStats.redrawFrames++;
+    g_uiRedrawnThisFrame = false;
+    for (const UiWidget& w : g_uiWidgets) {
+        if (w.visible) g_uiStats.glyphsShown += static_cast<long long>(w.content.size());
+    }
+}
+
+const UiLayerStats& ui_layer_stats() {
+    return g_uiStats;
+}
+
+void print_ui_layer_stats() {
+    const UiLayerStats& s = g_uiStats;
+    if (s.frames == 0) return;
+    double frames = static_cast<double>(s.frames);
+    std::cout << std::fixed << std::setprecision(1) << "UI layer: redrawn in " << 100.0 * s.redrawFrames / frames << "% of " << s.frames << " frames, "
+        << s.regions / frames << " regions and " << s.pixels / frames << " pixels per frame, "
+        << s.glyphsDrawn / frames << " glyphs per frame redrawn vs " << s.glyphsShown / frames
+        << " shown (an immediate HUD draws all of them every frame)"
+        << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+// ---------------- Benchmark ----------------
+void bench_ui_layer(int frames) {
+    // Widgets like the game's HUD: score changes on pickups, speed a few times a second, the
+    // stats overlay every frame while it's open
+    ui_clear_widgets();
+    g_uiStats = UiLayerStats();
+    auto noDraw = [](const UiWidget&) {};
+    int score = ui_add_widget("score", { 10, 550, 300, 45 }, noDraw);
+    int speed = ui_add_widget("speed", { 650, 550, 140, 30 }, noDraw);
+    int stats = ui_add_widget("stats", { 10, 380, 380, 160 }, noDraw);
+
+    const int width = 800, height = 600;
+    std::vector<UiRect> regions;
+    std::vector<const UiWidget*> widgets;
+    int points = 0;
+    for (int f = 0; f < frames; ++f) {
+        if (f % 90 == 0) points += 10;
+        char text[64];
+        snprintf(text, sizeof(text), "Score:%d", points);
+        ui_set_content(score, text);
+        snprintf(text, sizeof(text), "%d km/h", 40 + (f / 20) % 7);
+        ui_set_content(speed, text);
+        ui_set_visible(stats, (f / 600) % 2 == 1);
+        snprintf(text, sizeof(text), "frame %.2fms", 8.0 + (f % 5) * 0.01);
+        ui_set_content(stats, text);
+
+        ui_take_dirty_regions(width, height, regions);
+        for (const UiRect& region : regions) {
+            ui_widgets_in(region, widgets);
+            int glyphs = 0;
+            for (const UiWidget* w : widgets) glyphs += static_cast<int>(w->content.size());
+            ui_record_redraw(region, static_cast<int>(widgets.size()), glyphs);
+        }
+        ui_end_frame();
+    }
+    print_ui_layer_stats();
+    ui_clear_widgets();
+}
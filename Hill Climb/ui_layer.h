@@ -0,0 +1,56 @@
+// ui_layer.h
+// Retained HUD widgets: content changes mark their rectangles dirty, so the cached UI texture is only partly redrawn
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+// Window pixels, origin bottom-left like GL (and render_text)
+struct UiRect {
+    int x, y;
+    int width, height;
+};
+
+struct UiWidget {
+    const char* name;
+    UiRect rect;                // Everything the widget draws stays inside; it's the area cleared on redraw
+    std::string content;        // What the widget shows; only a change of it redraws the widget
+    bool visible;
+    std::function<void(const UiWidget& widget)> draw;
+};
+
+struct UiLayerStats {
+    long long frames = 0;
+    long long redrawFrames = 0;     // Frames that touched the cached texture at all
+    long long regions = 0;          // Dirty regions cleared and redrawn
+    long long widgetDraws = 0;
+    long long pixels = 0;           // Area of the redrawn regions
+    long long glyphsDrawn = 0;      // Characters of content redrawn (each one a text quad, two with the shadow)
+    long long glyphsShown = 0;      // Characters on screen, what an immediate-mode HUD draws every frame
+};
+
+int ui_add_widget(const char* name, UiRect rect, std::function<void(const UiWidget& widget)> draw);
+void ui_clear_widgets();
+const UiWidget& ui_widget(int widget);
+
+// Marks the widget's rectangle dirty only if the content or visibility actually changed
+void ui_set_content(int widget, const std::string& content);
+void ui_set_visible(int widget, bool visible);
+// Whole layer, e.g. once the texture is (re)created
+void ui_invalidate();
+
+// This frame's dirty regions, overlapping ones merged, clipped to width x height; clears the dirty list
+void ui_take_dirty_regions(int width, int height, std::vector<UiRect>& regions);
+// Visible widgets overlapping region, in the order they were added (later ones draw on top)
+void ui_widgets_in(const UiRect& region, std::vector<const UiWidget*>& widgets);
+
+// Counted by the renderer as it redraws; ui_end_frame closes the frame's counts
+void ui_record_redraw(const UiRect& region, int widgetDraws, int glyphs);
+void ui_end_frame();
+const UiLayerStats& ui_layer_stats();
+void print_ui_layer_stats();
+
+// Dirty-region behaviour of a HUD over a simulated run, against redrawing it every frame (headless)
+void bench_ui_layer(int frames);